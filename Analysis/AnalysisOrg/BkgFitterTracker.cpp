@@ -461,7 +461,7 @@ void BkgFitterTracker::ThreadedInitialization (
 
 
     // now put me on the queue
-    CpuQueueControl.CreateItemAndAssignItemToQueue((void *) &linfo[r]);
+    CpuQueueControl.CreateItemAndAssignItemToQueue((void *) &linfo[r], r);
     //analysis_queue.item.finished = false;
     //analysis_queue.item.private_data = (void *) &linfo[r];
     //analysis_queue.GetCpuQueue()->PutItem (analysis_queue.item);
@@ -524,10 +524,19 @@ void BkgFitterTracker::ExecuteFitForFlow (
     //analysis_queue.item.finished = false;
     //analysis_queue.item.private_data = (void *) &bkinfo[r];
     //AssignQueueForItem (analysis_queue,analysis_compute_plan);
-    CpuQueueControl.CreateItemAndAssignItemToQueue((void *) &bkinfo[r]);
+    // keep each region on the same worker from flow to flow, idle workers steal
+    CpuQueueControl.CreateItemAndAssignItemToQueue((void *) &bkinfo[r], region_order[r].first);
   }
 
   CpuQueueControl.WaitForRegionsToFinishProcessing();
+
+  if (inception_state != NULL &&
+      (last || flow + 1 == inception_state->bkg_control.signal_chunks.flow_block_sequence.BlockAtFlow(flow)->end()))
+  {
+    char label[64];
+    snprintf(label, sizeof(label), "BkgWorkers flow %d", flow);
+    CpuQueueControl.LogQueueStats(label);
+  }
   //WaitForRegionsToFinishProcessing (analysis_queue,analysis_compute_plan);
 }
 
@@ -333,6 +333,10 @@ ValidateOpts::ValidateOpts()
 	m_opts["hilowfilter"] = VT_INT;
 	m_opts["total-timeout"] = VT_BOOL;
 	m_opts["readaheaddat"] = VT_INT;
+	m_opts["readahead-max-dat"] = VT_INT;
+	m_opts["readahead-mem-mb"] = VT_INT;
+	m_opts["img-load-threads"] = VT_INT;
+	m_opts["img-decode-threads"] = VT_INT;
 	m_opts["readaheadDat"] = VT_INT;
 	m_opts["no-threaded-file-access"] = VT_BOOL;
 	m_opts["f"] = VT_INT;
@@ -426,6 +430,7 @@ ValidateOpts::ValidateOpts()
 	// ProcessImageToWell
 	m_opts["region-list"] = VT_VECTOR_INT;
 	m_opts["wells-save-queue-size"] = VT_VECTOR_INT;
+	m_opts["wells-save-threads"] = VT_INT;
     m_opts["wells-save-as-ushort"] = VT_BOOL;
     m_opts["wells-convert-low"] = VT_FLOAT;
     m_opts["wells-convert-high"] = VT_FLOAT;
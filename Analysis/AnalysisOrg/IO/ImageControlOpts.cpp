@@ -7,6 +7,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include "Utils.h"
+#include "deInterlace.h"
 
 using namespace std;
 
@@ -42,6 +43,10 @@ void ImageControlOpts::DefaultImageOpts()
   threaded_file_access = true;
   PCATest[0]=0;
   readaheadDat = 0;
+  readaheadMaxDat = 0;
+  readaheadMemMb = 0;
+  imageLoadThreads = 0;
+  imageDecodeThreads = 0;
 }
 
 ImageControlOpts::~ImageControlOpts()
@@ -74,6 +79,10 @@ void ImageControlOpts::PrintHelp()
     printf ("     --total-timeout         INT               total timeout [0]\n");
     printf ("     --readaheaddat          INT               setup readaheadDat [0]\n");
     printf ("     --readaheadDat          INT               same as readaheaddat [0]\n");
+    printf ("     --readahead-max-dat     INT               max adaptive readaheadDat, 0 for twice the start value [0]\n");
+    printf ("     --readahead-mem-mb      INT               memory cap for images read ahead, 0 for a quarter of system memory [0]\n");
+    printf ("     --img-load-threads      INT               DAT decode threads, 0 for numCores/4 with a minimum of 4 [0]\n");
+    printf ("     --img-decode-threads    INT               threads decoding each compressed DAT, 0 for up to 4 [0]\n");
     printf ("     --pair-xtalk-coeff      FLOAT             setup pair xtalk fraction [0.0]\n");
     printf ("     --col-flicker-correct   BOOL              enable col flicker correction [true for Proton; false for PGM]\n");
     printf ("     --col-flicker-correct-aggressive    BOOL  enable col flicker correction aggressive [true for Proton; false for PGM]\n");
@@ -157,6 +166,11 @@ void ImageControlOpts::SetOpts(OptArgs &opts, Json::Value& json_params)
 	hilowPixFilter = RetrieveParameterBool(opts, json_params, '-', "hilowfilter", false);
 	total_timeout = RetrieveParameterInt(opts, json_params, '-', "total-timeout", 0);
 	readaheadDat = RetrieveParameterInt(opts, json_params, '-', "readaheaddat", 0);
+	readaheadMaxDat = RetrieveParameterInt(opts, json_params, '-', "readahead-max-dat", 0);
+	readaheadMemMb = RetrieveParameterInt(opts, json_params, '-', "readahead-mem-mb", 0);
+	imageLoadThreads = RetrieveParameterInt(opts, json_params, '-', "img-load-threads", 0);
+	imageDecodeThreads = RetrieveParameterInt(opts, json_params, '-', "img-decode-threads", 0);
+	SetDeInterlaceThreads(imageDecodeThreads);
 	bool no_threaded_file_access = RetrieveParameterBool(opts, json_params, '-', "no-threaded-file-access", false);
 	threaded_file_access = !no_threaded_file_access;
 	//jz the following comes from CommandLineOpts::GetOpts
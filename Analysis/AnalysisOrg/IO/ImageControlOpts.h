@@ -28,6 +28,10 @@ class ImageControlOpts{
   bool col_pair_pixel_xtalk_correct;
   float pair_xtalk_fraction;
   int readaheadDat;  // should this be img_control instead???
+  int readaheadMaxDat; // upper bound for the adaptive read-ahead, 0 = twice the starting read-ahead
+  int readaheadMemMb;  // memory allowed for decoded images in flight, 0 = a quarter of system memory
+  int imageLoadThreads; // DAT decode threads, 0 = numCores()/4 with a minimum of 4
+  int imageDecodeThreads; // threads splitting one compressed DAT by row band, 0 = deInterlace default
   bool fluid_potential_correct;
   float fluid_potential_threshold;
 
@@ -7,10 +7,17 @@ void ImageTracker::WaitForFlowToLoad ( int flow ) // absolute flow value
 {
    int flow_buffer_for_flow = FlowBufferFromFlow(flow);  // temporary while we resolve the confusion of buffers and flows
  // disable compiler optimizing this loop away
+  if ( ( ( int volatile * ) CurRead ) [flow_buffer_for_flow] )
+    return;
+
+  // the fitters are starved, let the loader know so it reads further ahead
+  Timer wait_timer;
   while ( ! ( ( int volatile * ) CurRead ) [flow_buffer_for_flow] ) {
     //sleep ( 1 ); // wait for the load worker to load the current image
     usleep(100);
   }
+  master_img_loader.consumer_wait_sec += wait_timer.elapsed();
+  __sync_fetch_and_add ( &master_img_loader.consumer_stalls, 1 );
 }
 
 void ImageTracker::FireUpThreads()
@@ -170,6 +177,15 @@ void ImageTracker::SetUpImageLoaderInfo (const CommandLineOpts &inception_state,
   
   master_img_loader.finished = false;
   master_img_loader.lead = ( inception_state.img_control.readaheadDat != 0 ) ? inception_state.img_control.readaheadDat : my_image_spec.LeadTimeForChipSize();
+  master_img_loader.max_lead = ( inception_state.img_control.readaheadMaxDat != 0 ) ? inception_state.img_control.readaheadMaxDat : 2 * master_img_loader.lead;
+  master_img_loader.max_lead = std::max ( master_img_loader.max_lead, master_img_loader.lead );
+  if ( inception_state.img_control.readaheadMemMb > 0 )
+    master_img_loader.readahead_mem_cap = ( size_t ) inception_state.img_control.readaheadMemMb * 1024 * 1024;
+  else
+    master_img_loader.readahead_mem_cap = ( size_t ) totalMemOnTorrentServer() * 1024 / 4; // KB
+  master_img_loader.load_threads = inception_state.img_control.imageLoadThreads;
+  master_img_loader.consumer_stalls = 0;
+  master_img_loader.consumer_wait_sec = 0;
   master_img_loader.inception_state = &inception_state;  // why must we pass globals around everywhere?
   
   printf ( "Subtract Empties: %d\n", inception_state.img_control.nn_subtract_empties );
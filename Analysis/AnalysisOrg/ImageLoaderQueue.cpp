@@ -13,12 +13,36 @@
 #include <sys/prctl.h>
 #include "crop/Acq.h"
 
+// shared by the FileLoader thread and its workers
+struct LoaderSharedState
+{
+  pthread_mutex_t lock;
+  pthread_cond_t pinned_cond;
+  int next_pinned_buffer; // buffer whose pinned update is due next
+  size_t image_bytes;     // decoded size of one flow, 0 until the first image is in
+
+  LoaderSharedState()
+  {
+    pthread_mutex_init ( &lock, NULL );
+    pthread_cond_init ( &pinned_cond, NULL );
+    next_pinned_buffer = 0;
+    image_bytes = 0;
+  }
+  ~LoaderSharedState()
+  {
+    pthread_cond_destroy ( &pinned_cond );
+    pthread_mutex_destroy ( &lock );
+  }
+};
+
 typedef struct {
   int threadNum;
   WorkerInfoQueue *wq;
+  LoaderSharedState *shared;
 }WqInfo_t;
 
-void JustLoadOneImageWithPinnedUpdate(ImageLoadWorkInfo *cur_image_loader);
+void JustLoadOneImage(ImageLoadWorkInfo *cur_image_loader);
+void PinnedUpdateInFlowOrder(ImageLoadWorkInfo *cur_image_loader, LoaderSharedState *shared);
 
 // handle our fake mutex flags
 void SetReadCompleted(ImageLoadWorkInfo *one_img_loader)
@@ -33,6 +57,7 @@ void *FileLoadWorker ( void *arg )
   WqInfo_t *wqinfo = (WqInfo_t *)arg;
   int threadNum=wqinfo->threadNum;
   WorkerInfoQueue *q = wqinfo->wq;
+  LoaderSharedState *shared = wqinfo->shared;
   assert ( q );
 
   bool done = false;
@@ -82,6 +107,23 @@ void *FileLoadWorker ( void *arg )
 
       T2=tmr.elapsed();
     }
+    else
+    {
+      // the loader thread has read the file into the page cache, decode it in
+      // parallel with the other workers, but pinned in flow must still be
+      // updated in flow order
+      tmr.restart();
+      JustLoadOneImage ( one_img_loader );
+      T1=tmr.elapsed();
+      tmr.restart();
+      PinnedUpdateInFlowOrder ( one_img_loader, shared );
+      T2=tmr.elapsed();
+    }
+
+    pthread_mutex_lock ( &shared->lock );
+    if ( shared->image_bytes == 0 )
+      shared->image_bytes = ( size_t ) img->raw->rows * img->raw->cols * std::max ( img->raw->frames, img->raw->uncompFrames ) * sizeof ( short );
+    pthread_mutex_unlock ( &shared->lock );
 
     tmr.restart();
 
@@ -363,6 +405,77 @@ void DontReadAheadOfSignalProcessing (  ImageLoadWorkInfo *info, int lead)
     usleep ( 100 );
 }
 
+// Decides how many flows the loader may run ahead of the fitters.  Every time the
+// fitters had to wait on an image the read-ahead grows by one flow, up to max_lead;
+// once they have gone twice the read-ahead without waiting it shrinks back by one
+// towards the configured lead.  It never holds more decoded images than the memory
+// cap allows.
+class ReadAheadPolicy
+{
+  public:
+    ReadAheadPolicy ( const ImageLoadWorkInfo *master )
+    {
+      start_lead = master->lead;
+      lead = master->lead;
+      seen_stalls = 0;
+      quiet_flows = 0;
+      last_reported = -1;
+    }
+
+    int LeadForNextFlow ( const ImageLoadWorkInfo *master, size_t image_bytes )
+    {
+      int stalls = master->consumer_stalls;
+      if ( master->lead < start_lead )
+      {
+        // short on memory (see DecideOnRawDatsToBufferForThisFlowBlock), don't grow
+        lead = master->lead;
+      }
+      else if ( stalls != seen_stalls )
+      {
+        lead = std::min ( lead + 1, master->max_lead );
+        quiet_flows = 0;
+      }
+      else if ( ++quiet_flows > 2 * lead )
+      {
+        lead = std::max ( lead - 1, master->lead );
+        quiet_flows = 0;
+      }
+      seen_stalls = stalls;
+
+      int capped = lead;
+      if ( master->readahead_mem_cap > 0 && image_bytes > 0 )
+        capped = std::min ( capped, ( int ) std::min ( master->readahead_mem_cap / image_bytes, ( size_t ) INT_MAX ) );
+      capped = std::max ( capped, 1 );
+
+      if ( capped != last_reported )
+      {
+        fprintf ( stdout, "FileLoader: read ahead %d flows (fitters waited %d times, %.1f sec)\n",
+                  capped, stalls, master->consumer_wait_sec );
+        last_reported = capped;
+      }
+      return capped;
+    }
+
+  private:
+    int start_lead;
+    int lead;
+    int seen_stalls;
+    int quiet_flows;
+    int last_reported;
+};
+
+// ask the kernel to start reading a DAT that will be decoded soon, files that
+// are not there yet are skipped silently (the acquisition may still be running)
+void PrefetchImageFile ( const ImageLoadWorkInfo *info )
+{
+  int fd = open ( info->name, O_RDONLY );
+  if ( fd >= 0 )
+  {
+    posix_fadvise ( fd, 0, 0, POSIX_FADV_WILLNEED );
+    close ( fd );
+  }
+}
+
 // don't step on the compute intensity that happens every chunk of flows
 void PauseForLongCompute ( int cur_flow,  ImageLoadWorkInfo *info )
 {
@@ -399,13 +512,23 @@ void JustCacheOneImage(ImageLoadWorkInfo *cur_image_loader)
 
 
 
-void JustLoadOneImageWithPinnedUpdate(ImageLoadWorkInfo *cur_image_loader)
+void JustLoadOneImage(ImageLoadWorkInfo *cur_image_loader)
 {
 
   if ( !cur_image_loader->img[cur_image_loader->cur_buffer].LoadRaw ( cur_image_loader->name) )
   {
     exit ( EXIT_FAILURE );
   }
+}
+
+void PinnedUpdateInFlowOrder(ImageLoadWorkInfo *cur_image_loader, LoaderSharedState *shared)
+{
+  // buffers are handed out in flow order and the queue is FIFO, so the worker
+  // holding the previous buffer is never waiting on this one
+  pthread_mutex_lock ( &shared->lock );
+  while ( shared->next_pinned_buffer != cur_image_loader->cur_buffer )
+    pthread_cond_wait ( &shared->pinned_cond, &shared->lock );
+  pthread_mutex_unlock ( &shared->lock );
   //tikSMoother is a no-op if there was no tikSmoothFile entered on command line
   // cur_image_loader->img[cur_image_loader->cur_buffer].SmoothMeTikhonov ( NULL,false,cur_image_loader->name);
   // if gain correction has been calculated, apply it
@@ -416,6 +539,11 @@ void JustLoadOneImageWithPinnedUpdate(ImageLoadWorkInfo *cur_image_loader)
   // pinning updates only need to be complete to remove indeterminacy
   // in values dumped in DumpStep in FileLoadWorker
   cur_image_loader->pinnedInFlow->Update ( cur_image_loader->flow, &cur_image_loader->img[cur_image_loader->cur_buffer],ImageTransformer::gain_correction);
+
+  pthread_mutex_lock ( &shared->lock );
+  shared->next_pinned_buffer++;
+  pthread_cond_broadcast ( &shared->pinned_cond );
+  pthread_mutex_unlock ( &shared->lock );
 }
 
 void *FileLoader ( void *arg )
@@ -433,10 +561,16 @@ void *FileLoader ( void *arg )
 
 
   //   int numWorkers = 1;
-  int numWorkers = numCores() /4; // @TODO - this should be subject to inception_state options
-  numWorkers = ( numWorkers < 4 ? 4:numWorkers );
+  int numWorkers = master_img_loader->load_threads;
+  if ( numWorkers <= 0 )
+  {
+    numWorkers = numCores() /4;
+    numWorkers = ( numWorkers < 4 ? 4:numWorkers );
+  }
   fprintf ( stdout, "FileLoader: numWorkers threads = %d\n", numWorkers );
   WqInfo_t wq_info[numWorkers];
+  LoaderSharedState shared;
+  ReadAheadPolicy read_ahead ( master_img_loader );
 
   {
     int cworker;
@@ -446,6 +580,7 @@ void *FileLoader ( void *arg )
     {
       wq_info[cworker].threadNum=cworker;
       wq_info[cworker].wq = loadWorkQ;
+      wq_info[cworker].shared = &shared;
       int t = pthread_create ( &work_thread, NULL, FileLoadWorker,
                                &wq_info[cworker] );
       pthread_detach(work_thread);
@@ -466,10 +601,18 @@ void *FileLoader ( void *arg )
 
     int cur_flow = cur_image_loader->flow;  // each job is an n_image_loaders item
 
-    DontReadAheadOfSignalProcessing (cur_image_loader, master_img_loader->lead);
-    //***We are doing this on this thread so we >load< in sequential order that pinned in Flow updates in sequential order
-    if (!cur_image_loader->inception_state->img_control.threaded_file_access) {
-      JustLoadOneImageWithPinnedUpdate(cur_image_loader);
+    pthread_mutex_lock ( &shared.lock );
+    size_t image_bytes = shared.image_bytes;
+    pthread_mutex_unlock ( &shared.lock );
+    int lead = read_ahead.LeadForNextFlow ( master_img_loader, image_bytes );
+    DontReadAheadOfSignalProcessing (cur_image_loader, lead);
+    //***Without threaded file access we still read the files on this thread, one at a time in flow order.
+    //***The workers then only decode them out of the page cache and apply the pinned in flow updates in sequential order
+    bool threaded_file_access = cur_image_loader->inception_state->img_control.threaded_file_access;
+    if (!threaded_file_access) {
+      if ( !cur_image_loader->img[cur_image_loader->cur_buffer].WaitForMyFileToWakeMeFromSleep ( cur_image_loader->name ) )
+        exit ( EXIT_FAILURE );
+      JustCacheOneImage(cur_image_loader);
     }
     //*** now we can do the rest of the computation for an image, including dumping in a multiply threaded fashion
 
@@ -477,6 +620,10 @@ void *FileLoader ( void *arg )
     item.private_data = cur_image_loader;
     loadWorkQ->PutItem ( item );
 
+    // get the file of the flow that will be dispatched next time round off the disk
+    if ( threaded_file_access && i_buffer + 1 < flow_buffer_size )
+      PrefetchImageFile ( &n_image_loaders[i_buffer + 1] );
+
     if (!ChipIdDecoder::IsProtonChip())
       PauseForLongCompute ( cur_flow,cur_image_loader );
   }
@@ -485,6 +632,9 @@ void *FileLoader ( void *arg )
   loadWorkQ->WaitTillDone();
   KillQueue ( loadWorkQ,numWorkers );
 
+  fprintf ( stdout, "FileLoader: %d flows loaded, fitters waited %d times (%.1f sec)\n",
+            flow_buffer_size, ( int ) master_img_loader->consumer_stalls, master_img_loader->consumer_wait_sec );
+
   delete loadWorkQ;
   delete[] n_image_loaders;
 
@@ -505,6 +655,7 @@ void *FileSDatLoader ( void *arg )
   int numWorkers = numCores() /2; // @TODO - this should be subject to inception_state options
   numWorkers = ( numWorkers < 1 ? 1:numWorkers );
   fprintf ( stdout, "FileLoader: numWorkers threads = %d\n", numWorkers );
+  ReadAheadPolicy read_ahead ( master_img_loader );
   {
     int cworker;
     pthread_t work_thread;
@@ -526,7 +677,8 @@ void *FileSDatLoader ( void *arg )
     ImageLoadWorkInfo *cur_image_loader = &n_image_loaders[i_buffer];
 
     int cur_flow = cur_image_loader->flow; // each job is an n_image_loaders item
-    DontReadAheadOfSignalProcessing (cur_image_loader, master_img_loader->lead);
+    // sdat chunk sizes vary, so only the flow count limits the read-ahead here
+    DontReadAheadOfSignalProcessing (cur_image_loader, read_ahead.LeadForNextFlow ( master_img_loader, 0 ));
 
 
     //    cur_image_loader->sdat[cur_image_loader->cur_buffer].AdjustForDrift();
@@ -86,7 +86,13 @@ struct ImageLoadWorkInfo
   int numRegions;
   int numFlowsPerCycle;
   int hasWashFlow;
-  int lead;
+  int lead;      // read-ahead in flows we start from and never drop below
+  int max_lead;  // the loader may read further ahead, up to this, while the fitters wait on it
+  size_t readahead_mem_cap; // bytes of decoded images allowed ahead of the fitters, 0 = no cap
+  int load_threads;
+  // written by the consumer in ImageTracker::WaitForFlowToLoad, read by the loader
+  volatile int consumer_stalls;
+  volatile double consumer_wait_sec;
   bool doingSdat;
   bool finished;
   bool doRawBkgSubtract;
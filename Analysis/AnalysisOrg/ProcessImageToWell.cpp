@@ -272,6 +272,7 @@ static void DoThreadedSignalProcessing(
     writerArg.numCols = my_image_spec.cols;
     writerArg.stepSize = stepSize;
     writerArg.saveAsUShort = convert;
+    writerArg.packThreads = RetrieveParameterInt(opts, json_params, '-', "wells-save-threads", 2);
     writerArg.packQueuePtr = &packQueue;
     writerArg.writeQueuePtr = &writeQueue;
 
@@ -484,6 +485,9 @@ static void DoThreadedSignalProcessing(
     my_img_set.FinishFlow ( flow );
   }
 
+  long nuc_rise_hits, nuc_rise_misses;
+  NucStep::GetCacheStats ( nuc_rise_hits, nuc_rise_misses );
+  fprintf ( stdout, "NucStep cache: %ld flow nuc rises reused, %ld computed\n", nuc_rise_hits, nuc_rise_misses );
 
   if(saveCopies)
   {
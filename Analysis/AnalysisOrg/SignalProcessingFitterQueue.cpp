@@ -26,6 +26,9 @@ void *BkgFitWorkerCpu(void *arg)
   ProcessorQueue* pq = static_cast<ProcessorQueue*>(arg);
   assert(pq);
 
+  // bind this thread to its own deque in the cpu queue
+  pq->GetQueue()->RegisterWorker();
+
   WorkerInfoQueue* curQ = NULL;
   bool done = false;
   WorkerInfoQueueItem item;
@@ -476,11 +479,17 @@ void ProcessorQueue::WaitForRegionsToFinishProcessing()
 }
 
 
+void ProcessorQueue::LogQueueStats(const char *label)
+{
+  if (GetQueue())
+    GetQueue()->LogAndResetStats(label);
+}
+
 
 void ProcessorQueue::createWorkQueue(int numRegions)
 {
   if(workQueue == NULL)
-    workQueue = new WorkerInfoQueue(numRegions*getNumWorkers()+1);
+    workQueue = new WorkStealingQueue(getNumWorkers());
 }
 
 void ProcessorQueue::destroyWorkQueue()
@@ -572,10 +581,11 @@ void ProcessorQueue::UnSpinBkgModelThreads ()
 }
 
 
-void ProcessorQueue::CreateItemAndAssignItemToQueue(void * privateData){
+void ProcessorQueue::CreateItemAndAssignItemToQueue(void * privateData, int affinity){
   WorkerInfoQueueItem item;
   item.finished = false;
   item.private_data = privateData;
+  item.affinity = affinity;
   AssignItemToQueue(item);
 }
 
@@ -84,7 +84,7 @@ class ProcessorQueue
 {
 
     //this queue is owned by this class
-    WorkerInfoQueue * workQueue;
+    WorkStealingQueue * workQueue;
 
     //this is just a handle to the gpu queue so jobs can be handed to this queue if needed
     WorkerInfoQueue * gpuQueue;
@@ -145,12 +145,13 @@ public:
 
   void UnSpinBkgModelThreads();
 
-  WorkerInfoQueue* GetQueue() { return workQueue; }
+  WorkStealingQueue* GetQueue() { return workQueue; }
   WorkerInfoQueue* GetGpuQueue() { return gpuQueue; }
 
   void initItem (void * itemData);
 
-  void CreateItemAndAssignItemToQueue(void * itemData);
+  // affinity is a hint for the worker whose deque gets the item, normally the region index
+  void CreateItemAndAssignItemToQueue(void * itemData, int affinity = -1);
 
   void AssignItemToQueue (WorkerInfoQueueItem &item);
   void AssignMultiFLowFitItemToQueue(WorkerInfoQueueItem &item);
@@ -158,6 +159,8 @@ public:
 
   void WaitForRegionsToFinishProcessing ();
 
+  void LogQueueStats(const char *label);
+
   WorkerInfoQueueItem TryGettingFittingJob(WorkerInfoQueue** curQ);
 
 };
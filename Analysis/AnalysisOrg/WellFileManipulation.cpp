@@ -2,6 +2,7 @@
 #include "WellFileManipulation.h"
 #include "Mask.h"
 #include "IonErr.h"
+#include <deque>
 
 using namespace std;
 
@@ -70,6 +71,94 @@ void CreateWellsFileForWriting (RawWells &rawWells, Mask *maskPtr,
   MemUsage ("AfterWells");
 }
 
+// One stepSize x stepSize tile of a flow block, gathered from the chunk
+// buffer and converted to the dataset type, ready for H5Dwrite.
+struct WellsTileBuffer
+{
+  WellChunk chunk;
+  vector<float> values;
+  vector<unsigned short> quantized;
+};
+
+// Shared between the writer thread and its pack threads. Tile buffers are
+// allocated once and recycled through freeBuffers for the whole run.
+struct WellsPackState
+{
+  const ChunkFlowData* chunkData; // flow block being packed, NULL between blocks
+  vector<WellChunk> tiles;
+  size_t nextTile;
+  vector<WellsTileBuffer*> freeBuffers;
+  deque<WellsTileBuffer*> readyBuffers;
+  double packSec;
+  bool saveAsUShort;
+  float lower;
+  float upper;
+  int numCols;
+  bool quit;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+};
+
+static void PackWellsTile(const WellsPackState& state, const ChunkFlowData* chunkData, WellsTileBuffer* tile)
+{
+  const WellChunk& chunk = tile->chunk;
+  size_t flowDepth = chunkData->wellChunk.flowDepth;
+  size_t numValues = chunk.rowHeight * chunk.colWidth * flowDepth;
+  tile->values.resize(numValues);
+  float* dst = &tile->values[0];
+  for ( size_t row = chunk.rowStart; row < chunk.rowStart + chunk.rowHeight; row++ ) {
+    for ( size_t col = chunk.colStart; col < chunk.colStart + chunk.colWidth; col++ ) {
+      int32_t index = chunkData->indexes[row * state.numCols + col];
+      if (index >= 0) {
+        const float* src = chunkData->flowData + ( uint64_t ) index * flowDepth;
+        copy(src, src + flowDepth, dst);
+      }
+      else {
+        // Wells outside the write subset, same as RawWells::At()
+        fill(dst, dst + flowDepth, 0.0f);
+      }
+      dst += flowDepth;
+    }
+  }
+  if (state.saveAsUShort) {
+    WellsConverter converter(state.lower, state.upper);
+    tile->quantized.resize(numValues);
+    for (size_t i = 0; i < numValues; ++i) {
+      tile->quantized[i] = converter.FloatToUInt16(tile->values[i]);
+    }
+  }
+}
+
+static void* PackFlowDataFunc(void* arg0)
+{
+  WellsPackState* state = (WellsPackState*)arg0;
+  pthread_mutex_lock(&state->mutex);
+  while (true) {
+    while (!state->quit && (state->chunkData == NULL || state->nextTile >= state->tiles.size() || state->freeBuffers.empty())) {
+      pthread_cond_wait(&state->cond, &state->mutex);
+    }
+    if (state->quit) {
+      break;
+    }
+    WellsTileBuffer* tile = state->freeBuffers.back();
+    state->freeBuffers.pop_back();
+    tile->chunk = state->tiles[state->nextTile++];
+    const ChunkFlowData* chunkData = state->chunkData;
+    pthread_mutex_unlock(&state->mutex);
+
+    Timer packTimer;
+    PackWellsTile(*state, chunkData, tile);
+    double packSec = packTimer.elapsed();
+
+    pthread_mutex_lock(&state->mutex);
+    state->packSec += packSec;
+    state->readyBuffers.push_back(tile);
+    pthread_cond_broadcast(&state->cond);
+  }
+  pthread_mutex_unlock(&state->mutex);
+  return NULL;
+}
+
 void* WriteFlowDataFunc(void* arg0)
 {
   fprintf ( stdout, "SaveWells: saving thread starts\n");
@@ -102,6 +191,33 @@ void* WriteFlowDataFunc(void* arg0)
 
   RawWellsWriter writer;
 
+  // hdf5 serializes all calls into the library (including the chunk filters
+  // that run inside H5Dwrite), so the pack threads take the gather and the
+  // float to ushort conversion off this thread and it only issues the writes.
+  int packThreads = max(arg->packThreads, 1);
+  WellsPackState state;
+  state.chunkData = NULL;
+  state.nextTile = 0;
+  state.packSec = 0;
+  state.saveAsUShort = arg->saveAsUShort;
+  state.lower = wells.mLower;
+  state.upper = wells.mUpper;
+  state.numCols = arg->numCols;
+  state.quit = false;
+  pthread_mutex_init(&state.mutex, NULL);
+  pthread_cond_init(&state.cond, NULL);
+  vector<WellsTileBuffer> tileBuffers(2 * packThreads);
+  for (size_t i = 0; i < tileBuffers.size(); ++i) {
+    state.freeBuffers.push_back(&tileBuffers[i]);
+  }
+  vector<pthread_t> packThreadIds(packThreads);
+  for (int t = 0; t < packThreads; ++t) {
+    if (pthread_create(&packThreadIds[t], NULL, PackFlowDataFunc, &state)) {
+      ION_ABORT ( "SaveWells: ERROR - failed to start pack thread" );
+    }
+  }
+  fprintf ( stdout, "SaveWells: %d pack threads\n", packThreads);
+
   bool quit = false;
   while(!quit) {
     ChunkFlowData* chunkData = (arg->writeQueuePtr)->deQueue();
@@ -110,52 +226,76 @@ void* WriteFlowDataFunc(void* arg0)
     }
 
     quit = chunkData->lastFlow;
+    Timer blockTimer;
+
+    const WellChunk& block = chunkData->wellChunk;
+    vector<WellChunk> tiles;
+    for ( size_t row = block.rowStart; row < block.rowStart + block.rowHeight; row += arg->stepSize ) {
+      for ( size_t col = block.colStart; col < block.colStart + block.colWidth; col += arg->stepSize ) {
+        WellChunk tile;
+        tile.rowStart = row;
+        tile.rowHeight = min ( arg->stepSize, block.rowStart + block.rowHeight - row );
+        tile.colStart = col;
+        tile.colWidth = min ( arg->stepSize, block.colStart + block.colWidth - col );
+        tile.flowStart = block.flowStart;
+        tile.flowDepth = block.flowDepth;
+        tiles.push_back(tile);
+      }
+    }
+
+    pthread_mutex_lock(&state.mutex);
+    state.chunkData = chunkData;
+    state.tiles.swap(tiles);
+    state.nextTile = 0;
+    state.packSec = 0;
+    pthread_cond_broadcast(&state.cond);
 
-    uint32_t currentRowStart = chunkData->wellChunk.rowStart, 
-           currentRowEnd = chunkData->wellChunk.rowStart + min ( chunkData->wellChunk.rowHeight, arg->stepSize );
-    uint32_t currentColStart = chunkData->wellChunk.colStart, 
-           currentColEnd = chunkData->wellChunk.colStart + min ( chunkData->wellChunk.colWidth, arg->stepSize );
-
-    for ( currentRowStart = 0, currentRowEnd = arg->stepSize;
-          currentRowStart < chunkData->wellChunk.rowStart + chunkData->wellChunk.rowHeight;
-          currentRowStart = currentRowEnd, currentRowEnd += arg->stepSize ) {
-      currentRowEnd = min ( ( uint32_t ) ( chunkData->wellChunk.rowStart + chunkData->wellChunk.rowHeight ), currentRowEnd );
-      for ( currentColStart = 0, currentColEnd = arg->stepSize;
-            currentColStart < chunkData->wellChunk.colStart + chunkData->wellChunk.colWidth;
-            currentColStart = currentColEnd, currentColEnd += arg->stepSize ) {
-        currentColEnd = min ( ( uint32_t ) ( chunkData->wellChunk.colStart + chunkData->wellChunk.colWidth ), currentColEnd );
-
-        chunkData->clearBuffer();
-        chunkData->bufferChunk.rowStart = currentRowStart;
-        chunkData->bufferChunk.rowHeight = currentRowEnd - currentRowStart;
-        chunkData->bufferChunk.colStart = currentColStart;
-        chunkData->bufferChunk.colWidth = currentColEnd - currentColStart;
-        chunkData->bufferChunk.flowStart = chunkData->wellChunk.flowStart;
-        chunkData->bufferChunk.flowDepth = chunkData->wellChunk.flowDepth;
-      
-        int idxCount = 0;
-        for ( size_t row = currentRowStart; row < currentRowEnd; row++ ) {
-          for ( size_t col = currentColStart; col < currentColEnd; col++ ) {
-            int idx = row * arg->numCols + col;
-            for ( size_t fIx = chunkData->wellChunk.flowStart; fIx < chunkData->wellChunk.flowStart + chunkData->wellChunk.flowDepth; fIx++ ) {
-              uint64_t ii = idxCount * chunkData->wellChunk.flowDepth + fIx - chunkData->wellChunk.flowStart;
-              uint64_t nn = ( uint64_t ) chunkData->indexes[idx] * chunkData->wellChunk.flowDepth + fIx - chunkData->wellChunk.flowStart;
-              chunkData->dsBuffer[ii] = chunkData->flowData[nn];
-            }
-            idxCount++;
-          }
-        }
-        if(writer.WriteWellsData(wells, chunkData->bufferChunk, chunkData->dsBuffer) < 0 ) {
-          ION_ABORT ( "ERROR - Unsuccessful write to HDF5 file: " +
-            ToStr ( chunkData->bufferChunk.rowStart ) + "," + ToStr ( chunkData->bufferChunk.colStart ) + "," +
-            ToStr ( chunkData->bufferChunk.rowHeight ) + "," + ToStr ( chunkData->bufferChunk.colWidth ) + " x " +
-            ToStr ( chunkData->bufferChunk.flowStart ) + "," + ToStr ( chunkData->bufferChunk.flowDepth ));
-        }
+    double writeSec = 0;
+    for (size_t written = 0; written < state.tiles.size(); ++written) {
+      while (state.readyBuffers.empty()) {
+        pthread_cond_wait(&state.cond, &state.mutex);
       }
+      WellsTileBuffer* tile = state.readyBuffers.front();
+      state.readyBuffers.pop_front();
+      pthread_mutex_unlock(&state.mutex);
+
+      Timer writeTimer;
+      int error = arg->saveAsUShort ?
+                  writer.WriteWellsData(wells, tile->chunk, &tile->quantized[0]) :
+                  writer.WriteWellsData(wells, tile->chunk, &tile->values[0]);
+      writeSec += writeTimer.elapsed();
+      if (error) {
+        ION_ABORT ( "ERROR - Unsuccessful write to HDF5 file: " +
+          ToStr ( tile->chunk.rowStart ) + "," + ToStr ( tile->chunk.colStart ) + "," +
+          ToStr ( tile->chunk.rowHeight ) + "," + ToStr ( tile->chunk.colWidth ) + " x " +
+          ToStr ( tile->chunk.flowStart ) + "," + ToStr ( tile->chunk.flowDepth ));
+      }
+
+      pthread_mutex_lock(&state.mutex);
+      state.freeBuffers.push_back(tile);
+      pthread_cond_broadcast(&state.cond);
     }
+    state.chunkData = NULL;
+    double packSec = state.packSec;
+    pthread_mutex_unlock(&state.mutex);
+
+    fprintf ( stdout, "SaveWells: flows %d-%d queue depth %d, fitters stalled %.3f sec, pack %.3f sec, write %.3f sec, block %.3f sec\n",
+              (int)block.flowStart, (int)(block.flowStart + block.flowDepth - 1), (int)chunkData->queueDepth,
+              chunkData->producerStallSec, packSec, writeSec, blockTimer.elapsed());
+
     (arg->packQueuePtr)->enQueue(chunkData);
   }
 
+  pthread_mutex_lock(&state.mutex);
+  state.quit = true;
+  pthread_cond_broadcast(&state.cond);
+  pthread_mutex_unlock(&state.mutex);
+  for (int t = 0; t < packThreads; ++t) {
+    pthread_join(packThreadIds[t], NULL);
+  }
+  pthread_cond_destroy(&state.cond);
+  pthread_mutex_destroy(&state.mutex);
+
   wells.Close();
   if ( hFile != RWH5DataSet::EMPTY ) {
     H5Fclose ( hFile );
@@ -18,6 +18,7 @@ typedef struct writeFlowDataFuncArg
   int numCols;
   size_t stepSize;
   bool saveAsUShort;
+  int packThreads;      // threads gathering and converting tiles ahead of the hdf5 writes
   SemQueue* packQueuePtr;
   SemQueue* writeQueuePtr;
 } writeFlowDataFuncArg;
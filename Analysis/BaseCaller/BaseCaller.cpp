@@ -237,6 +237,7 @@ int main (int argc, const char *argv[])
 
     // Command line processing *** Options that have default values retrieved from wells or mask files
     RawWells wells ("", bc_params.GetFiles().filename_wells.c_str());
+    wells.SetReadThreads(bc_params.NumWellsReadThreads());
     if (!wells.OpenMetaData()) {
         fprintf (stderr, "Failed to retrieve metadata from %s\n", bc_params.GetFiles().filename_wells.c_str());
         exit (EXIT_FAILURE);
@@ -392,6 +393,7 @@ int main (int argc, const char *argv[])
     time_t basecall_start_time;
     time(&basecall_start_time);
 
+    printf("Treephaser vector kernels: %s\n", TreephaserSSE::VectorKernelName());
     pthread_mutex_init(&bc.mutex, NULL);
 
     pthread_t worker_id[bc_params.NumThreads()];
@@ -480,6 +482,149 @@ int main (int argc, const char *argv[])
     return EXIT_SUCCESS;
 }
 
+// ----------------------------------------------------------------
+//! @brief    Wells data of one region, as handed to a BaseCaller worker thread
+//! @ingroup  BaseCaller
+
+struct RegionWellsBuffer {
+    RegionWellsBuffer(const string& filename_wells) : wells("", filename_wells.c_str()) {
+        valid = false;
+        current_region = begin_x = end_x = begin_y = end_y = num_usable_wells = 0;
+    }
+
+    RawWells  wells;            //!< Wells object holding the chunk of this region
+    bool      valid;            //!< False once all regions of the chip have been dispensed
+    int       current_region;   //!< Region index
+    int       begin_x;          //!< Starting X coordinate of region
+    int       end_x;            //!< Ending X coordinate of region
+    int       begin_y;          //!< Starting Y coordinate of region
+    int       end_y;            //!< Ending Y coordinate of region
+    int       num_usable_wells; //!< Number of wells in region that need basecalling. Wells are only read if >0
+};
+
+// ----------------------------------------------------------------
+//! @brief    Double-buffered wells loader owned by a single BaseCaller worker
+//! @ingroup  BaseCaller
+//! @details  A helper thread claims the next region from the lock-free ChipSubset dispenser
+//!           and reads its wells into the spare buffer while the worker basecalls the current
+//!           region, so the worker does not wait on HDF5 between regions.
+
+class RegionWellsPrefetcher {
+public:
+    RegionWellsPrefetcher(BaseCallerContext& bc)
+        : bc_(bc), next_slot_(0), in_use_slot_(-1), stop_(false)
+    {
+        for (int slot = 0; slot < 2; ++slot) {
+            buffer_[slot] = new RegionWellsBuffer(bc.filename_wells);
+            buffer_[slot]->wells.SetReadThreads(bc.wells_read_threads);
+            ready_[slot] = false;
+            pthread_mutex_lock(&bc_.mutex);
+            buffer_[slot]->wells.OpenForIncrementalRead();
+            pthread_mutex_unlock(&bc_.mutex);
+        }
+        pthread_mutex_init(&mutex_, NULL);
+        pthread_cond_init(&cond_, NULL);
+        if (pthread_create(&loader_id_, NULL, LoaderThread, this)) {
+            printf("*Error* - problem starting wells prefetch thread\n");
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    ~RegionWellsPrefetcher()
+    {
+        pthread_mutex_lock(&mutex_);
+        stop_ = true;
+        pthread_cond_broadcast(&cond_);
+        pthread_mutex_unlock(&mutex_);
+        pthread_join(loader_id_, NULL);
+
+        pthread_cond_destroy(&cond_);
+        pthread_mutex_destroy(&mutex_);
+        for (int slot = 0; slot < 2; ++slot) {
+            buffer_[slot]->wells.Close();
+            delete buffer_[slot];
+        }
+    }
+
+    //! @brief  Hands out the next prefetched region, blocking only if it is not loaded yet.
+    //!         The returned buffer stays valid until the next call. Returns false when the chip is done.
+    bool NextRegion(RegionWellsBuffer* &region)
+    {
+        pthread_mutex_lock(&mutex_);
+        in_use_slot_ = -1;                    // Release the previous region to the loader
+        pthread_cond_broadcast(&cond_);
+        while (not ready_[next_slot_])
+            pthread_cond_wait(&cond_, &mutex_);
+        ready_[next_slot_] = false;
+        in_use_slot_ = next_slot_;
+        region = buffer_[next_slot_];
+        next_slot_ ^= 1;
+        pthread_cond_broadcast(&cond_);
+        pthread_mutex_unlock(&mutex_);
+        return region->valid;
+    }
+
+private:
+    static void * LoaderThread(void *input)
+    {
+        static_cast<RegionWellsPrefetcher*>(input)->LoaderLoop();
+        return NULL;
+    }
+
+    void LoaderLoop()
+    {
+        for (int slot = 0; ; slot ^= 1) {
+            pthread_mutex_lock(&mutex_);
+            while (not stop_ and (ready_[slot] or in_use_slot_ == slot))
+                pthread_cond_wait(&cond_, &mutex_);
+            bool stop = stop_;
+            pthread_mutex_unlock(&mutex_);
+            if (stop)
+                return;
+
+            LoadNextRegion(*buffer_[slot]);
+
+            pthread_mutex_lock(&mutex_);
+            ready_[slot] = true;
+            pthread_cond_broadcast(&cond_);
+            pthread_mutex_unlock(&mutex_);
+            if (not buffer_[slot]->valid)
+                return;
+        }
+    }
+
+    void LoadNextRegion(RegionWellsBuffer& region)
+    {
+        region.valid = bc_.chip_subset.GetCurrentRegionAndIncrement(region.current_region,
+                region.begin_x, region.end_x, region.begin_y, region.end_y);
+        if (not region.valid)
+            return;
+
+        region.num_usable_wells = 0;
+        for (int y = region.begin_y; y < region.end_y; ++y)
+            for (int x = region.begin_x; x < region.end_x; ++x)
+                if (bc_.class_map[x + y * bc_.chip_subset.GetChipSizeX()] >= 0)
+                    region.num_usable_wells++;
+
+        if (region.num_usable_wells == 0) // There is nothing in this region. Don't even bother reading it
+            return;
+
+        region.wells.SetChunk(region.begin_y, region.end_y-region.begin_y,
+                region.begin_x, region.end_x-region.begin_x, 0, bc_.flow_order.num_flows());
+        region.wells.ReadWells();
+    }
+
+    BaseCallerContext&  bc_;
+    RegionWellsBuffer*  buffer_[2];     //!< Region being processed by the worker and region being prefetched
+    bool                ready_[2];      //!< Buffer is loaded and not yet handed to the worker
+    int                 next_slot_;     //!< Buffer to hand out on the next call to NextRegion
+    int                 in_use_slot_;   //!< Buffer currently held by the worker, -1 if none
+    bool                stop_;
+    pthread_t           loader_id_;
+    pthread_mutex_t     mutex_;         //!< Private to this worker/loader pair, never contended across workers
+    pthread_cond_t      cond_;
+};
+
 // ----------------------------------------------------------------
 //! @brief      Main code for BaseCaller worker thread Mark: XXX
 //! @ingroup    BaseCaller
@@ -489,10 +634,8 @@ void * BasecallerWorker(void *input)
 {
     BaseCallerContext& bc = *static_cast<BaseCallerContext*>(input);
 
-    RawWells wells ("", bc.filename_wells.c_str());
-    pthread_mutex_lock(&bc.mutex);
-    wells.OpenForIncrementalRead();
-    pthread_mutex_unlock(&bc.mutex);
+    RegionWellsPrefetcher prefetcher(bc);
+    RegionWellsBuffer *region = NULL;
 
     vector<float> residual(bc.flow_order.num_flows(), 0);
     vector<float> scaled_residual(bc.flow_order.num_flows(), 0);
@@ -522,23 +665,21 @@ void * BasecallerWorker(void *input)
     while (true) {
 
         //
-        // Step 1. Retrieve next unprocessed region
+        // Step 1. Retrieve next unprocessed region, already loaded by the prefetcher
         //
 
-        pthread_mutex_lock(&bc.mutex);
+        if (not prefetcher.NextRegion(region))
+            return NULL;
 
-        int current_region, begin_x, begin_y, end_x, end_y;
-        if (not bc.chip_subset.GetCurrentRegionAndIncrement(current_region, begin_x, end_x, begin_y, end_y)) {
-           wells.Close();
-           pthread_mutex_unlock(&bc.mutex);
-           return NULL;
-        }
+        const RawWells& wells = region->wells;
+        int current_region   = region->current_region;
+        int begin_x          = region->begin_x;
+        int begin_y          = region->begin_y;
+        int end_x            = region->end_x;
+        int end_y            = region->end_y;
+        int num_usable_wells = region->num_usable_wells;
 
-        int num_usable_wells = 0;
-        for (int y = begin_y; y < end_y; ++y)
-            for (int x = begin_x; x < end_x; ++x)
-                if (bc.class_map[x + y * bc.chip_subset.GetChipSizeX()] >= 0)
-                    num_usable_wells++;
+        pthread_mutex_lock(&bc.mutex);
 
         if      (begin_x == 0)            printf("\n% 5d/% 5d: ", begin_y, bc.chip_subset.GetChipSizeY());
         if      (num_usable_wells ==   0) printf("  ");
@@ -573,9 +714,6 @@ void * BasecallerWorker(void *input)
             continue;
         }
 
-        wells.SetChunk(begin_y, end_y-begin_y, begin_x, end_x-begin_x, 0, bc.flow_order.num_flows());
-        wells.ReadWells();
-
         for (int y = begin_y; y < end_y; ++y)
             for (int x = begin_x; x < end_x; ++x) {   // Loop over wells within current region
 
@@ -115,6 +115,7 @@ void BaseCallerParameters::PrintHelp()
     printf ("     --flow-order            STRING     flow order [retrieved from wells file]\n");
     printf ("     --run-id                STRING     read name prefix [hashed input dir name]\n");
     printf ("  -n,--num-threads           INT        number of worker threads [2*numcores]\n");
+    printf ("     --wells-read-threads    INT        threads decoding each wells read [num-threads]\n");
     printf ("  -f,--flowlimit             INT        basecall only first n flows [all flows]\n");
     printf ("     --keynormalizer         STRING     key normalization algorithm [gain]\n");
     printf ("     --dephaser              STRING     dephasing algorithm [treephaser-sse]\n");
@@ -217,6 +218,7 @@ bool BaseCallerParameters::InitContextVarsFromOptArgs(OptArgs& opts){
     context_vars.run_id                      = opts.GetFirstString ('-', "run-id", default_run_id);
 	num_threads_                             = opts.GetFirstInt    ('n', "num-threads", max(2*numCores(), 4));
 	num_bamwriter_threads_                   = opts.GetFirstInt    ('-', "num-threads-bamwriter", 6);
+	num_wells_read_threads_                  = opts.GetFirstInt    ('-', "wells-read-threads", num_threads_);
 
     context_vars.flow_signals_type           = opts.GetFirstString ('-', "flow-signals-type", "none");
     context_vars.extra_trim_left             = opts.GetFirstInt    ('-', "extra-trim-left", 0);
@@ -301,6 +303,7 @@ bool BaseCallerParameters::SetBaseCallerContextVars(BaseCallerContext & bc)
 
 
     bc.filename_wells         = bc_files.filename_wells;
+    bc.wells_read_threads     = num_wells_read_threads_;
     bc.output_directory       = bc_files.output_directory;
 
     bc.run_id                 = context_vars.run_id;
@@ -336,6 +339,7 @@ bool BaseCallerParameters::SaveParamsToJson(Json::Value& basecaller_json, const
     basecaller_json["BaseCaller"]["filename_wells"] = bc_files.filename_wells;
     basecaller_json["BaseCaller"]["filename_mask"] = bc_files.filename_mask;
     basecaller_json["BaseCaller"]["num_threads"] = num_threads_;
+    basecaller_json["BaseCaller"]["wells_read_threads"] = num_wells_read_threads_;
     basecaller_json["BaseCaller"]["dephaser"] = bc.dephaser;
     basecaller_json["BaseCaller"]["keynormalizer"] = bc.keynormalizer;
     basecaller_json["BaseCaller"]["block_row_offset"] = bc.chip_subset.GetRowOffset();
@@ -132,6 +132,7 @@ struct BaseCallerContext {
     string                    keynormalizer;          //!< Name of selected key normalization algorithm
     string                    dephaser;               //!< Name of selected dephasing algorithm
     string                    filename_wells;         //!< Filename of the input wells file
+    int                       wells_read_threads;     //!< Threads decoding each wells read
     ion::FlowOrder            flow_order;             //!< Flow order object, also stores number of flows
     vector<KeySequence>       keys;                   //!< Info about key sequences in use by library and TFs
     string                    flow_signals_type;      //!< The flow signal type: "default" - Normalized and phased, "wells" - Raw values (unnormalized and not dephased), "key-normalized" - Key normalized and not dephased, "adaptive-normalized" - Adaptive normalized and not dephased, and "unclipped" - Normalized and phased but unclipped.
@@ -184,6 +185,7 @@ public:
     BaseCallerParameters() {
       num_threads_              = 1;
       num_bamwriter_threads_    = 1;
+      num_wells_read_threads_   = 1;
       bc_files.options_set      = false;
       sampling_opts.options_set = false;
       context_vars.options_set  = false;
@@ -221,10 +223,12 @@ public:
 
     int NumThreads()          const { return num_threads_; };
     int NumBamWriterThreads() const { return num_bamwriter_threads_; };
+    int NumWellsReadThreads() const { return num_wells_read_threads_; };
 
 private:
     int                 num_threads_;              //!< NUmber of worker threads to do base calling
     int                 num_bamwriter_threads_;    //!< Number of threads one bam writer object uses
+    int                 num_wells_read_threads_;   //!< Number of threads decoding the chunks of one wells read
     BaseCallerFiles     bc_files;
     BCcontextVars       context_vars;
     BCwellSampling      sampling_opts;
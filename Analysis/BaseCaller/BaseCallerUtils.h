@@ -147,7 +147,6 @@ public:
     subset_begin_x_ = 0;  subset_begin_y_ = 0;
     subset_end_x_   = 0;  subset_end_y_   = 0;
     next_region_    = 0;
-    next_begin_x_   = 0;  next_begin_y_   = 0;
     num_wells_      = 0;
   }
 
@@ -248,24 +247,20 @@ public:
 
   // ------------------------------------------------------------------
 
+  //! @brief    Lock-free region dispenser for BaseCaller worker threads
+  //! @details  Regions are claimed with an atomic increment of the region counter and their
+  //!           coordinates derived from the region index, so no mutex is needed around this call.
   bool GetCurrentRegionAndIncrement(int & current_region, int & begin_x, int & end_x, int & begin_y, int & end_y)
   {
-    if (next_begin_y_ >= chip_size_y_)
+    int region = __sync_fetch_and_add(&next_region_, 1);
+    if (region >= num_regions_)
       return false;
 
-	current_region = next_region_;
-    begin_x = next_begin_x_;
-    begin_y = next_begin_y_;
+    current_region = region;
+    begin_x = (region % num_regions_x_) * region_size_x_;
+    begin_y = (region / num_regions_x_) * region_size_y_;
     end_x   = std::min(begin_x + region_size_x_, chip_size_x_);
     end_y   = std::min(begin_y + region_size_y_, chip_size_y_);
-
-    // Increment region
-    next_region_++;
-    next_begin_x_ += region_size_x_;
-    if (next_begin_x_ >= chip_size_x_) {
-      next_begin_x_ = 0;
-      next_begin_y_ += region_size_y_;
-    }
     return true;
   };
 
@@ -394,9 +389,7 @@ private:
     int      subset_end_y_;           //!< Ending Y of chip subset selected
 
     // Threading block management
-    int      next_region_;            //!< Number of next region that needs processing by a worker
-    int      next_begin_x_;           //!< Starting X coordinate of next region
-    int      next_begin_y_;           //!< Starting Y coordinate of next region
+    int      next_region_;            //!< Number of next region that needs processing by a worker (atomic access only)
 
     int      num_wells_;              //!< Total number of wells in the selected chip sub-block
 };
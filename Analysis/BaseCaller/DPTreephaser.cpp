@@ -21,7 +21,7 @@ const int DPTreephaser::kMinWindowSize_;
 const int DPTreephaser::kMaxWindowSize_;
 
 DPTreephaser::DPTreephaser()
-    : my_cf_(-1.0), my_ie_(-1.0), my_dr_(-1.0), flow_order_("TCAG", 4)
+    : my_cf_(-1.0), my_ie_(-1.0), my_dr_(-1.0), flow_order_("TCAG", 4), prefix_bases_(0), prefix_recalibrated_(false)
 {
   SetNormalizationWindowSize(kWindowSizeDefault_);
 }
@@ -52,6 +52,8 @@ void DPTreephaser::SetFlowOrder(const ion::FlowOrder& flow_order)
   recalibrate_predictions_         = false;
   skip_recal_during_normalization_ = false;
   diagonal_states_        = false;
+  prefix_bases_           = 0;
+  prefix_recalibrated_    = false;
   
   my_cf_ = -1.0;
   my_ie_ = -1.0;
@@ -72,6 +74,7 @@ void DPTreephaser::SetModelParameters(double carry_forward_rate, double incomple
 {
   if (carry_forward_rate == my_cf_ and incomplete_extension_rate == my_ie_ and droop_rate == my_dr_)
     return;
+  prefix_bases_ = 0;
   
   double nuc_avaliability[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
   for (int flow = 0; flow < flow_order_.num_flows(); ++flow) {
@@ -93,6 +96,7 @@ void DPTreephaser::SetModelParameters(double carry_forward_rate, double incomple
 {
   if (carry_forward_rate == my_cf_ and incomplete_extension_rate == my_ie_ and my_dr_ == 0.0)
     return;
+  prefix_bases_ = 0;
   
   double nuc_avaliability[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
   for (int flow = 0; flow < flow_order_.num_flows(); ++flow) {
@@ -930,6 +934,41 @@ void DPTreephaser::QueryAllStates(BasecallerRead& data, vector< vector<float> >&
 }
 
 
+//-------------------------------------------------------------------------
+
+int DPTreephaser::SetPrefixState(const BasecallerRead& read, int num_bases, int max_flow)
+{
+  prefix_bases_ = 0;
+  prefix_recalibrated_ = recalibrate_predictions_;
+  // With diagonal states the flow a base lands on depends on more than its nuc, don't bother
+  if (diagonal_states_)
+    return 0;
+  num_bases = min(num_bases, (int)read.sequence.size());
+  max_flow = min(max_flow, flow_order_.num_flows());
+
+  prefix_path_.state.resize(flow_order_.num_flows());
+  prefix_path_.calibA.assign(flow_order_.num_flows(), 1.0f);
+  InitializeState(&prefix_path_);
+  prefix_path_.path_metric = 0;
+  prefix_path_.per_flow_metric = 0;
+  prefix_path_.residual_left_of_window = 0;
+  prefix_path_.dot_counter = 0;
+  prefix_path_.in_use = true;
+
+  // Stop before the first base that incorporates at or past max_flow, Solve simulates that one itself
+  for (int base = 0; base < num_bases; ++base) {
+    int flow = prefix_path_.flow;
+    while (flow < max_flow and flow_order_[flow] != read.sequence[base])
+      flow++;
+    if (flow >= max_flow)
+      break;
+    AdvanceStateInPlace(&prefix_path_, read.sequence[base], flow_order_.num_flows());
+    prefix_path_.sequence.push_back(read.sequence[base]);
+  }
+  prefix_bases_ = prefix_path_.sequence.size();
+  return prefix_bases_;
+}
+
 //-------------------------------------------------------------------------
 
 void DPTreephaser::Solve(BasecallerRead& read, int max_flows, int restart_flows)
@@ -961,8 +1000,16 @@ void DPTreephaser::Solve(BasecallerRead& read, int max_flows, int restart_flows)
 
     restart_flows = min(restart_flows, max_flows);
 
-    for (vector<char>::iterator nuc = read.sequence.begin();
-          nuc != read.sequence.end() and path_[0].flow < restart_flows; ++nuc) {
+    // Bases of a stored prefix path that all incorporate before restart_flows need no simulation
+    vector<char>::iterator nuc = read.sequence.begin();
+    if (prefix_bases_ > 0 and prefix_path_.flow < restart_flows and prefix_bases_ <= (int)read.sequence.size()
+        and prefix_recalibrated_ == recalibrate_predictions_
+        and equal(prefix_path_.sequence.begin(), prefix_path_.sequence.end(), read.sequence.begin())) {
+      path_[0] = prefix_path_;
+      nuc += prefix_bases_;
+    }
+
+    for (; nuc != read.sequence.end() and path_[0].flow < restart_flows; ++nuc) {
       AdvanceStateInPlace(&path_[0], *nuc, flow_order_.num_flows());
       if (path_[0].flow < max_flows)
         path_[0].sequence.push_back(*nuc);
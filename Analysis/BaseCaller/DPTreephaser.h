@@ -140,6 +140,17 @@ public:
   //! @param[in]  restart_flows   Number of flows to simulate, rather than solve
   void  Solve(BasecallerRead& read, int max_flows, int restart_flows = 0);
 
+  //! @brief  Simulate the start of a read once and keep the path, so that Solve with restart_flows
+  //!         on reads beginning with the same bases (hypotheses of one read) starts from there
+  //! @param[in]  read.sequence   Sequence beginning with the shared bases
+  //! @param[in]  num_bases       Number of shared bases at the start of read.sequence
+  //! @param[in]  max_flow        Only bases incorporating before this flow are kept
+  //! @return     Number of bases in the stored prefix path
+  int   SetPrefixState(const BasecallerRead& read, int num_bases, int max_flow);
+
+  //! @brief  Drop the stored prefix path, Solve simulates from the first base again
+  void  ClearPrefixState() { prefix_bases_ = 0; };
+
   //! @brief  Generate predicted signal from base sequence
   //! @param[in]  read.sequence     Base sequence
   //! @param[out] read.prediction   Predicted signal
@@ -201,6 +212,7 @@ public:
     Bs_ = Bs;
     pm_model_available_ = (As_ != NULL) and (Bs_ != NULL);
     recalibrate_predictions_ = pm_model_available_; // We bothered loading the model, of course we want to use it!
+    prefix_bases_ = 0;
     return(pm_model_available_);
   };
 
@@ -215,6 +227,7 @@ public:
     pm_model_available_ = false;
     recalibrate_predictions_ = false;
     As_ = 0; Bs_ = 0;
+    prefix_bases_ = 0;
   };
 
   //! @brief    Treephaser's slot for partial base sequence, complete with tree search metrics and state for extending
@@ -267,7 +280,7 @@ public:
   //! @brief  Switch to set state progression model
   //! @param[in]  diagonal_states : Sets attribute diagonal_states_
   void SetStateProgression(bool diagonal_states)
-  { diagonal_states_ = diagonal_states; };
+  { diagonal_states_ = diagonal_states; prefix_bases_ = 0; };
 
 
   //! @brief  Switch to disable / enable the use of recalibration during the normalization phase
@@ -288,6 +301,9 @@ protected:
   vector<float>       transition_base_[8];        //!< Probability of polymerase incorporating and staying active
   vector<float>       transition_flow_[8];        //!< Probability of polymerase not incorporating and staying active
   vector<TreephaserPath> path_;                   //!< Preallocated space for partial path slots
+  TreephaserPath      prefix_path_;               //!< Simulated bases shared by the reads solved next
+  int                 prefix_bases_;              //!< Number of bases in prefix_path_, zero if there is no prefix path
+  bool                prefix_recalibrated_;       //!< Recalibration was on when prefix_path_ was simulated
 
   // PID loop and coefficients
   PIDloop             pidOffset_;
@@ -650,11 +650,14 @@ size_t PhaseEstimator::LoadRegion(int region)
   int end_x = min(begin_x + region_size_x_, chip_size_x_);
   int end_y = min(begin_y + region_size_y_, chip_size_y_);
 
-  // Mutex needed for wells access, but not needed for region_reads access
-  pthread_mutex_lock(&region_loader_mutex_);
-
-  wells_->SetChunk(begin_y, end_y-begin_y, begin_x, end_x-begin_x, 0, flow_order_.num_flows());
-  wells_->ReadWells();
+  // Mutex needed for wells access, but not needed for region_reads access.
+  // A memory mapped flat wells file can be read by all workers without locking.
+  bool flat_wells = wells_->HaveFlatWells();
+  if (not flat_wells) {
+    pthread_mutex_lock(&region_loader_mutex_);
+    wells_->SetChunk(begin_y, end_y-begin_y, begin_x, end_x-begin_x, 0, flow_order_.num_flows());
+    wells_->ReadWells();
+  }
 
   vector<float> well_buffer(flow_order_.num_flows());
 
@@ -684,8 +687,13 @@ size_t PhaseEstimator::LoadRegion(int region)
           continue;
       }
 
-      for (int flow = 0; flow < flow_order_.num_flows(); ++flow)
-        well_buffer[flow] = wells_->At(y,x,flow);
+      if (flat_wells) {
+        const float *flat_well = wells_->FlatWell(y,x);
+        copy(flat_well, flat_well + flow_order_.num_flows(), well_buffer.begin());
+      } else {
+        for (int flow = 0; flow < flow_order_.num_flows(); ++flow)
+          well_buffer[flow] = wells_->At(y,x,flow);
+      }
 
       // Sanity check. If there are NaNs in this read, print warning
       vector<int> nanflow;
@@ -756,7 +764,8 @@ size_t PhaseEstimator::LoadRegion(int region)
     }
   }
 
-  pthread_mutex_unlock(&region_loader_mutex_);
+  if (not flat_wells)
+    pthread_mutex_unlock(&region_loader_mutex_);
 
   region_num_reads_[region] = region_reads_[region].size();
 
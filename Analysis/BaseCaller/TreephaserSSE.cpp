@@ -194,6 +194,254 @@ inline void sumVectFloatSSE(float RESTRICT_PTR dst, float RESTRICT_PTR src, int
 #endif
 }
 
+// ----------------------------------------------------------------------------
+// 256-bit and 512-bit variants of the flow-parallel kernels, selected at startup by CPUID.
+// The arithmetic per flow is elementwise, and partial sums are folded into a 128-bit accumulator
+// in the same 4-flow chunk order as the SSE kernels, so every variant is bit-identical to SSE.
+// This file is built with -ffp-contract=off: a contracted multiply-add would change rounding.
+// The path expansion in advanceState4 keeps its 4 nucleotide lanes; its flows carry a running
+// dependency through the alive population and cannot be spread across wider registers.
+
+#if defined(__SSE__) && (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define TREEPHASER_WIDE_KERNELS
+#endif
+
+#ifdef TREEPHASER_WIDE_KERNELS
+
+__attribute__((target("avx2")))
+static float sumOfSquaredDiffsFloatAVX2(float RESTRICT_PTR src1, float RESTRICT_PTR src2, int count) {
+  float sum = 0.0f;
+  while((count & 3) != 0) {
+    --count;
+    sum += Sqr(src1[count]-src2[count]);
+  }
+  __m128 r0 = _mm_load_ss(&sum);
+  while(count >= 8) {
+    __m256 r1 = _mm256_loadu_ps(&src1[count-8]);
+    r1 = _mm256_sub_ps(r1, _mm256_loadu_ps(&src2[count-8]));
+    r1 = _mm256_mul_ps(r1, r1);
+    count -= 8;
+    r0 = _mm_add_ps(r0, _mm256_extractf128_ps(r1, 1));
+    r0 = _mm_add_ps(r0, _mm256_castps256_ps128(r1));
+  }
+  if(count > 0) {
+    __m128 r1 = _mm_load_ps(&src1[count-4]);
+    r1 = _mm_sub_ps(r1, _mm_load_ps(&src2[count-4]));
+    r1 = _mm_mul_ps(r1, r1);
+    r0 = _mm_add_ps(r0, r1);
+  }
+  __m128 r2 = r0;
+  r0 = _mm_movehl_ps(r0, r0);
+  r0 = _mm_add_ps(r0, r2);
+  r0 = _mm_unpacklo_ps(r0, r0);
+  r2 = r0;
+  r0 = _mm_movehl_ps(r0, r0);
+  r0 = _mm_add_ps(r0, r2);
+  _mm_store_ss(&sum, r0);
+  return sum;
+}
+
+__attribute__((target("avx2")))
+static float sumOfSquaredDiffsFloatAVX2_recal(float RESTRICT_PTR src1, float RESTRICT_PTR src2, float RESTRICT_PTR A, float RESTRICT_PTR B, int count) {
+  float sum = 0.0f;
+  while((count & 3) != 0) {
+    --count;
+      sum += Sqr(src1[count]-src2[count]*A[count]-B[count]);
+  }
+  __m128 r0 = _mm_load_ss(&sum);
+  while(count >= 8) {
+    __m256 r1 = _mm256_loadu_ps(&src1[count-8]);
+    __m256 rp = _mm256_loadu_ps(&src2[count-8]);
+    rp = _mm256_mul_ps(rp, _mm256_loadu_ps(&A[count-8]));
+    rp = _mm256_add_ps(rp, _mm256_loadu_ps(&B[count-8]));
+    r1 = _mm256_sub_ps(r1, rp);
+    r1 = _mm256_mul_ps(r1, r1);
+    count -= 8;
+    r0 = _mm_add_ps(r0, _mm256_extractf128_ps(r1, 1));
+    r0 = _mm_add_ps(r0, _mm256_castps256_ps128(r1));
+  }
+  if(count > 0) {
+    __m128 r1 = _mm_load_ps(&src1[count-4]);
+    __m128 rp = _mm_load_ps(&src2[count-4]);
+    rp = _mm_mul_ps(rp, _mm_load_ps(&A[count-4]));
+    rp = _mm_add_ps(rp, _mm_load_ps(&B[count-4]));
+    r1 = _mm_sub_ps(r1, rp);
+    r1 = _mm_mul_ps(r1, r1);
+    r0 = _mm_add_ps(r0, r1);
+  }
+  __m128 r2 = r0;
+  r0 = _mm_movehl_ps(r0, r0);
+  r0 = _mm_add_ps(r0, r2);
+  r0 = _mm_unpacklo_ps(r0, r0);
+  r2 = r0;
+  r0 = _mm_movehl_ps(r0, r0);
+  r0 = _mm_add_ps(r0, r2);
+  _mm_store_ss(&sum, r0);
+  return sum;
+}
+
+__attribute__((target("avx2")))
+static void sumVectFloatAVX2(float RESTRICT_PTR dst, float RESTRICT_PTR src, int count) {
+  while((count & 7) != 0) {
+    --count;
+    dst[count] += src[count];
+  }
+  while(count > 0) {
+    __m256 r0 = _mm256_loadu_ps(&dst[count-8]);
+    r0 = _mm256_add_ps(r0, _mm256_loadu_ps(&src[count-8]));
+    _mm256_storeu_ps(&dst[count-8], r0);
+    count -= 8;
+  }
+}
+
+__attribute__((target("avx512f")))
+static float sumOfSquaredDiffsFloatAVX512(float RESTRICT_PTR src1, float RESTRICT_PTR src2, int count) {
+  float sum = 0.0f;
+  while((count & 3) != 0) {
+    --count;
+    sum += Sqr(src1[count]-src2[count]);
+  }
+  __m128 r0 = _mm_load_ss(&sum);
+  while(count >= 16) {
+    __m512 r1 = _mm512_loadu_ps(&src1[count-16]);
+    r1 = _mm512_sub_ps(r1, _mm512_loadu_ps(&src2[count-16]));
+    r1 = _mm512_mul_ps(r1, r1);
+    count -= 16;
+    r0 = _mm_add_ps(r0, _mm512_extractf32x4_ps(r1, 3));
+    r0 = _mm_add_ps(r0, _mm512_extractf32x4_ps(r1, 2));
+    r0 = _mm_add_ps(r0, _mm512_extractf32x4_ps(r1, 1));
+    r0 = _mm_add_ps(r0, _mm512_castps512_ps128(r1));
+  }
+  while(count > 0) {
+    __m128 r1 = _mm_load_ps(&src1[count-4]);
+    r1 = _mm_sub_ps(r1, _mm_load_ps(&src2[count-4]));
+    r1 = _mm_mul_ps(r1, r1);
+    count -= 4;
+    r0 = _mm_add_ps(r0, r1);
+  }
+  __m128 r2 = r0;
+  r0 = _mm_movehl_ps(r0, r0);
+  r0 = _mm_add_ps(r0, r2);
+  r0 = _mm_unpacklo_ps(r0, r0);
+  r2 = r0;
+  r0 = _mm_movehl_ps(r0, r0);
+  r0 = _mm_add_ps(r0, r2);
+  _mm_store_ss(&sum, r0);
+  return sum;
+}
+
+__attribute__((target("avx512f")))
+static float sumOfSquaredDiffsFloatAVX512_recal(float RESTRICT_PTR src1, float RESTRICT_PTR src2, float RESTRICT_PTR A, float RESTRICT_PTR B, int count) {
+  float sum = 0.0f;
+  while((count & 3) != 0) {
+    --count;
+      sum += Sqr(src1[count]-src2[count]*A[count]-B[count]);
+  }
+  __m128 r0 = _mm_load_ss(&sum);
+  while(count >= 16) {
+    __m512 r1 = _mm512_loadu_ps(&src1[count-16]);
+    __m512 rp = _mm512_loadu_ps(&src2[count-16]);
+    rp = _mm512_mul_ps(rp, _mm512_loadu_ps(&A[count-16]));
+    rp = _mm512_add_ps(rp, _mm512_loadu_ps(&B[count-16]));
+    r1 = _mm512_sub_ps(r1, rp);
+    r1 = _mm512_mul_ps(r1, r1);
+    count -= 16;
+    r0 = _mm_add_ps(r0, _mm512_extractf32x4_ps(r1, 3));
+    r0 = _mm_add_ps(r0, _mm512_extractf32x4_ps(r1, 2));
+    r0 = _mm_add_ps(r0, _mm512_extractf32x4_ps(r1, 1));
+    r0 = _mm_add_ps(r0, _mm512_castps512_ps128(r1));
+  }
+  while(count > 0) {
+    __m128 r1 = _mm_load_ps(&src1[count-4]);
+    __m128 rp = _mm_load_ps(&src2[count-4]);
+    rp = _mm_mul_ps(rp, _mm_load_ps(&A[count-4]));
+    rp = _mm_add_ps(rp, _mm_load_ps(&B[count-4]));
+    r1 = _mm_sub_ps(r1, rp);
+    r1 = _mm_mul_ps(r1, r1);
+    count -= 4;
+    r0 = _mm_add_ps(r0, r1);
+  }
+  __m128 r2 = r0;
+  r0 = _mm_movehl_ps(r0, r0);
+  r0 = _mm_add_ps(r0, r2);
+  r0 = _mm_unpacklo_ps(r0, r0);
+  r2 = r0;
+  r0 = _mm_movehl_ps(r0, r0);
+  r0 = _mm_add_ps(r0, r2);
+  _mm_store_ss(&sum, r0);
+  return sum;
+}
+
+__attribute__((target("avx512f")))
+static void sumVectFloatAVX512(float RESTRICT_PTR dst, float RESTRICT_PTR src, int count) {
+  while((count & 15) != 0) {
+    --count;
+    dst[count] += src[count];
+  }
+  while(count > 0) {
+    __m512 r0 = _mm512_loadu_ps(&dst[count-16]);
+    r0 = _mm512_add_ps(r0, _mm512_loadu_ps(&src[count-16]));
+    _mm512_storeu_ps(&dst[count-16], r0);
+    count -= 16;
+  }
+}
+
+#endif // TREEPHASER_WIDE_KERNELS
+
+// Widest kernel set the CPU supports, picked once at load time before any worker thread exists.
+// The dispatchers below test it on every call rather than going through function pointers, so
+// the SSE kernels keep being inlined and the branch is always predicted.
+enum TreephaserKernelSet { kKernelsSSE, kKernelsAVX2, kKernelsAVX512 };
+
+static TreephaserKernelSet SelectTreephaserKernels() {
+#ifdef TREEPHASER_WIDE_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return kKernelsAVX512;
+  if (__builtin_cpu_supports("avx2"))
+    return kKernelsAVX2;
+#endif
+  return kKernelsSSE;
+}
+
+static const TreephaserKernelSet kKernelSet = SelectTreephaserKernels();
+
+inline float sumOfSquaredDiffsFloat(float RESTRICT_PTR src1, float RESTRICT_PTR src2, int count) {
+#ifdef TREEPHASER_WIDE_KERNELS
+  if (kKernelSet == kKernelsAVX512)
+    return sumOfSquaredDiffsFloatAVX512(src1, src2, count);
+  if (kKernelSet == kKernelsAVX2)
+    return sumOfSquaredDiffsFloatAVX2(src1, src2, count);
+#endif
+  return sumOfSquaredDiffsFloatSSE(src1, src2, count);
+}
+
+inline float sumOfSquaredDiffsFloat_recal(float RESTRICT_PTR src1, float RESTRICT_PTR src2, float RESTRICT_PTR A, float RESTRICT_PTR B, int count) {
+#ifdef TREEPHASER_WIDE_KERNELS
+  if (kKernelSet == kKernelsAVX512)
+    return sumOfSquaredDiffsFloatAVX512_recal(src1, src2, A, B, count);
+  if (kKernelSet == kKernelsAVX2)
+    return sumOfSquaredDiffsFloatAVX2_recal(src1, src2, A, B, count);
+#endif
+  return sumOfSquaredDiffsFloatSSE_recal(src1, src2, A, B, count);
+}
+
+inline void sumVectFloat(float RESTRICT_PTR dst, float RESTRICT_PTR src, int count) {
+#ifdef TREEPHASER_WIDE_KERNELS
+  if (kKernelSet == kKernelsAVX512) {
+    sumVectFloatAVX512(dst, src, count);
+    return;
+  }
+  if (kKernelSet == kKernelsAVX2) {
+    sumVectFloatAVX2(dst, src, count);
+    return;
+  }
+#endif
+  sumVectFloatSSE(dst, src, count);
+}
+
+const int char_to_nuc[8] = {-1, 0, -1, 1, 3, -1, -1, 2};
+
 #ifdef __SSE__
 // Function for recalibrating single prediction flow 
 inline __m128 applyRecalModel(__m128 current_value, PathRec RESTRICT_PTR current_path, int i){
@@ -228,6 +476,17 @@ TreephaserSSE::TreephaserSSE(const ion::FlowOrder& flow_order, const int windowS
   SetFlowOrder(flow_order);
 }
 
+// ----------------------------------------------------------------
+
+const char * TreephaserSSE::VectorKernelName()
+{
+  switch (kKernelSet) {
+    case kKernelsAVX512: return "avx512";
+    case kKernelsAVX2:   return "avx2";
+    default:             return "sse";
+  }
+}
+
 // ----------------------------------------------------------------
 // Initilizes all float variables to NAN so that they cause mayhem if we read out of bounds
 // and so that valgrind does not complain about uninitialized variables
@@ -327,6 +586,8 @@ void TreephaserSSE::SetFlowOrder(const ion::FlowOrder& flow_order)
   recalibrate_predictions_         = false;
   state_inphase_enabled_           = false;
   skip_recal_during_normalization_ = false;
+  prefix_bases_                    = 0;
+  prefix_recalibrated_             = false;
 }
 
 // ----------------------------------------------------------------
@@ -335,7 +596,8 @@ void TreephaserSSE::SetModelParameters(double cf, double ie)
 {
   if (cf == my_cf_ and ie == my_ie_)
     return;
-  
+  prefix_bases_ = 0;
+
   double dist[4] = { 0.0, 0.0, 0.0, 0.0 };
 
   for(int flow = 0; flow < num_flows_; ++flow) {
@@ -1074,6 +1336,97 @@ void TreephaserSSE::SolveRead(BasecallerRead& read, int begin_flow, int end_flow
 
 // -------------------------------------------------
 
+int TreephaserSSE::SetPrefixState(const BasecallerRead& read, int num_bases, int max_flow)
+{
+  prefix_bases_ = 0;
+  prefix_recalibrated_ = recalibrate_predictions_;
+  num_bases = min(num_bases, (int)read.sequence.size());
+  max_flow = min(max_flow, num_flows_);
+
+  PathRec RESTRICT_PTR path = &prefix_path_;
+  initializePath(path);
+  setValueSSE(path->calib_A, 1.0f, num_flows_);
+  setValueSSE(path->calib_B, 0.0f, num_flows_);
+
+  // Stop before the first base that incorporates at or past max_flow, Solve simulates that one itself
+  for (int base = 0; base < num_bases; ++base) {
+    int nuc = char_to_nuc[read.sequence[base]&7];
+    if (nuc < 0 or ts_NextNuc[nuc][path->flow] >= max_flow)
+      break;
+    simulateBase(path, read.sequence[base]);
+  }
+  prefix_bases_ = path->sequence_length;
+  return prefix_bases_;
+}
+
+// -------------------------------------------------
+
+void TreephaserSSE::initializePath(PathRec RESTRICT_PTR path)
+{
+  path->flow = 0;
+  path->window_start = 0;
+  path->window_end = 1;
+  path->res = 0.0f;
+  path->metr = 0.0f;
+  path->flowMetr = 0.0f;
+  path->dotCnt = 0;
+  path->state[0] = 1.0f;
+  path->sequence_length = 0;
+  path->last_hp = 0;
+  path->pred[0] = 0.0f;
+  path->state_inphase[0] = 1.0f;
+}
+
+// -------------------------------------------------
+
+bool TreephaserSSE::simulateBase(PathRec RESTRICT_PTR path, char base)
+{
+  int idx = path->sequence_length++;
+  path->sequence[idx] = base;
+  if (idx and path->sequence[idx] != path->sequence[idx-1])
+    path->last_hp = 0;
+  path->last_hp = min(path->last_hp+1, MAX_HPXLEN);
+
+  nextState(path, char_to_nuc[base&7], num_flows_);
+  if (path->flow >= num_flows_)
+    return false;
+  int to_flow = min(path->window_end, num_flows_);
+  for(int k = path->window_start; k < to_flow; ++k) {
+    if((k & 3) == 0) {
+      sumVectFloat(&path->pred[k], &path->state[k], to_flow-k);
+      break;
+    }
+    path->pred[k] += path->state[k];
+  }
+  // Recalibration part of the initial simulation: log coefficients for simulation part
+  if(recalibrate_predictions_) {
+    path->calib_A[path->flow] = (*As_).at(path->flow).at(flow_order_.int_at(path->flow)).at(path->last_hp);
+    path->calib_B[path->flow] = (*Bs_).at(path->flow).at(flow_order_.int_at(path->flow)).at(path->last_hp);
+  }
+  return true;
+}
+
+// -------------------------------------------------
+
+void TreephaserSSE::copyPrefixState(PathRec RESTRICT_PTR path) const
+{
+  const PathRec RESTRICT_PTR prefix = &prefix_path_;
+  path->flow = prefix->flow;
+  path->window_start = prefix->window_start;
+  path->window_end = prefix->window_end;
+  path->sequence_length = prefix->sequence_length;
+  path->last_hp = prefix->last_hp;
+  memcpy(path->sequence, prefix->sequence, prefix->sequence_length*sizeof(char));
+  memcpy(path->state, prefix->state, prefix->window_end*sizeof(float));
+  memcpy(path->pred, prefix->pred, prefix->window_end*sizeof(float));
+  if (prefix_recalibrated_) {
+    memcpy(path->calib_A, prefix->calib_A, (prefix->flow+1)*sizeof(float));
+    memcpy(path->calib_B, prefix->calib_B, (prefix->flow+1)*sizeof(float));
+  }
+}
+
+// -------------------------------------------------
+
 bool TreephaserSSE::Solve(int begin_flow, int end_flow)
 {
   sumNormMeasures();
@@ -1081,18 +1434,7 @@ bool TreephaserSSE::Solve(int begin_flow, int end_flow)
   PathRec RESTRICT_PTR parent = sv_PathPtr[0];
   PathRec RESTRICT_PTR best = sv_PathPtr[MAX_PATHS];
 
-  parent->flow = 0;
-  parent->window_start = 0;
-  parent->window_end = 1;
-  parent->res = 0.0f;
-  parent->metr = 0.0f;
-  parent->flowMetr = 0.0f;
-  parent->dotCnt = 0;
-  parent->state[0] = 1.0f;
-  parent->sequence_length = 0;
-  parent->last_hp = 0;
-  parent->pred[0] = 0.0f;
-  parent->state_inphase[0] = 1.0f;
+  initializePath(parent);
 
   int pathCnt = 1;
   float bestDist = 1e20;
@@ -1101,31 +1443,18 @@ bool TreephaserSSE::Solve(int begin_flow, int end_flow)
   // Simulating beginning of the read  up to or one base past begin_flow
   if(begin_flow > 0) {
 
-    static const int char_to_nuc[8] = {-1, 0, -1, 1, 3, -1, -1, 2};
-
-    for (int base = 0; base < best->sequence_length; ++base) {
-      parent->sequence_length++;
-      parent->sequence[base] = best->sequence[base];
-      if (base and parent->sequence[base] != parent->sequence[base-1])
-        parent->last_hp = 0;
-      parent->last_hp = min(parent->last_hp+1, MAX_HPXLEN);
+    // Bases of a stored prefix state that all incorporate before begin_flow need no simulation
+    int base = 0;
+    if (prefix_bases_ > 0 and prefix_path_.flow < begin_flow and prefix_bases_ <= best->sequence_length
+        and prefix_recalibrated_ == recalibrate_predictions_
+        and memcmp(prefix_path_.sequence, best->sequence, prefix_bases_) == 0) {
+      copyPrefixState(parent);
+      base = prefix_bases_;
+    }
 
-      nextState(parent, char_to_nuc[best->sequence[base]&7], num_flows_);
-      if (parent->flow >= num_flows_)
+    for (; base < best->sequence_length; ++base) {
+      if (not simulateBase(parent, best->sequence[base]))
         break;
-      int to_flow = min(parent->window_end, num_flows_);
-      for(int k = parent->window_start; k < to_flow; ++k) {
-        if((k & 3) == 0) {
-          sumVectFloatSSE(&parent->pred[k], &parent->state[k], to_flow-k);
-          break;
-        }
-        parent->pred[k] += parent->state[k];
-      }
-      // Recalibration part of the initial simulation: log coefficients for simulation part
-      if(recalibrate_predictions_) {
-        parent->calib_A[parent->flow] = (*As_).at(parent->flow).at(flow_order_.int_at(parent->flow)).at(parent->last_hp);
-        parent->calib_B[parent->flow] = (*Bs_).at(parent->flow).at(flow_order_.int_at(parent->flow)).at(parent->last_hp);
-      }
       if (parent->flow >= begin_flow)
         break;
     }
@@ -1136,7 +1465,7 @@ bool TreephaserSSE::Solve(int begin_flow, int end_flow)
       sv_PathPtr[0] = best;
       return true;
     }
-    parent->res = sumOfSquaredDiffsFloatSSE(
+    parent->res = sumOfSquaredDiffsFloat(
       (float RESTRICT_PTR)rd_NormMeasure, (float RESTRICT_PTR)parent->pred, parent->window_start);
    }
 
@@ -1267,15 +1596,15 @@ bool TreephaserSSE::Solve(int begin_flow, int end_flow)
     for(int i = parent->window_start; i < parent->window_end; ++i) {
       if((i & 3) == 0) {
         if (recalibrate_predictions_) {
-          dist += sumOfSquaredDiffsFloatSSE_recal((float RESTRICT_PTR)(&(rd_NormMeasure[i])),
-                                                  (float RESTRICT_PTR)(&(parent->pred[i])),
-                                                  (float RESTRICT_PTR)(&(parent->calib_A[i])),
-                                                  (float RESTRICT_PTR)(&(parent->calib_B[i])),
-                                                   parent->window_end-i);
+          dist += sumOfSquaredDiffsFloat_recal((float RESTRICT_PTR)(&(rd_NormMeasure[i])),
+                                               (float RESTRICT_PTR)(&(parent->pred[i])),
+                                               (float RESTRICT_PTR)(&(parent->calib_A[i])),
+                                               (float RESTRICT_PTR)(&(parent->calib_B[i])),
+                                                parent->window_end-i);
         } else {
-          dist += sumOfSquaredDiffsFloatSSE((float RESTRICT_PTR)(&(rd_NormMeasure[i])),
-                                            (float RESTRICT_PTR)(&(parent->pred[i])),
-                                             parent->window_end-i);
+          dist += sumOfSquaredDiffsFloat((float RESTRICT_PTR)(&(rd_NormMeasure[i])),
+                                         (float RESTRICT_PTR)(&(parent->pred[i])),
+                                          parent->window_end-i);
         }
         break;
       }
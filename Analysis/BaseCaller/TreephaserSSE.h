@@ -98,6 +98,17 @@ public:
   //! @param[in]  end_flow    Do not solve for any flows past this one
   void SolveRead(BasecallerRead& read, int begin_flow, int end_flow);
 
+  //! @brief      Simulate the start of a read once and keep the phasing state, so that SolveRead
+  //!             on reads beginning with the same bases (hypotheses of one read) starts from there
+  //! @param[in]  read        Read whose sequence begins with the shared bases
+  //! @param[in]  num_bases   Number of shared bases at the start of read.sequence
+  //! @param[in]  max_flow    Only bases incorporating before this flow are kept
+  //! @return     Number of bases in the stored prefix state
+  int  SetPrefixState(const BasecallerRead& read, int num_bases, int max_flow);
+
+  //! @brief      Drop the stored prefix state, SolveRead simulates from the first base again
+  void ClearPrefixState() { prefix_bases_ = 0; };
+
   //! @brief      Iterative solving and normalization routine
   void NormalizeAndSolve(BasecallerRead& read);
   PathRec* parent;
@@ -109,6 +120,7 @@ public:
     Bs_ = Bs;
     pm_model_available_ = (As_ != NULL) and (Bs_ != NULL);
     recalibrate_predictions_ = pm_model_available_; // We bothered loading the model, of course we want to use it!
+    prefix_bases_ = 0;
     return pm_model_available_;
   };
 
@@ -123,6 +135,7 @@ public:
     pm_model_available_ = false;
     recalibrate_predictions_ = false;
     As_ = 0; Bs_ = 0;
+    prefix_bases_ = 0;
   };
 
   //! @brief  Switch to disable / enable the use of recalibration during the normalization phase
@@ -132,6 +145,9 @@ public:
   //! @brief  Perform a more advanced simulation to generate QV predictors
   void  ComputeQVmetrics(BasecallerRead& read);
 
+  //! @brief  Name of the instruction set selected at startup for the flow-parallel kernels
+  static const char * VectorKernelName();
+
 protected:
 
   //! @brief     Solving a read
@@ -148,6 +164,12 @@ protected:
   void  sumNormMeasures();
   void  advanceState4(PathRec RESTRICT_PTR parent, int end);
   void  nextState(PathRec RESTRICT_PTR path, int nuc, int end);
+  //! @brief     Empty sequence at flow zero, the start of every simulation
+  void  initializePath(PathRec RESTRICT_PTR path);
+  //! @brief     Append a base to a simulated path, false if it does not fit into the flows any more
+  bool  simulateBase(PathRec RESTRICT_PTR path, char base);
+  //! @brief     Load the stored prefix state into a path
+  void  copyPrefixState(PathRec RESTRICT_PTR path) const;
 
   // There was a small penalty in making these arrays class members, as opposed to static variables
   ALIGN(64) short ts_NextNuc[4][MAX_VALS];
@@ -159,6 +181,7 @@ protected:
   ALIGN(64) float rd_SqNormMeasureSum[MAX_VALS];
 
   ALIGN(64) PathRec sv_pathBuf[MAX_PATHS+1];
+  ALIGN(64) PathRec prefix_path_;                 //!< Simulated bases shared by the reads solved next
 
   ALIGN(64) float ft_stepNorms[MAX_STEPS];
 
@@ -188,6 +211,8 @@ protected:
   bool     recalibrate_predictions_;            //!< Switch to use recalibration model during metric generation
   bool     skip_recal_during_normalization_;    //!< Switch to skip recalibration during the normalization phase
   bool     state_inphase_enabled_;              //!< Switch to save inphase population of molecules
+  int      prefix_bases_;                       //!< Number of bases in prefix_path_, zero if there is no prefix state
+  bool     prefix_recalibrated_;                //!< Recalibration was on when prefix_path_ was simulated
 
 };
 
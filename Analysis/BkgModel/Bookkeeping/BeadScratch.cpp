@@ -21,10 +21,14 @@ BeadScratchSpace::BeadScratchSpace()
 
   custom_emphasis_scale = 0;
   WhichEmphasis = 0;
+  in_arena = false;
 }
 
 BeadScratchSpace::~BeadScratchSpace()
 {
+  // arena buffers go with the arena
+  if (in_arena)
+    return;
 
   if (cur_xtflux_block != NULL) delete [] cur_xtflux_block;
 
@@ -44,7 +48,7 @@ BeadScratchSpace::~BeadScratchSpace()
 
 }
 
-void BeadScratchSpace::Allocate (int _npts,int _num_derivatives, int flow_block_size)
+void BeadScratchSpace::Allocate (int _npts,int _num_derivatives, int flow_block_size, RegionArena *arena)
 {
   npts = _npts;
   num_derivatives = _num_derivatives;
@@ -53,23 +57,49 @@ void BeadScratchSpace::Allocate (int _npts,int _num_derivatives, int flow_block_
   bead_flow_t = flow_block_size*npts; // the universal unit of currency flows by time
 
   int scratchSpace_nElem = bead_flow_t*num_derivatives;
-  int scratchSpace_len = sizeof (float) * scratchSpace_nElem;
-  scratchSpace = new float[scratchSpace_nElem];
-  memset (scratchSpace,0,scratchSpace_len);
+  in_arena = (arena != NULL);
+  if (in_arena)
+  {
+    // arena memory comes zeroed
+    scratchSpace = arena->Alloc<float> (scratchSpace_nElem);
+    ival = arena->Alloc<float> (bead_flow_t);
+    cur_xtflux_block = arena->Alloc<float> (bead_flow_t);
+    observed = arena->Alloc<float> (bead_flow_t);
+    shifted_bkg = arena->Alloc<float> (bead_flow_t);
+    custom_emphasis = arena->Alloc<float> (bead_flow_t);
+
+    custom_emphasis_scale = arena->Alloc<float> (flow_block_size);
+    WhichEmphasis = arena->Alloc<int> (flow_block_size);
+  }
+  else
+  {
+    int scratchSpace_len = sizeof (float) * scratchSpace_nElem;
+    scratchSpace = new float[scratchSpace_nElem];
+    memset (scratchSpace,0,scratchSpace_len);
+    ival = new float [bead_flow_t];
+    cur_xtflux_block = new float[bead_flow_t];
+    observed = new float [bead_flow_t];
+    shifted_bkg = new float [bead_flow_t];
+    custom_emphasis = new float [bead_flow_t];
+
+    custom_emphasis_scale = new float[ flow_block_size ];
+    WhichEmphasis = new int[ flow_block_size ];
+  }
   fval = scratchSpace;
-  ival = new float [bead_flow_t];
-  cur_xtflux_block = new float[bead_flow_t];
-  observed = new float [bead_flow_t];
-  shifted_bkg = new float [bead_flow_t];
-  custom_emphasis = new float [bead_flow_t];
-
-  custom_emphasis_scale = new float[ flow_block_size ];
-  WhichEmphasis = new int[ flow_block_size ];
 
   for (int j=0; j<flow_block_size; j++)
     custom_emphasis_scale[j] = 1.0; // might be so unfortunate as to divide by this
 }
 
+size_t BeadScratchSpace::ArenaBytes (int _npts,int _num_derivatives, int flow_block_size)
+{
+  size_t flow_t = flow_block_size*_npts;
+  return RegionArena::Padded (sizeof (float) * flow_t*_num_derivatives)
+         + 5 * RegionArena::Padded (sizeof (float) * flow_t)
+         + RegionArena::Padded (sizeof (float) * flow_block_size)
+         + RegionArena::Padded (sizeof (int) * flow_block_size);
+}
+
 void BeadScratchSpace::ResetXtalkToZero() const
 {
   memset (cur_xtflux_block,0,sizeof (float[bead_flow_t]));  // no cross-talk for projection search
@@ -18,6 +18,7 @@
 #include "RegionTracker.h"
 #include "BkgTrace.h"
 #include "EmptyTrace.h"
+#include "RegionArena.h"
 
 
 // hold temporary values for a bead
@@ -52,7 +53,9 @@ class BeadScratchSpace{
     BeadScratchSpace();
     ~BeadScratchSpace();
 
-    void  Allocate(int npts,int num_derivatives, int flow_block_size);
+    // buffers come out of arena when there is one, it must outlive this object
+    void  Allocate(int npts,int num_derivatives, int flow_block_size, RegionArena *arena = NULL);
+    static size_t ArenaBytes(int npts,int num_derivatives, int flow_block_size);
     void  ResetXtalkToZero() const;
     void  FillEmphasis(int *my_emphasis, float *source_emphasis[], 
         const std::vector<float>& source_emphasis_scale, int flow_block_size);
@@ -68,6 +71,7 @@ class BeadScratchSpace{
 
  private:
     int num_derivatives;
+    bool in_arena;
 
     // Serialization section
     friend class boost::serialization::access;
@@ -2,6 +2,11 @@
 
 #include "NucStepCache.h"
 #include "DNTPRiseModel.h"
+#include <string.h>
+
+// run-wide totals, summed from every NucStep as it unlocks or goes away
+static volatile long nuc_rise_cache_hits = 0;
+static volatile long nuc_rise_cache_misses = 0;
 
 NucStep::NucStep()
 {
@@ -11,7 +16,13 @@ NucStep::NucStep()
   i_start_coarse_step = i_start_fine_step = NULL;
   per_flow_coarse_step = per_flow_fine_step = NULL;
   all_flow_t = 0;
+  alloc_npts = 0;
   precomputed_step = false;
+
+  coarse_key = fine_key = NULL;
+  coarse_key_frames = fine_key_frames = NULL;
+  coarse_key_npts = fine_key_npts = -1;
+  cache_hits = cache_misses = 0;
 }
 
 void NucStep::Alloc ( int npts, int flow_block_size )
@@ -28,6 +39,20 @@ void NucStep::Alloc ( int npts, int flow_block_size )
   }
 
   all_flow_t = flow_block_size * npts;
+  alloc_npts = npts;
+  // the GPU path re-allocs with other frame counts, so size the keys fresh every time
+  delete [] coarse_key;
+  delete [] fine_key;
+  delete [] coarse_key_frames;
+  delete [] fine_key_frames;
+  coarse_key = new NucRiseKey[flow_block_size];
+  fine_key = new NucRiseKey[flow_block_size];
+  coarse_key_frames = new float[npts];
+  fine_key_frames = new float[npts];
+  for ( int fnum=0;fnum<flow_block_size;fnum++ )
+    coarse_key[fnum].valid = fine_key[fnum].valid = false;
+  coarse_key_npts = fine_key_npts = -1;
+
   if ( nuc_rise_coarse_step==NULL )
     nuc_rise_coarse_step=new float[all_flow_t*ISIG_SUB_STEPS_MULTI_FLOW];
   if ( nuc_rise_fine_step==NULL )
@@ -39,27 +64,67 @@ void NucStep::Alloc ( int npts, int flow_block_size )
   }
 }
 
-void NucStep::CalculateNucRiseFineStep ( reg_params *a_region, TimeCompression &time_c, FlowBufferInfo &my_flow )
+// Recompute only the flows whose inputs differ from what is already in the buffer.
+// The rise is a pure function of the key and the frame times, so a hit is bit-identical
+// to recomputing; fits that only move non-timing parameters (derivative steps for krate, d,
+// buffering...) and the single flow fit after the multi flow fit reuse the existing curves.
+void NucStep::CalculateNucRise ( reg_params *a_region, int npts, const float *frameNumber,
+    const FlowBufferInfo &my_flow, int sub_steps, float **per_flow_step, int *i_start_step,
+    NucRiseKey *key, float *key_frames, int &key_npts )
 {
-  // short circuit if we've precomputed this already for this region
-  if ( !precomputed_step )
+  int nflows = my_flow.GetMaxFlowCount();
+  if ( npts != key_npts || memcmp ( key_frames,frameNumber,sizeof ( float ) *npts ) != 0 )
   {
-    DntpRiseModel dntpMod ( time_c.npts(),a_region->nuc_shape.C,&time_c.frameNumber[0],ISIG_SUB_STEPS_SINGLE_FLOW );
+    // new time compression, nothing cached is valid
+    for ( int fnum=0;fnum<nflows;fnum++ )
+      key[fnum].valid = false;
+    if ( npts <= alloc_npts )
+    {
+      memcpy ( key_frames,frameNumber,sizeof ( float ) *npts );
+      key_npts = npts;
+    }
+    else
+      key_npts = -1;
+  }
+
+  DntpRiseModel dntpMod ( npts,a_region->nuc_shape.C,frameNumber,sub_steps );
 
-    // compute the nuc rise model for each nucleotide...in the long run could be separated out
-    // and computed region-wide
-    // at the moment, this computation is identical for all wells.  If it were not, we couldn't
-    // do it here.
-    for ( int fnum=0;fnum<my_flow.GetMaxFlowCount();fnum++ )
+  // compute the nuc rise model for each nucleotide...in the long run could be separated out
+  // and computed region-wide
+  // at the moment, this computation is identical for all wells.  If it were not, we couldn't
+  // do it here.
+  for ( int fnum=0;fnum<nflows;fnum++ )
+  {
+    NucRiseKey cur;
+    cur.valid = true;
+    cur.NucID = my_flow.flow_ndx_map[fnum];
+    cur.C = a_region->nuc_shape.C[cur.NucID];
+    cur.t_mid_nuc = GetModifiedMidNucTime ( & ( a_region->nuc_shape ),cur.NucID,fnum );
+    cur.sigma = GetModifiedSigma ( & ( a_region->nuc_shape ),cur.NucID );
+    cur.nuc_flow_span = a_region->nuc_shape.nuc_flow_span;
+
+    if ( key[fnum].valid && key_npts == npts && key[fnum].NucID == cur.NucID && key[fnum].C == cur.C &&
+         key[fnum].t_mid_nuc == cur.t_mid_nuc && key[fnum].sigma == cur.sigma &&
+         key[fnum].nuc_flow_span == cur.nuc_flow_span )
     {
-      int NucID = my_flow.flow_ndx_map[fnum];
-      i_start_fine_step[fnum]=dntpMod.CalcCDntpTop ( per_flow_fine_step[fnum],
-                              GetModifiedMidNucTime ( & ( a_region->nuc_shape ),NucID,fnum ),
-                              GetModifiedSigma ( & ( a_region->nuc_shape ),NucID ), a_region->nuc_shape.nuc_flow_span,NucID );
+      cache_hits++;
+      continue;
     }
+
+    i_start_step[fnum]=dntpMod.CalcCDntpTop ( per_flow_step[fnum],cur.t_mid_nuc,cur.sigma,cur.nuc_flow_span,cur.NucID );
+    key[fnum] = cur;
+    cache_misses++;
   }
 }
 
+void NucStep::CalculateNucRiseFineStep ( reg_params *a_region, TimeCompression &time_c, FlowBufferInfo &my_flow )
+{
+  // short circuit if we've precomputed this already for this region
+  if ( !precomputed_step )
+    CalculateNucRise ( a_region,time_c.npts(),&time_c.frameNumber[0],my_flow,ISIG_SUB_STEPS_SINGLE_FLOW,
+                       per_flow_fine_step,i_start_fine_step,fine_key,fine_key_frames,fine_key_npts );
+}
+
 void NucStep::CalculateNucRiseFineStep ( 
    reg_params *a_region, 
    int frames, 
@@ -68,25 +133,8 @@ void NucStep::CalculateNucRiseFineStep (
 {
   // short circuit if we've precomputed this already for this region
   if ( !precomputed_step )
-  {
-    DntpRiseModel dntpMod (
-        frames, 
-        a_region->nuc_shape.C,
-        &frameNumber[0],
-        ISIG_SUB_STEPS_SINGLE_FLOW );
-
-    // compute the nuc rise model for each nucleotide...in the long run could be separated out
-    // and computed region-wide
-    // at the moment, this computation is identical for all wells.  If it were not, we couldn't
-    // do it here.
-    for ( int fnum=0;fnum<my_flow.GetMaxFlowCount();fnum++ )
-    {
-      int NucID = my_flow.flow_ndx_map[fnum];
-      i_start_fine_step[fnum]=dntpMod.CalcCDntpTop ( per_flow_fine_step[fnum],
-                              GetModifiedMidNucTime ( & ( a_region->nuc_shape ),NucID,fnum ),
-                              GetModifiedSigma ( & ( a_region->nuc_shape ),NucID ), a_region->nuc_shape.nuc_flow_span,NucID );
-    }
-  }
+    CalculateNucRise ( a_region,frames,&frameNumber[0],my_flow,ISIG_SUB_STEPS_SINGLE_FLOW,
+                       per_flow_fine_step,i_start_fine_step,fine_key,fine_key_frames,fine_key_npts );
 }
 
 
@@ -106,21 +154,8 @@ void NucStep::CalculateNucRiseCoarseStep (
 {
   // if we've precomputed this step already, skip recompputation
   if ( !precomputed_step )
-  {
-    DntpRiseModel dntpMod ( time_c.npts(),a_region->nuc_shape.C,&time_c.frameNumber[0],ISIG_SUB_STEPS_MULTI_FLOW );
-
-    // compute the nuc rise model for each nucleotide...in the long run could be separated out
-    // and computed region-wide
-    // at the moment, this computation is identical for all wells.  If it were not, we couldn't
-    // do it here.
-    for ( int fnum=0;fnum<my_flow.GetMaxFlowCount();fnum++ )
-    {
-      int NucID = my_flow.flow_ndx_map[fnum];
-      i_start_coarse_step[fnum]=dntpMod.CalcCDntpTop ( per_flow_coarse_step[fnum],
-                                GetModifiedMidNucTime ( & ( a_region->nuc_shape ),NucID, fnum ),
-                                GetModifiedSigma ( & ( a_region->nuc_shape ),NucID ), a_region->nuc_shape.nuc_flow_span,NucID );
-    }
-  }
+    CalculateNucRise ( a_region,time_c.npts(),&time_c.frameNumber[0],my_flow,ISIG_SUB_STEPS_MULTI_FLOW,
+                       per_flow_coarse_step,i_start_coarse_step,coarse_key,coarse_key_frames,coarse_key_npts );
 }
 
 void NucStep::ForceLockCalculateNucRiseCoarseStep( 
@@ -138,6 +173,22 @@ void NucStep::Unlock()
 {
   // leave in a flexible state for other routines
   precomputed_step = false;
+  FlushCacheStats();
+}
+
+void NucStep::FlushCacheStats()
+{
+  if ( cache_hits > 0 )
+    __sync_fetch_and_add ( &nuc_rise_cache_hits,cache_hits );
+  if ( cache_misses > 0 )
+    __sync_fetch_and_add ( &nuc_rise_cache_misses,cache_misses );
+  cache_hits = cache_misses = 0;
+}
+
+void NucStep::GetCacheStats ( long &hits, long &misses )
+{
+  hits = __sync_fetch_and_add ( &nuc_rise_cache_hits,0 );
+  misses = __sync_fetch_and_add ( &nuc_rise_cache_misses,0 );
 }
 
 void NucStep::Delete()
@@ -149,9 +200,15 @@ void NucStep::Delete()
   delete [] per_flow_fine_step;
   delete [] i_start_coarse_step;
   delete [] i_start_fine_step;
+
+  delete [] coarse_key;
+  delete [] fine_key;
+  delete [] coarse_key_frames;
+  delete [] fine_key_frames;
 }
 
 NucStep::~NucStep()
 {
+  FlushCacheStats();
   Delete();
 }
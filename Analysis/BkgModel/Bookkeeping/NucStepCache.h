@@ -6,14 +6,42 @@
 #include "RegionParams.h"
 #include "FlowBuffer.h"
 
+// everything a flow's nuc rise depends on, so a buffer is only recomputed when one of them changes
+struct NucRiseKey {
+  bool valid;
+  int NucID;
+  float C;
+  float t_mid_nuc;
+  float sigma;
+  float nuc_flow_span;
+};
+
 class NucStep{
     // These are just locally cached pointers into the nuc_rise_{coarse,fine}_step arrays.
     float **per_flow_coarse_step;
     float **per_flow_fine_step;
 
     int all_flow_t;
+    int alloc_npts;
     bool precomputed_step;
 
+    // inputs of what is currently in the coarse and fine buffers
+    NucRiseKey *coarse_key;
+    NucRiseKey *fine_key;
+    float *coarse_key_frames;
+    float *fine_key_frames;
+    int coarse_key_npts;
+    int fine_key_npts;
+
+    // flows reused/recomputed since the last flush into the run-wide totals
+    int cache_hits;
+    int cache_misses;
+    void FlushCacheStats();
+
+    void CalculateNucRise(reg_params *a_region, int npts, const float *frameNumber,
+        const FlowBufferInfo &my_flow, int sub_steps, float **per_flow_step, int *i_start_step,
+        NucRiseKey *key, float *key_frames, int &key_npts);
+
   public:
     // scratch space to cache values that are recomputed by region as they arise
     // buffers for handling the computed nucleotide rise
@@ -42,6 +70,9 @@ class NucStep{
     void ForceLockCalculateNucRiseCoarseStep(
         reg_params *a_region, const TimeCompression &time_c, const FlowBufferInfo &my_flow);
     void Unlock();
+
+    // run-wide count of flows whose nuc rise was reused or recomputed
+    static void GetCacheStats(long &hits, long &misses);
 };
 
 
@@ -0,0 +1,65 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+
+#include "RegionArena.h"
+#include <malloc.h>
+#include <string.h>
+#include "IonErr.h"
+
+// every allocation starts on a vector boundary so the vec8 trace code can use the buffers
+#define REGION_ARENA_ALIGN 32
+
+RegionArena::RegionArena()
+{
+  cur = NULL;
+  left = 0;
+  capacity = 0;
+  used = 0;
+}
+
+RegionArena::~RegionArena()
+{
+  for (size_t i=0; i < blocks.size(); i++)
+    free (blocks[i]);
+  blocks.clear();
+  cur = NULL;
+  left = 0;
+}
+
+size_t RegionArena::Padded (size_t bytes)
+{
+  return (bytes + REGION_ARENA_ALIGN - 1) & ~ (size_t) (REGION_ARENA_ALIGN - 1);
+}
+
+void RegionArena::Reserve (size_t bytes)
+{
+  ION_ASSERT (blocks.empty(), "RegionArena reserved twice");
+  bytes = Padded (bytes);
+  if (bytes == 0)
+    return;
+  cur = (char *) memalign (REGION_ARENA_ALIGN, bytes);
+  ION_ASSERT (cur != NULL, "RegionArena out of memory");
+  memset (cur, 0, bytes);
+  blocks.push_back (cur);
+  left = bytes;
+  capacity = bytes;
+}
+
+void *RegionArena::AllocBytes (size_t bytes)
+{
+  bytes = Padded (bytes);
+  used += bytes;
+  if (bytes > left)
+  {
+    // sized too small, don't touch the reserved block, just give this one its own
+    char *extra = (char *) memalign (REGION_ARENA_ALIGN, bytes > 0 ? bytes : REGION_ARENA_ALIGN);
+    ION_ASSERT (extra != NULL, "RegionArena out of memory");
+    memset (extra, 0, bytes);
+    blocks.push_back (extra);
+    capacity += bytes;
+    return extra;
+  }
+  char *p = cur;
+  cur += bytes;
+  left -= bytes;
+  return p;
+}
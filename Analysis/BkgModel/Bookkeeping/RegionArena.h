@@ -0,0 +1,44 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#ifndef REGIONARENA_H
+#define REGIONARENA_H
+
+#include <stddef.h>
+#include <vector>
+
+// One block of memory for a region's per bead buffers (BkgTrace, BeadScratchSpace) instead of a
+// new[] per buffer.  The block is zeroed by the thread that reserves it, the fit worker that
+// loads the region's first flow, so first touch puts its pages on that worker's NUMA node.
+// Everything carved out of the arena is released at once when the arena goes away; a request
+// that doesn't fit in the reserved block gets a block of its own rather than failing.
+class RegionArena
+{
+  public:
+    RegionArena();
+    ~RegionArena();
+
+    // allocate and zero one block of bytes, call once before the Alloc calls
+    void Reserve (size_t bytes);
+
+    template<typename T>
+    T *Alloc (size_t count) { return static_cast<T *> (AllocBytes (count * sizeof (T))); }
+    void *AllocBytes (size_t bytes);
+
+    // bytes an allocation of this size takes out of the arena, use to size Reserve
+    static size_t Padded (size_t bytes);
+
+    size_t Capacity() const { return capacity; }
+    size_t Used() const { return used; }
+
+  private:
+    std::vector<char *> blocks;
+    char *cur;
+    size_t left;
+    size_t capacity;
+    size_t used;
+
+    // owns its blocks, no copies
+    RegionArena (const RegionArena &);
+    RegionArena &operator= (const RegionArena &);
+};
+
+#endif // REGIONARENA_H
@@ -0,0 +1,92 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#ifndef BKGFITLDLT_H
+#define BKGFITLDLT_H
+
+#include <math.h>
+
+// Heap-free LDL^T solver for the small symmetric normal equations of the lev-mar fits.
+// jtj + lambda*diag(jtj) is positive definite for any sane fit, so no pivoting is needed;
+// a non-positive or non-finite pivot reports failure and the caller falls back to a general solver.
+//
+// a is the n x n system, row-major, only the lower triangle (a[r*n+c], r >= c) is read, and it is
+// overwritten by L and D.  b is left alone, x receives the solution.
+// The per-well fit sizes are compiled with the dimension as a constant, so loop bounds and row
+// offsets are known to the compiler; every other size runs the same code with a runtime dimension.
+
+template <int N>
+inline bool BkgFitLdltSolveN (int n_runtime, double *a, const double *b, double *x)
+{
+  const int n = N > 0 ? N : n_runtime;
+  double vp[n];
+
+  // factor: a[j][j] holds D(j), a[i][j] (i>j) holds L(i,j)
+  for (int j=0;j < n;j++)
+  {
+    double *row_j = &a[j*n];
+    double dj = row_j[j];
+    for (int k=0;k < j;k++)
+    {
+      vp[k] = row_j[k] * a[k*n+k];
+      dj -= row_j[k] * vp[k];
+    }
+    if (! (dj > 0.0) || isinf (dj))
+      return false;
+    row_j[j] = dj;
+    double inv_dj = 1.0/dj;
+    for (int i=j+1;i < n;i++)
+    {
+      double *row_i = &a[i*n];
+      double sum = row_i[j];
+      for (int k=0;k < j;k++)
+        sum -= row_i[k] * vp[k];
+      row_i[j] = sum*inv_dj;
+    }
+  }
+
+  // L y = b
+  for (int i=0;i < n;i++)
+  {
+    double sum = b[i];
+    for (int k=0;k < i;k++)
+      sum -= a[i*n+k] * x[k];
+    x[i] = sum;
+  }
+  // D z = y
+  for (int i=0;i < n;i++)
+    x[i] /= a[i*n+i];
+  // L^T x = z
+  for (int i=n-1;i >= 0;i--)
+  {
+    double sum = x[i];
+    for (int k=i+1;k < n;k++)
+      sum -= a[k*n+i] * x[k];
+    x[i] = sum;
+  }
+  return true;
+}
+
+typedef bool (*BkgFitLdltKernel) (int n, double *a, const double *b, double *x);
+
+// fixed-size kernel for n if there is one, runtime-size kernel otherwise
+// sizes are those of the FitWell* tables at the default 20 flow block: ampl (20), ampl+buffering (21),
+// post-key with and without dmult after the first block (23, 22) and in the key block (16, 15)
+inline BkgFitLdltKernel BkgFitLdltSelect (int n)
+{
+  switch (n)
+  {
+    case 15: return BkgFitLdltSolveN<15>;
+    case 16: return BkgFitLdltSolveN<16>;
+    case 20: return BkgFitLdltSolveN<20>;
+    case 21: return BkgFitLdltSolveN<21>;
+    case 22: return BkgFitLdltSolveN<22>;
+    case 23: return BkgFitLdltSolveN<23>;
+    default: return BkgFitLdltSolveN<0>;
+  }
+}
+
+inline bool BkgFitLdltSolve (int n, double *a, const double *b, double *x)
+{
+  return BkgFitLdltSelect (n) (n, a, b, x);
+}
+
+#endif // BKGFITLDLT_H
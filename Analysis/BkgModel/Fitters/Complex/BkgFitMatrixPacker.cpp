@@ -2,6 +2,7 @@
 
 #include "BkgFitMatrixPacker.h"
 #include "BkgFitMatDat.h"
+#include "BkgFitLdlt.h"
 #include <armadillo>
 #include <cblas.h>
 #include <MathUtil.h>
@@ -77,16 +78,28 @@ void BkgFitMatrixPacker::BuildMatrix (bool accum)
 LinearSolverResult BkgFitMatrixPacker::GetOutput (BeadParams *bp, reg_params *rp, double lambda, double regularizer)
 {
   bool delta_ok = true;
-  Mat<double> jtj_lambda;
+  int n = nOutputs;
 
-  jtj_lambda = trans (*data->jtj) + (*data->jtj) + (lambda-1.0) *diagmat (*data->jtj) + regularizer* eye(nOutputs,nOutputs);
+  // jtj_lambda = trans(jtj) + jtj + (lambda-1)*diagmat(jtj) + regularizer*eye, lower triangle only,
+  // summed in the same order armadillo does; BuildMatrix fills one triangle and the other is zero
+  const double *jtj = data->jtj->memptr();
+  double jtj_lambda[n*n];
+  for (int c=0;c < n;c++)
+  {
+    double d = jtj[c*n+c];
+    jtj_lambda[c*n+c] = ( (d+d) + (lambda-1.0) *d) + regularizer;
+    for (int r=c+1;r < n;r++)
+      jtj_lambda[r*n+c] = jtj[r*n+c] + jtj[c*n+r];
+  }
 
- 
-  try
+  // small symmetric positive definite system: solve in place without touching the heap,
+  // only hand it to armadillo's general solver if the factorization breaks down
+  if (!BkgFitLdltSolve (n, jtj_lambda, data->rhs->memptr(), data->delta->memptr()))
   {
- // not necessary - armadillo does fast-solvers for small matrix size
+    try
     {
-      if (!solve (*data->delta,jtj_lambda,*data->rhs))
+      Mat<double> jtj_full = trans (*data->jtj) + (*data->jtj) + (lambda-1.0) *diagmat (*data->jtj) + regularizer* eye(nOutputs,nOutputs);
+      if (!solve (*data->delta,jtj_full,*data->rhs))
       {
         data->delta->set_size (nOutputs);
         data->delta->zeros (nOutputs);
@@ -94,12 +107,12 @@ LinearSolverResult BkgFitMatrixPacker::GetOutput (BeadParams *bp, reg_params *rp
         numException++;
       }
     }
-  }
-  catch (std::runtime_error le)
-  {
-    data->delta->set_size (nOutputs);
-    data->delta->zeros (nOutputs);
-    delta_ok = false;
+    catch (std::runtime_error le)
+    {
+      data->delta->set_size (nOutputs);
+      data->delta->zeros (nOutputs);
+      delta_ok = false;
+    }
   }
 
   for (int i=0;i < nOutputs;i++)
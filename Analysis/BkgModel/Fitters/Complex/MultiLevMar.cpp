@@ -895,9 +895,10 @@ void MultiFlowLevMar::Dfdgain_Step ( float *output,BeadParams *eval_p, int flow_
 
 // partial w.r.t. gain is the function value divided by the current gain
 
-  float** src = new float *[ flow_block_size ];
-  float** dst = new float *[ flow_block_size ];
-  float** em = new float *[ flow_block_size ];
+  // called per bead per iteration: keep the row pointers on the stack
+  float* src[ flow_block_size ];
+  float* dst[ flow_block_size ];
+  float* em[ flow_block_size ];
   // set up across flows
   for ( int fnum=0;fnum < flow_block_size;fnum++ )
   {
@@ -922,20 +923,15 @@ void MultiFlowLevMar::Dfdgain_Step ( float *output,BeadParams *eval_p, int flow_
       for ( int i=0;i < bkg.region_data->time_c.npts();i++ )
         ( dst[fnum] ) [i] = ( src[fnum] ) [i]* ( em[fnum] ) [i]/eval_p->gain;
 #endif
-
-  // Cleanup.
-  delete [] src;
-  delete [] em;
-  delete [] dst;
 }
 
 void MultiFlowLevMar::Dfderr_Step ( float *output, BeadParams *eval_p, int flow_block_size )
 {
   // partial w.r.t. darkness is the dark_matter_compensator multiplied by the emphasis
 
-  float** dst = new float*[ flow_block_size ];
-  float** et  = new float*[ flow_block_size ];
-  float** em  = new float*[ flow_block_size ];
+  float* dst[ flow_block_size ];
+  float* et[ flow_block_size ];
+  float* em[ flow_block_size ];
   // set up
   for ( int fnum=0;fnum < flow_block_size;fnum++ )
   {
@@ -964,11 +960,6 @@ void MultiFlowLevMar::Dfderr_Step ( float *output, BeadParams *eval_p, int flow_
     }
   }
 #endif
-
-  // Cleanup.
-  delete [] dst;
-  delete [] et;
-  delete [] em;
 }
 
 //@TODO: this is closely related to fit error, but the goal here is to get y-observed for the lev-mar step
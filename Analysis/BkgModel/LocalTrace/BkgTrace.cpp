@@ -28,30 +28,46 @@ BkgTrace::BkgTrace()
     bead_scale_by_flow = NULL;
     restart = false;
     allocated_flow_block_size = 0;
+    in_arena = false;
 }
 
-void BkgTrace::Allocate (int _npts, int _numLBeads, int flow_block_size)
+void BkgTrace::Allocate (int _npts, int _numLBeads, int flow_block_size, RegionArena *arena)
 {
     npts = _npts;  // recompressed trace size * number of buffers
     numLBeads = _numLBeads;
 
-    AllocateScratch(flow_block_size);
+    AllocateScratch(flow_block_size, arena);
 }
 
-void BkgTrace::AllocateScratch ( int flow_block_size )
+size_t BkgTrace::ArenaBytes (int _npts, int _numLBeads, int flow_block_size)
+{
+  return RegionArena::Padded (sizeof (FG_BUFFER_TYPE) * _npts*flow_block_size*_numLBeads)
+         + 2 * RegionArena::Padded (sizeof (float) * _numLBeads*flow_block_size);
+}
+
+void BkgTrace::AllocateScratch ( int flow_block_size, RegionArena *arena )
 {
     allocated_flow_block_size = flow_block_size;
+    in_arena = (arena != NULL);
 
     //buffers are 2D arrays where each column is single pixel's frames;
-    fg_buffers  = new FG_BUFFER_TYPE [npts*flow_block_size*numLBeads];
     // DO NOT ALLOCATE new buffers for bkg corrected data at this time
-    
-    fg_dc_offset = new float [numLBeads*flow_block_size];
-    memset (fg_dc_offset,0,sizeof (float[numLBeads*flow_block_size]));
-
-    // hack for annoying empty traces
+    // bead_scale_by_flow is a hack for annoying empty traces
     // multiplicative correction per bead per flow
-    bead_scale_by_flow = new float[numLBeads*flow_block_size];
+    if (in_arena)
+    {
+      // arena memory comes zeroed
+      fg_buffers = arena->Alloc<FG_BUFFER_TYPE> (npts*flow_block_size*numLBeads);
+      fg_dc_offset = arena->Alloc<float> (numLBeads*flow_block_size);
+      bead_scale_by_flow = arena->Alloc<float> (numLBeads*flow_block_size);
+    }
+    else
+    {
+      fg_buffers  = new FG_BUFFER_TYPE [npts*flow_block_size*numLBeads];
+      fg_dc_offset = new float [numLBeads*flow_block_size];
+      memset (fg_dc_offset,0,sizeof (float[numLBeads*flow_block_size]));
+      bead_scale_by_flow = new float[numLBeads*flow_block_size];
+    }
     
     // must have the buffers allocated here
     
@@ -91,9 +107,13 @@ BkgTrace::~BkgTrace()
   bead_trace_bkg_corrected = NULL; // unlink
   
   t0_map.clear();
-  if (fg_buffers!=NULL) delete [] fg_buffers;
-  if (fg_dc_offset!=NULL) delete[] fg_dc_offset;
-  if (bead_scale_by_flow!=NULL) delete[] bead_scale_by_flow;
+  // arena buffers go with the arena
+  if (!in_arena)
+  {
+    if (fg_buffers!=NULL) delete [] fg_buffers;
+    if (fg_dc_offset!=NULL) delete[] fg_dc_offset;
+    if (bead_scale_by_flow!=NULL) delete[] bead_scale_by_flow;
+  }
 
   time_cp = NULL; // unlink
 }
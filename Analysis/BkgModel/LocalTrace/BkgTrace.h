@@ -13,6 +13,7 @@
 #include "Image.h"
 #include "BeadTracker.h"
 #include "SynchDat.h"
+#include "RegionArena.h"
 
 class BkgTrace{
 public:
@@ -42,7 +43,9 @@ public:
     virtual ~BkgTrace();
   void DumpFlows(std::ostream &out);
   bool NeedsAllocation();
-    void Allocate(int npts, int _numLBeads, int flow_block_size);
+    // buffers come out of arena when there is one, it must outlive this object
+    void Allocate(int npts, int _numLBeads, int flow_block_size, RegionArena *arena = NULL);
+    static size_t ArenaBytes(int npts, int _numLBeads, int flow_block_size);
     void    RezeroBeads(float t_start, float t_end, int fnum, int flow_block_size);
 
     void    RezeroOneBead(float t_start, float t_end, int fnum, int ibd, int flow_block_size);
@@ -96,8 +99,9 @@ public:
 
  private:
     bool restart;
-    void AllocateScratch( int flow_block_size );
+    void AllocateScratch( int flow_block_size, RegionArena *arena = NULL );
     int allocated_flow_block_size;
+    bool in_arena;
 
     // Serialization section
     friend class boost::serialization::access;
@@ -8,6 +8,7 @@
 #ifndef __INTEL_COMPILER
 
 #include "VectorMacros.h"  // control madness of included headers
+#include <xmmintrin.h>
 
 void MathModel::PurpleSolveTotalTrace_Vec (float **vb_out, float **blue_hydrogen, float **red_hydrogen, int len, const float *deltaFrame, float *tauB, float *etbR, float gain, int flow_block_size)
 {
@@ -170,4 +171,281 @@ void MathModel::RedSolveHydrogenFlowInWell_Vec  (float * const *vb_out, const fl
   }
 }
 
+// ----------------------------------------------------------------------------
+// Fused total trace: buffering + background (the Purple solve), gain and dark matter in one sweep.
+// The three-pass version wrote the flow block trace and then re-streamed it twice more through
+// MultiplyVectorByScalar and AddScaledVector; here each output point is stored once.
+// The recurrence is carried unscaled exactly as in PurpleSolveTotalTrace_Vec, then the stored value
+// is computed as out*gain + darkness*dark_matter in the same order as the separate passes.
+// This file is built with -ffp-contract=off, so every kernel width is bit-identical to the
+// three-pass path; lanes never interact, so the width only changes how many flows run at once.
+
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define FUSED_TRACE_WIDE_KERNELS
+typedef float v16sf __attribute__ ( (vector_size (sizeof (float) *16)));
+#endif
+
+// transpose W flow-major traces into frame-major dst[frame*W+flow], 4x4 blocks at a time
+template <int W>
+static inline __attribute__ ( (always_inline)) void FusedGatherFlows (float *dst, const float * const *src, int len)
+{
+  int i=0;
+  for (;i+4<=len;i+=4)
+  {
+    for (int q=0;q<W;q+=4)
+    {
+      __m128 r0 = _mm_loadu_ps (&src[q][i]);
+      __m128 r1 = _mm_loadu_ps (&src[q+1][i]);
+      __m128 r2 = _mm_loadu_ps (&src[q+2][i]);
+      __m128 r3 = _mm_loadu_ps (&src[q+3][i]);
+      _MM_TRANSPOSE4_PS (r0,r1,r2,r3);
+      _mm_store_ps (&dst[i*W+q],r0);
+      _mm_store_ps (&dst[ (i+1) *W+q],r1);
+      _mm_store_ps (&dst[ (i+2) *W+q],r2);
+      _mm_store_ps (&dst[ (i+3) *W+q],r3);
+    }
+  }
+  for (;i<len;i++)
+    for (int k=0;k<W;k++)
+      dst[i*W+k] = src[k][i];
+}
+
+// inverse of FusedGatherFlows
+template <int W>
+static inline __attribute__ ( (always_inline)) void FusedScatterFlows (float * const *dst, const float *src, int len)
+{
+  int i=0;
+  for (;i+4<=len;i+=4)
+  {
+    for (int q=0;q<W;q+=4)
+    {
+      __m128 r0 = _mm_load_ps (&src[i*W+q]);
+      __m128 r1 = _mm_load_ps (&src[ (i+1) *W+q]);
+      __m128 r2 = _mm_load_ps (&src[ (i+2) *W+q]);
+      __m128 r3 = _mm_load_ps (&src[ (i+3) *W+q]);
+      _MM_TRANSPOSE4_PS (r0,r1,r2,r3);
+      _mm_storeu_ps (&dst[q][i],r0);
+      _mm_storeu_ps (&dst[q+1][i],r1);
+      _mm_storeu_ps (&dst[q+2][i],r2);
+      _mm_storeu_ps (&dst[q+3][i],r3);
+    }
+  }
+  for (;i<len;i++)
+    for (int k=0;k<W;k++)
+      dst[k][i] = src[i*W+k];
+}
+
+// solve the W flows in red/blue/dark/out in the lanes of one vector
+// the group is transposed to frame-major scratch first, so the recurrence runs on plain
+// aligned vector loads and the whole sweep stays in L1 (3 inputs x 16 flows x 100 frames is 19KB)
+template <typename V, int W>
+static inline __attribute__ ( (always_inline)) void FusedSolveTotalTraceLanes (
+    float * const *out, const float * const *red, const float * const *blue, const float * const *dark,
+    int len, const float *deltaFrame, const float *tauB, const float *etbR, float gain, float darkness)
+{
+  float red_t[len*W] __attribute__ ( (aligned (64)));
+  float blue_t[len*W] __attribute__ ( (aligned (64)));
+  float dark_t[ (dark != NULL ? len : 1) *W] __attribute__ ( (aligned (64)));
+  float lane[W] __attribute__ ( (aligned (64)));
+  V one, two, gainV, darknessV;
+  V etbR_vec, one_over_two_tauBV;
+  V xt, dt, one_over_one_plus_xt;
+  V out_new, out_old, rh_new, rh_old, bh_new, bh_old, dm;
+  V zero = {0.0f};
+  int i,k;
+
+  for (k=0;k<W;k++)
+    lane[k] = 1.0f;
+  one = * (V *) lane;
+  two = one+one;
+  for (k=0;k<W;k++)
+    lane[k] = gain;
+  gainV = * (V *) lane;
+  for (k=0;k<W;k++)
+    lane[k] = darkness;
+  darknessV = * (V *) lane;
+  for (k=0;k<W;k++)
+    lane[k] = etbR[k];
+  etbR_vec = * (V *) lane;
+  for (k=0;k<W;k++)
+    lane[k] = tauB[k];
+  one_over_two_tauBV = one/ (two* (* (V *) lane));
+
+  FusedGatherFlows<W> (red_t, red, len);
+  FusedGatherFlows<W> (blue_t, blue, len);
+  if (dark != NULL)
+    FusedGatherFlows<W> (dark_t, dark, len);
+
+  bh_new = zero;
+  rh_new = zero;
+  out_new = zero;
+  for (i=0;i < len;i++)
+  {
+    out_old = out_new;
+    rh_old = rh_new;
+    bh_old = bh_new;
+
+    dt = zero;
+    dt += deltaFrame[i];
+    xt = dt*one_over_two_tauBV;
+    one_over_one_plus_xt = one/ (one+xt);
+
+    rh_new = * (V *) &red_t[i*W];
+    bh_new = * (V *) &blue_t[i*W];
+
+    out_new = ( (rh_new-rh_old) + (etbR_vec+xt) *bh_new- (etbR_vec-xt) *bh_old + (one-xt) *out_old) *one_over_one_plus_xt;
+
+    // the red input is no longer needed, reuse it for the result
+    if (dark != NULL)
+    {
+      dm = * (V *) &dark_t[i*W];
+      * (V *) &red_t[i*W] = out_new*gainV + darknessV*dm;
+    }
+    else
+      * (V *) &red_t[i*W] = out_new*gainV;
+  }
+
+  FusedScatterFlows<W> (out, red_t, len);
+}
+
+// full groups of W flows, the tail in groups of 4 padded with empty flows
+template <typename V, int W>
+static inline __attribute__ ( (always_inline)) void FusedSolveTotalTraceBlock (
+    float * const *vb_out, const float * const *blue_hydrogen, const float * const *red_hydrogen,
+    int len, const float *deltaFrame, const float *tauB, const float *etbR, float gain,
+    const float * const *dark_matter, float darkness, int flow_block_size)
+{
+  int fb=0;
+  for (;fb+W<=flow_block_size;fb+=W)
+    FusedSolveTotalTraceLanes<V,W> (&vb_out[fb], &red_hydrogen[fb], &blue_hydrogen[fb],
+                                    dark_matter != NULL ? &dark_matter[fb] : NULL,
+                                    len, deltaFrame, &tauB[fb], &etbR[fb], gain, darkness);
+  if (fb == flow_block_size)
+    return;
+
+  float empty[len];
+  float sink[len];
+  memset (empty, 0, sizeof (empty));
+  for (;fb<flow_block_size;fb+=VEC_INC)
+  {
+    float *out[VEC_INC];
+    const float *red[VEC_INC], *blue[VEC_INC], *dark[VEC_INC];
+    float tau[VEC_INC], ratio[VEC_INC];
+    for (int k=0;k<VEC_INC;k++)
+    {
+      bool used = fb+k < flow_block_size;
+      out[k] = used ? vb_out[fb+k] : sink;
+      red[k] = used ? red_hydrogen[fb+k] : empty;
+      blue[k] = used ? blue_hydrogen[fb+k] : empty;
+      dark[k] = used && dark_matter != NULL ? dark_matter[fb+k] : empty;
+      tau[k] = used ? tauB[fb+k] : 1.0f;
+      ratio[k] = used ? etbR[fb+k] : 0.0f;
+    }
+    FusedSolveTotalTraceLanes<v4sf,VEC_INC> (out, red, blue, dark_matter != NULL ? dark : NULL,
+        len, deltaFrame, tau, ratio, gain, darkness);
+  }
+}
+
+typedef void (*FusedSolveTotalTraceKernel) (float * const *vb_out, const float * const *blue_hydrogen,
+    const float * const *red_hydrogen, int len, const float *deltaFrame, const float *tauB,
+    const float *etbR, float gain, const float * const *dark_matter, float darkness, int flow_block_size);
+
+static void FusedSolveTotalTraceSSE (float * const *vb_out, const float * const *blue_hydrogen,
+    const float * const *red_hydrogen, int len, const float *deltaFrame, const float *tauB,
+    const float *etbR, float gain, const float * const *dark_matter, float darkness, int flow_block_size)
+{
+  FusedSolveTotalTraceBlock<v4sf,VEC_INC> (vb_out, blue_hydrogen, red_hydrogen, len, deltaFrame, tauB, etbR,
+      gain, dark_matter, darkness, flow_block_size);
+}
+
+#ifdef FUSED_TRACE_WIDE_KERNELS
+__attribute__ ( (target ("avx2")))
+static void FusedSolveTotalTraceAVX2 (float * const *vb_out, const float * const *blue_hydrogen,
+    const float * const *red_hydrogen, int len, const float *deltaFrame, const float *tauB,
+    const float *etbR, float gain, const float * const *dark_matter, float darkness, int flow_block_size)
+{
+  FusedSolveTotalTraceBlock<v8sf,8> (vb_out, blue_hydrogen, red_hydrogen, len, deltaFrame, tauB, etbR,
+      gain, dark_matter, darkness, flow_block_size);
+}
+
+__attribute__ ( (target ("avx512f")))
+static void FusedSolveTotalTraceAVX512 (float * const *vb_out, const float * const *blue_hydrogen,
+    const float * const *red_hydrogen, int len, const float *deltaFrame, const float *tauB,
+    const float *etbR, float gain, const float * const *dark_matter, float darkness, int flow_block_size)
+{
+  FusedSolveTotalTraceBlock<v16sf,16> (vb_out, blue_hydrogen, red_hydrogen, len, deltaFrame, tauB, etbR,
+      gain, dark_matter, darkness, flow_block_size);
+}
+#endif // FUSED_TRACE_WIDE_KERNELS
+
+struct FusedSolveTotalTraceEntry {
+  const char *name;
+  FusedSolveTotalTraceKernel kernel;
+};
+
+static bool FusedSolveTotalTraceSupported (const char *name)
+{
+  if (strcmp (name, "sse") == 0)
+    return true;
+#ifdef FUSED_TRACE_WIDE_KERNELS
+  __builtin_cpu_init();
+  if (strcmp (name, "avx2") == 0)
+    return __builtin_cpu_supports ("avx2");
+  if (strcmp (name, "avx512") == 0)
+    return __builtin_cpu_supports ("avx512f");
+#endif
+  return false;
+}
+
+static FusedSolveTotalTraceEntry FusedSolveTotalTraceLookup (const char *name)
+{
+  FusedSolveTotalTraceEntry entry = { "sse", FusedSolveTotalTraceSSE };
+#ifdef FUSED_TRACE_WIDE_KERNELS
+  if (strcmp (name, "avx2") == 0)
+  {
+    entry.name = "avx2";
+    entry.kernel = FusedSolveTotalTraceAVX2;
+  }
+  else if (strcmp (name, "avx512") == 0)
+  {
+    entry.name = "avx512";
+    entry.kernel = FusedSolveTotalTraceAVX512;
+  }
+#endif
+  return entry;
+}
+
+static FusedSolveTotalTraceEntry DefaultFusedSolveTotalTrace()
+{
+  if (FusedSolveTotalTraceSupported ("avx512"))
+    return FusedSolveTotalTraceLookup ("avx512");
+  if (FusedSolveTotalTraceSupported ("avx2"))
+    return FusedSolveTotalTraceLookup ("avx2");
+  return FusedSolveTotalTraceLookup ("sse");
+}
+
+// filled once at load time before any worker thread exists
+static FusedSolveTotalTraceEntry fused_total_trace = DefaultFusedSolveTotalTrace();
+
+bool MathModel::SelectFusedSolveTotalTraceKernel (const char *name)
+{
+  if (!FusedSolveTotalTraceSupported (name))
+    return false;
+  fused_total_trace = FusedSolveTotalTraceLookup (name);
+  return true;
+}
+
+const char * MathModel::FusedSolveTotalTraceKernelName()
+{
+  return fused_total_trace.name;
+}
+
+void MathModel::FusedSolveTotalTrace_Vec (float * const *vb_out, const float * const *blue_hydrogen,
+    const float * const *red_hydrogen, int len, const float *deltaFrame, const float *tauB,
+    const float *etbR, float gain, const float * const *dark_matter, float darkness, int flow_block_size)
+{
+  fused_total_trace.kernel (vb_out, blue_hydrogen, red_hydrogen, len, deltaFrame, tauB, etbR,
+                            gain, dark_matter, darkness, flow_block_size);
+}
+
 #endif
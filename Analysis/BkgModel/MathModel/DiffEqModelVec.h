@@ -17,6 +17,18 @@ void RedSolveHydrogenFlowInWell_Vec(float * const *vb_out, const float * const *
 void BlueSolveBackgroundTrace_Vec(float **vb_out, float **blue_hydrogen, int len, 
     const float *deltaFrame, const float *tauB, const float *etbR, int flow_block_size);
 
+// PurpleSolveTotalTrace_Vec, the gain and the dark matter term in a single pass over the block:
+// vb_out[f][i] = purple[f][i]*gain + darkness*dark_matter[f][i]; dark_matter may be NULL
+void FusedSolveTotalTrace_Vec(float * const *vb_out, const float * const *blue_hydrogen,
+    const float * const *red_hydrogen, int len, const float *deltaFrame, const float *tauB,
+    const float *etbR, float gain, const float * const *dark_matter, float darkness,
+    int flow_block_size);
+
+// kernel width used by FusedSolveTotalTrace_Vec: "sse", "avx2" or "avx512", picked by CPUID at load
+const char *FusedSolveTotalTraceKernelName();
+// force a kernel width, returns false if this cpu can't run it; not thread safe
+bool SelectFusedSolveTotalTraceKernel(const char *name);
+
 } // namespace
 
 
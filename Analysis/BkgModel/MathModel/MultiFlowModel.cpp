@@ -91,10 +91,10 @@ void MathModel::MultiFlowComputeTraceGivenIncorporationAndBackground (
     bool use_vectorization, int bead_flow_t,
     int flow_block_size, int flow_block_start )
 {
-  // Save on allocation complexity; allocate enough to get to the end.
-  float **vb_out = new float*[ flow_block_size ];
-  float **bkg_for_flow = new float*[ flow_block_size ];
-  float **new_hydrogen_for_flow = new float*[ flow_block_size ];
+  int npts = time_c.npts();
+  float *vb_out[flow_block_size];
+  float *bkg_for_flow[flow_block_size];
+  float *new_hydrogen_for_flow[flow_block_size];
 
   //@TODO: the natural place for vectorization is here at the flow level
   // flows are logically independent: apply "compute trace" to all flows
@@ -107,33 +107,50 @@ void MathModel::MultiFlowComputeTraceGivenIncorporationAndBackground (
   // parallel compute across flows
   for ( int fnum=0;fnum<flow_block_size;fnum++ )
   {
-    vb_out[fnum] = fval + fnum*time_c.npts();        // get ptr to start of the function evaluation for the current flow
-    bkg_for_flow[fnum] = &sbg[fnum*time_c.npts() ];            // get ptr to pre-shifted background
-    new_hydrogen_for_flow[fnum] = &ival[fnum*time_c.npts() ];
+    vb_out[fnum] = fval + fnum*npts;        // get ptr to start of the function evaluation for the current flow
+    bkg_for_flow[fnum] = &sbg[fnum*npts ];            // get ptr to pre-shifted background
+    new_hydrogen_for_flow[fnum] = &ival[fnum*npts ];
   }
 
-  // do the actual computation
-#ifdef __INTEL_COMPILER
-  {
-    for ( int fnum=0; fnum<flow_block_size; fnum++ )
-      PurpleSolveTotalTrace ( vb_out[fnum],bkg_for_flow[fnum], new_hydrogen_for_flow[fnum], time_c.npts(),
-                              &time_c.deltaFrame[0], cur_buffer_block.tauB[fnum], cur_buffer_block.etbR[fnum] );
-  }
-#else // assumed to be GCC
+#ifndef __INTEL_COMPILER
   if ( use_vectorization )
   {
-    MathModel::PurpleSolveTotalTrace_Vec ( vb_out, bkg_for_flow, new_hydrogen_for_flow, 
-                  time_c.npts(), &time_c.deltaFrame[0], 
-                  cur_buffer_block.tauB, cur_buffer_block.etbR, p->gain, flow_block_size );
-  }
-  else
-  {
-    for ( int fnum=0; fnum<flow_block_size; fnum++ )
-      PurpleSolveTotalTrace ( vb_out[fnum],bkg_for_flow[fnum], new_hydrogen_for_flow[fnum],time_c.npts(),
-                              &time_c.deltaFrame[0], cur_buffer_block.tauB[fnum], cur_buffer_block.etbR[fnum] );
+    // buffering, gain and dark matter in one sweep so the block trace is written once
+    // bit-identical to the separate passes below
+    const float *dark_for_flow[flow_block_size];
+    const float * const *dark_matter = NULL;
+    float darkness = 0.0f;
+    float dm[npts];
+    if ( my_regions.missing_mass.mytype == PerNucAverage && !my_regions.missing_mass.training_only )
+    {
+      for ( int fnum=0; fnum<flow_block_size; fnum++ )
+        dark_for_flow[fnum] = &my_regions.missing_mass.dark_matter_compensator[my_flow.flow_ndx_map[fnum]*npts];
+      dark_matter = dark_for_flow;
+      darkness = reg_p->darkness[0];
+    }
+    else if ( my_regions.missing_mass.mytype == PCAVector )
+    {
+      // same summation as ApplyPCADarkMatter, shared by every flow
+      memset ( dm,0,sizeof ( dm ) );
+      for ( int icomp=0; icomp < NUM_DM_PCA; icomp++ )
+        AddScaledVector ( dm,&my_regions.missing_mass.dark_matter_compensator[icomp*npts],p->pca_vals[icomp],npts );
+      for ( int fnum=0; fnum<flow_block_size; fnum++ )
+        dark_for_flow[fnum] = dm;
+      dark_matter = dark_for_flow;
+      darkness = 1.0f;
+    }
+    MathModel::FusedSolveTotalTrace_Vec ( vb_out, bkg_for_flow, new_hydrogen_for_flow, npts,
+        &time_c.deltaFrame[0], cur_buffer_block.tauB, cur_buffer_block.etbR,
+        p->gain, dark_matter, darkness, flow_block_size );
+    return;
   }
 #endif
 
+  // do the actual computation
+  for ( int fnum=0; fnum<flow_block_size; fnum++ )
+    PurpleSolveTotalTrace ( vb_out[fnum],bkg_for_flow[fnum], new_hydrogen_for_flow[fnum],npts,
+                            &time_c.deltaFrame[0], cur_buffer_block.tauB[fnum], cur_buffer_block.etbR[fnum] );
+
   // adjust for well sensitivity, unexplained systematic effects
   // gain naturally parallel across flows
   MultiplyVectorByScalar ( fval,p->gain,bead_flow_t );
@@ -145,16 +162,11 @@ void MathModel::MultiFlowComputeTraceGivenIncorporationAndBackground (
     // used to rely on "darkness" being 0.0 when this happened.
     // making this trap more explicit.
     if (!my_regions.missing_mass.training_only)
-     ApplyDarkMatter ( fval,reg_p,my_regions.missing_mass.dark_matter_compensator,my_flow.flow_ndx_map,time_c.npts(), flow_block_size );
+     ApplyDarkMatter ( fval,reg_p,my_regions.missing_mass.dark_matter_compensator,my_flow.flow_ndx_map,npts, flow_block_size );
   }
 
   if (my_regions.missing_mass.mytype==PCAVector)
-     ApplyPCADarkMatter ( fval,p,my_regions.missing_mass.dark_matter_compensator,time_c.npts(), flow_block_size );
-
-  // Cleanup.
-  delete [] vb_out;
-  delete [] bkg_for_flow;
-  delete [] new_hydrogen_for_flow;
+     ApplyPCADarkMatter ( fval,p,my_regions.missing_mass.dark_matter_compensator,npts, flow_block_size );
 }
 
 
@@ -167,9 +167,13 @@ void RegionalizedData::SetupTimeAndBuffers (
 
   SetTimeAndEmphasis (global_defaults, t_mid_nuc_guess, t0_offset);
 
-  AllocTraceBuffers( global_flow_max );
+  // the per bead trace and scratch buffers share one block, first touched by this thread
+  arena.Reserve (BkgTrace::ArenaBytes (time_c.npts(), my_beads.numLBeads, global_flow_max)
+                 + BeadScratchSpace::ArenaBytes (time_c.npts(), 1, global_flow_max));
 
-  AllocFitBuffers( global_flow_max );
+  AllocTraceBuffers( global_flow_max, &arena );
+
+  AllocFitBuffers( global_flow_max, &arena );
 }
 
 void RegionalizedData::SetTshiftLimitsForSynchDat()
@@ -184,17 +188,17 @@ void RegionalizedData::SetTshiftLimitsForSynchDat()
     
 }
 
-void RegionalizedData::AllocFitBuffers( int flow_block_size )
+void RegionalizedData::AllocFitBuffers( int flow_block_size, RegionArena *from )
 {
   // so we need to make sure these structures match
-  my_scratch.Allocate (time_c.npts(),1, flow_block_size);
+  my_scratch.Allocate (time_c.npts(),1, flow_block_size, from);
   my_regions.AllocScratch (time_c.npts(), flow_block_size);
 }
 
-void RegionalizedData::AllocTraceBuffers( int flow_block_size )
+void RegionalizedData::AllocTraceBuffers( int flow_block_size, RegionArena *from )
 {
   // now do the traces set up for time compression
-  my_trace.Allocate (time_c.npts(),my_beads.numLBeads, flow_block_size);
+  my_trace.Allocate (time_c.npts(),my_beads.numLBeads, flow_block_size, from);
   my_trace.time_cp = &time_c; // point to the global time compression
 
 }
@@ -23,6 +23,7 @@
 #include "BkgTrace.h"
 #include "EmptyTraceTracker.h"
 #include "BeadScratch.h"
+#include "RegionArena.h"
 #include "Serialization.h"
 #include "SampleClonality.h"
 #include <stddef.h>
@@ -41,6 +42,9 @@ public:
   bool isGridPoint(int ibd, int nSamples);
   //int outputCount;
 
+    // backs the my_trace and my_scratch buffers, declared first so it is released after them
+    RegionArena arena;
+
     TimeCompression time_c; // region specific
 // local region emphasis vectors - may vary across chip by trace
     EmphasisClass emphasis_data; // region specific, effectively a parameter
@@ -135,8 +139,8 @@ public:
   RegionalizedData( const CommandLineOpts * inception_state );
   ~RegionalizedData();
 
-  void AllocTraceBuffers(int flow_block_size);
-  void AllocFitBuffers(int flow_block_size);
+  void AllocTraceBuffers(int flow_block_size, RegionArena *from = NULL);
+  void AllocFitBuffers(int flow_block_size, RegionArena *from = NULL);
   void SetTimeAndEmphasis (GlobalDefaultsForBkgModel &global_defaults, float tmid, float t0_offset);
   void SetupTimeAndBuffers (GlobalDefaultsForBkgModel &global_defaults,float sigma_guess,
                             float t_mid_nuc_guess,
@@ -158,6 +158,92 @@ int main (int argc, const char *argv[])
 // --------------------------------------------------------------------------
 
 
+// Read counts of one worker thread, added to the context once the thread is done
+
+struct CalibrationReadCounts
+{
+  unsigned long  num_reads_in_bam;
+  unsigned long  num_mapped_reads;
+  unsigned long  num_loaded_reads;
+  unsigned long  num_useful_reads;
+
+  CalibrationReadCounts() :
+    num_reads_in_bam(0), num_mapped_reads(0), num_loaded_reads(0), num_useful_reads(0) {};
+};
+
+// --------------------------------------------------------------------------
+
+bool KeepAlignment(const BamAlignment & alignment, const CalibrationContext & calib_context, CalibrationReadCounts & counts)
+{
+  counts.num_reads_in_bam++;
+
+  if (alignment.IsMapped()) {
+    counts.num_mapped_reads++;
+
+    if(alignment.MapQuality >= calib_context.min_mapping_qv) {
+      counts.num_loaded_reads++;
+      return true;
+    }
+  }
+  else if (calib_context.load_unmapped) {
+    counts.num_loaded_reads++;
+    return true;
+  }
+  return false;
+}
+
+// --------------------------------------------------------------------------
+// Only the BGZF inflate and the alignment core are decoded under the read lock;
+// the caller builds the character data of its batch in parallel with the other threads.
+
+bool LoadStreamBatch(CalibrationContext & calib_context, vector<BamAlignment> & bam_alignments, CalibrationReadCounts & counts)
+{
+  pthread_mutex_lock(&calib_context.read_mutex);
+
+  bam_alignments.clear();
+  BamAlignment new_alignment;
+  bool have_alignment = true;
+
+  // we may have an unsorted BAM with a large chunk of unmapped reads somewhere in the middle
+  while((bam_alignments.size() < calib_context.num_reads_per_thread) and have_alignment) {
+
+    have_alignment = calib_context.bam_reader.GetNextAlignmentCore(new_alignment);
+    if (have_alignment and KeepAlignment(new_alignment, calib_context, counts))
+      bam_alignments.push_back(new_alignment);
+  }
+
+  pthread_mutex_unlock(&calib_context.read_mutex);
+  return (bam_alignments.size() > 0);
+}
+
+// --------------------------------------------------------------------------
+// Every thread decodes the genomic chunks it claims through its own BAM handles, no lock needed
+
+bool LoadShardBatch(CalibrationContext & calib_context, BamShardReader & shard_reader,
+                    vector<BamAlignment> & bam_alignments, CalibrationReadCounts & counts)
+{
+  bam_alignments.clear();
+  BamAlignment new_alignment;
+
+  while (bam_alignments.size() < calib_context.num_reads_per_thread) {
+
+    if (not shard_reader.IsActive()) {
+      BamRegionShard shard;
+      if (not calib_context.ClaimRegionShard(shard))
+        break;
+      if (not shard_reader.SetShard(shard))
+        exit(EXIT_FAILURE);
+    }
+
+    if (shard_reader.GetNextAlignmentCore(new_alignment) and KeepAlignment(new_alignment, calib_context, counts))
+      bam_alignments.push_back(new_alignment);
+  }
+
+  return (bam_alignments.size() > 0);
+}
+
+// --------------------------------------------------------------------------
+
 void * CalibrationWorker(void *input)
 {
 
@@ -169,6 +255,8 @@ void * CalibrationWorker(void *input)
   bam_alignments.reserve(calib_context.num_reads_per_thread);
   ReadAlignmentInfo read_alignment;
   read_alignment.SetSize(calib_context.max_num_flows);
+  BamShardReader shard_reader(calib_context.bam_reader.GetBamNames());
+  CalibrationReadCounts counts;
 
   vector<DPTreephaser> treephaser_vector;
   for (unsigned int iFO=0; iFO < calib_context.flow_order_vector.size(); iFO++) {
@@ -176,8 +264,12 @@ void * CalibrationWorker(void *input)
     treephaser_vector.push_back(dpTreephaser);
   }
 
+  // The local modules collect the training data of every read this thread sees
+  // and are merged into the master modules once, after the last batch.
   HistogramCalibration    hist_calibration_local(*calib_context.hist_calibration_master);
   LinearCalibrationModel  linear_cal_model_local(*calib_context.linear_model_master);
+  hist_calibration_local.CleanSlate();
+  linear_cal_model_local.CleanSlate();
 
 
   // *** Process reads
@@ -186,51 +278,22 @@ void * CalibrationWorker(void *input)
 
     // Step 1 *** load a number of reads from the BAM files
 
-	hist_calibration_local.CleanSlate();
-	linear_cal_model_local.CleanSlate();
-
-	unsigned long num_useful_reads = 0;
-
-    pthread_mutex_lock(&calib_context.read_mutex);
+    bool have_reads;
+    if (calib_context.region_shards.empty())
+      have_reads = LoadStreamBatch(calib_context, bam_alignments, counts);
+    else
+      have_reads = LoadShardBatch(calib_context, shard_reader, bam_alignments, counts);
 
-    bam_alignments.clear();
-    BamAlignment new_alignment;
-    bool have_alignment = true;
-
-    // we may have an unsorted BAM with a large chunk of unmapped reads somewhere in the middle
-    while((bam_alignments.size() < calib_context.num_reads_per_thread) and have_alignment) {
-
-      have_alignment = calib_context.bam_reader.GetNextAlignment(new_alignment);
-      if (have_alignment) {
-        calib_context.num_reads_in_bam++;
-
-        if (new_alignment.IsMapped()) {
-          calib_context.num_mapped_reads++;
-
-          if(new_alignment.MapQuality >= calib_context.min_mapping_qv) {
-            calib_context.num_loaded_reads++;
-            bam_alignments.push_back(new_alignment);
-          }
-        }
-        else if (calib_context.load_unmapped) {
-          calib_context.num_loaded_reads++;
-          bam_alignments.push_back(new_alignment);
-        }
-      }
-    }
-
-    if ((not have_alignment) and (bam_alignments.size() == 0)) {
-      pthread_mutex_unlock(&calib_context.read_mutex);
-      return NULL;
-    }
-
-    pthread_mutex_unlock(&calib_context.read_mutex);
+    if (not have_reads)
+      break;
 
 
     // Step 2 *** Iterate over individual reads and extract information
 
     for (unsigned int iRead=0; iRead<bam_alignments.size(); iRead++) {
 
+      bam_alignments[iRead].BuildCharData();
+
       // Unpack alignment related information & generate predictions
       read_alignment.UnpackReadInfo(&bam_alignments[iRead], calib_context);
       read_alignment.UnpackAlignmentInfo(calib_context, calib_context.debug);
@@ -241,22 +304,27 @@ void * CalibrationWorker(void *input)
 
       // *** Pass read info to different modules so they can extract whatever info they need
 
-      num_useful_reads++;
+      counts.num_useful_reads++;
 
       hist_calibration_local.AddTrainingRead(read_alignment);
       linear_cal_model_local.AddTrainingRead(read_alignment);
     }
 
+  } // -- end while loop
 
-    // Step 3 *** After read processing finished, aggregate the collected information.
 
-    pthread_mutex_lock(&calib_context.write_mutex);
+  // Step 3 *** After read processing finished, aggregate the collected information.
 
-    calib_context.num_useful_reads += num_useful_reads;
-    calib_context.hist_calibration_master->AccumulateHistData(hist_calibration_local);
-    calib_context.linear_model_master->AccumulateTrainingData(linear_cal_model_local);
+  pthread_mutex_lock(&calib_context.write_mutex);
 
-    pthread_mutex_unlock(&calib_context.write_mutex);
+  calib_context.num_reads_in_bam += counts.num_reads_in_bam;
+  calib_context.num_mapped_reads += counts.num_mapped_reads;
+  calib_context.num_loaded_reads += counts.num_loaded_reads;
+  calib_context.num_useful_reads += counts.num_useful_reads;
+  calib_context.hist_calibration_master->AccumulateHistData(hist_calibration_local);
+  calib_context.linear_model_master->AccumulateTrainingData(linear_cal_model_local);
 
-  } // -- end while loop
+  pthread_mutex_unlock(&calib_context.write_mutex);
+
+  return NULL;
 }
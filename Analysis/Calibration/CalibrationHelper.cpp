@@ -34,6 +34,7 @@ void PrintHelp_Calibration()
   cout << "     --skip-droop                INT       Disregard droop in prediction generation   [true]"     << endl;
   cout << "     --min-mapping-qv            INT       Minimum mapping quality for reads          [8]"        << endl;
   cout << "     --min-align-length          INT       Minimum target alignment length            [30]"       << endl;
+  cout << "     --shard-by-region           BOOL      Threads decode genomic chunks of indexed BAMs [true]"    << endl;
   cout << "     --verbose                   INT       Set verbose level                          [1]"        << endl;
   cout << endl;
 };
@@ -75,6 +76,7 @@ bool CalibrationContext::InitializeFromOpts(OptArgs &opts)
   do_flow_alignment    = opts.GetFirstBoolean ('-', "do-flow-alignment", true);
   verbose_level        = opts.GetFirstInt     ('-', "verbose-level", 1);
   debug                = opts.GetFirstBoolean ('-', "debug", false);
+  shard_by_region      = opts.GetFirstBoolean ('-', "shard-by-region", true);
 
   // General filters
   min_mapping_qv       = opts.GetFirstInt     ('-', "min-mapping-qv", 8);
@@ -86,6 +88,13 @@ bool CalibrationContext::InitializeFromOpts(OptArgs &opts)
   num_loaded_reads = 0;
   num_useful_reads = 0;
 
+  // Every thread decoding its own chunks through the index scales with the number of threads,
+  // the shared stream is bound by one thread inflating BGZF blocks.
+  // Unplaced unmapped reads can't be reached through the index, so loading them needs the stream.
+  next_region_shard = 0;
+  if (shard_by_region and not load_unmapped and bam_reader.LocateIndexes())
+    bam_reader.GetRegionShards(4*num_threads, region_shards);
+
   Verbose();
   return true;
 };
@@ -216,6 +225,10 @@ void CalibrationContext::Verbose()
     cout << "   flow-window-size       : " << flow_window_size << endl;
     cout << "   min-mapping-qv         : " << min_mapping_qv   << endl;
     cout << "   min-align-length       : " << min_align_length << endl;
+    if (region_shards.empty())
+      cout << "   BAM reading            : shared stream" << endl;
+    else
+      cout << "   BAM reading            : " << region_shards.size() << " genomic chunks" << endl;
     // Flow orders and keys information
     cout << "   found a total of " << key_by_read_group.size() << " read groups in BAM(s)." << endl;
     cout << "   found a total of " << flow_order_vector.size() << " unique flow orders of max flow lengths: ";
@@ -228,6 +241,17 @@ void CalibrationContext::Verbose()
 
 // -----------------------------------------------------------------------
 
+bool CalibrationContext::ClaimRegionShard(BamRegionShard & shard)
+{
+  int shard_idx = __sync_fetch_and_add(&next_region_shard, 1);
+  if (shard_idx >= (int)region_shards.size())
+    return false;
+  shard = region_shards.at(shard_idx);
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
 void CalibrationContext::Close(Json::Value &json)
 {
 	bam_reader.Close();
@@ -643,6 +667,7 @@ MultiBamHandler::MultiBamHandler() :
 bool  MultiBamHandler::Open(vector<string> bam_names)
 {
   Close();
+  bam_names_ = bam_names;
   bam_readers_.assign(bam_names.size(), NULL);
 
   for (unsigned int bam_idx=0; bam_idx<bam_names.size(); ++bam_idx){
@@ -673,6 +698,7 @@ void  MultiBamHandler::Close()
     }
   }
   bam_readers_.clear();
+  bam_names_.clear();
   sam_headers_.clear();
   merged_read_groups_.Clear();
   current_bam_idx_ = 0;
@@ -704,5 +730,163 @@ bool  MultiBamHandler::GetNextAlignment(BamAlignment & alignment)
     return true;
 }
 
+// -----------------------------------------------------------------------
+// Same as above, but leaves the character data to be built by the caller outside of any lock
+
+bool  MultiBamHandler::GetNextAlignmentCore(BamAlignment & alignment)
+{
+  if (not have_bam_files_)
+    return false;
+
+  bool success = false;
+
+  while ((not success) and (current_bam_idx_ < bam_readers_.size())){
+    success = bam_readers_.at(current_bam_idx_)->GetNextAlignmentCore(alignment);
+    if (not success){
+      current_bam_idx_++;
+    }
+  }
+
+  if (not success) {
+    have_bam_files_ = false;
+    return false;
+  }
+  else
+    return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool  MultiBamHandler::LocateIndexes()
+{
+  if (not have_bam_files_)
+    return false;
+
+  for (unsigned int bam_idx=0; bam_idx<bam_readers_.size(); ++bam_idx){
+    if (not bam_readers_.at(bam_idx)->LocateIndex())
+      return false;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------
+// Chunks hold about the same number of reference bases and may span several short references,
+// so amplicon references don't each cost an index jump.
+
+void  MultiBamHandler::GetRegionShards(int target_num_shards, vector<BamRegionShard> & shards) const
+{
+  const long min_shard_length = 1000000;
+  shards.clear();
+
+  long total_length = 0;
+  for (unsigned int bam_idx=0; bam_idx<bam_readers_.size(); ++bam_idx){
+    const RefVector & references = bam_readers_.at(bam_idx)->GetReferenceData();
+    for (unsigned int ref_idx=0; ref_idx<references.size(); ++ref_idx)
+      total_length += references.at(ref_idx).RefLength;
+  }
+  long quota = max(min_shard_length, total_length / max(target_num_shards, 1) + 1);
+
+  for (unsigned int bam_idx=0; bam_idx<bam_readers_.size(); ++bam_idx){
+    const RefVector & references = bam_readers_.at(bam_idx)->GetReferenceData();
+    int num_refs = references.size();
+    BamRegionShard shard;
+    shard.bam_idx   = bam_idx;
+    shard.begin_ref = 0;
+    shard.begin_pos = 0;
+    long accumulated = 0;
+
+    for (int ref_idx=0; ref_idx<num_refs; ++ref_idx){
+      long ref_length = references.at(ref_idx).RefLength;
+      long pos = 0;
+      while (accumulated + ref_length - pos >= quota) {
+        long cut = pos + quota - accumulated;
+        shard.end_ref = ref_idx;
+        shard.end_pos = cut;
+        shards.push_back(shard);
+        // Don't start a chunk at the very end of a reference, the index can't jump there
+        shard.begin_ref = (cut < ref_length) ? ref_idx : ref_idx+1;
+        shard.begin_pos = (cut < ref_length) ? cut : 0;
+        pos = cut;
+        accumulated = 0;
+      }
+      accumulated += ref_length - pos;
+    }
+    if (shard.begin_ref < num_refs) {
+      shard.end_ref = num_refs;
+      shard.end_pos = 0;
+      shards.push_back(shard);
+    }
+  }
+}
+
+// =======================================================================
+
+BamShardReader::BamShardReader(const vector<string> & bam_names) :
+    bam_names_(bam_names), active_(false)
+{
+  bam_readers_.assign(bam_names_.size(), NULL);
+}
+
+// -----------------------------------------------------------------------
+
+BamShardReader::~BamShardReader()
+{
+  for (unsigned int bam_idx=0; bam_idx<bam_readers_.size(); ++bam_idx){
+    if (bam_readers_.at(bam_idx) != NULL) {
+      bam_readers_.at(bam_idx)->Close();
+      delete bam_readers_.at(bam_idx);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------
+
+bool  BamShardReader::SetShard(const BamRegionShard & shard)
+{
+  active_ = false;
+  BamTools::BamReader * & reader = bam_readers_.at(shard.bam_idx);
+  if (reader == NULL) {
+    reader = new BamTools::BamReader;
+    if (not reader->Open(bam_names_.at(shard.bam_idx)) or not reader->LocateIndex()) {
+      cerr << "BamShardReader ERROR: Cannot open indexed BAM file " << bam_names_.at(shard.bam_idx) << endl;
+      return false;
+    }
+  }
+
+  // BamRegion bounds are inclusive references, so a chunk ending at the start of a reference stops one before
+  int right_ref = shard.end_ref;
+  int right_pos = shard.end_pos;
+  if (right_pos == 0) {
+    right_ref--;
+    right_pos = reader->GetReferenceData().at(right_ref).RefLength;
+  }
+  if (not reader->SetRegion(shard.begin_ref, shard.begin_pos, right_ref, right_pos)) {
+    cerr << "BamShardReader ERROR: Cannot jump to chunk " << shard.begin_ref << ":" << shard.begin_pos
+         << " in BAM file " << bam_names_.at(shard.bam_idx) << endl;
+    return false;
+  }
+  shard_  = shard;
+  active_ = true;
+  return true;
+}
+
+// -----------------------------------------------------------------------
+// The index delivers every read overlapping the chunk; reads starting before it belong to the previous chunk
+
+bool  BamShardReader::GetNextAlignmentCore(BamAlignment & alignment)
+{
+  while (active_ and bam_readers_.at(shard_.bam_idx)->GetNextAlignmentCore(alignment)) {
+    if (alignment.RefID < 0 or alignment.RefID > shard_.end_ref
+        or (alignment.RefID == shard_.end_ref and alignment.Position >= shard_.end_pos))
+      break;
+    if (alignment.RefID < shard_.begin_ref
+        or (alignment.RefID == shard_.begin_ref and alignment.Position < shard_.begin_pos))
+      continue;
+    return true;
+  }
+  active_ = false;
+  return false;
+}
+
 // =======================================================================
 
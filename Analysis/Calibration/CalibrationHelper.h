@@ -32,6 +32,19 @@ class LinearCalibrationModel;
 
 void PrintHelp_Calibration();
 
+// ==================================================================
+// A chunk of the genome in one input BAM file, [begin_ref:begin_pos, end_ref:end_pos).
+// end_ref may be one past the last reference, in which case the chunk runs to the end of the placed reads.
+
+struct BamRegionShard
+{
+  unsigned int  bam_idx;
+  int           begin_ref;
+  int           begin_pos;
+  int           end_ref;
+  int           end_pos;
+};
+
 // ==================================================================
 // Since BamTools::BamMultiReader cannot handle BAM files aligned to multiple references
 // we need our own wrapper class around multiple BAM readers
@@ -48,6 +61,16 @@ public:
 
   bool    GetNextAlignment(BamAlignment & alignment);
 
+  bool    GetNextAlignmentCore(BamAlignment & alignment);
+
+  //! @brief  Locate the index of every BAM file, returns false if one of them does not have one
+  bool    LocateIndexes();
+
+  //! @brief  Split the placed reads of all BAM files into about target_num_shards chunks of the genome
+  void    GetRegionShards(int target_num_shards, vector<BamRegionShard> & shards) const;
+
+  const   vector<string> & GetBamNames() const { return bam_names_; };
+
   const   BamTools::SamReadGroupDictionary &  GetReadGroups() const { return merged_read_groups_; };
 
 private:
@@ -56,6 +79,7 @@ private:
   void MergeSamHeaders();
 
   bool                               have_bam_files_;
+  vector<string>                     bam_names_;
   unsigned int                       current_bam_idx_;
   vector<BamTools::BamReader *>      bam_readers_;
   vector<BamTools::SamHeader>        sam_headers_;
@@ -64,6 +88,34 @@ private:
 };
 
 
+// ==================================================================
+// Per thread reader for the genomic chunks of MultiBamHandler::GetRegionShards.
+// Opens its own handle to each BAM file on first use, so threads decompress their chunks in parallel.
+
+class BamShardReader{
+public:
+
+  BamShardReader(const vector<string> & bam_names);
+
+  ~BamShardReader();
+
+  bool    SetShard(const BamRegionShard & shard);
+
+  //! @brief  Next read starting inside the current chunk; false (and inactive) once the chunk is exhausted
+  bool    GetNextAlignmentCore(BamAlignment & alignment);
+
+  bool    IsActive() const { return active_; };
+
+private:
+
+  vector<string>                     bam_names_;
+  vector<BamTools::BamReader *>      bam_readers_;
+  BamRegionShard                     shard_;
+  bool                               active_;
+
+};
+
+
 // ==================================================================
 // General parameters & entities for all worker threads
 
@@ -81,6 +133,7 @@ struct CalibrationContext
   bool                       load_unmapped;              //!< Switch whether to load unmapped reads or not
   bool                       skip_droop;                 //!< Ignore droop term when generating predictions
   bool                       do_flow_alignment;          //!< Determines whether we attempt a flow alignment
+  bool                       shard_by_region;            //!< Let every thread decode its own genomic chunks of indexed BAMs
 
   // Read filtering
   unsigned int               min_mapping_qv;             //!< Minimum mapping quality for the read to be considered useful
@@ -93,6 +146,8 @@ struct CalibrationContext
   unsigned long              num_useful_reads;
 
   MultiBamHandler            bam_reader;                 //!< Bam reader shared by threads
+  vector<BamRegionShard>     region_shards;              //!< Genomic chunks claimed by the threads, empty if reading the shared stream
+  volatile int               next_region_shard;          //!< Index of the next unclaimed chunk
   ion::ChipSubset            chip_subset;                //!< Chip coordinate & region handling for Basecaller
 
   vector<ion::FlowOrder >    flow_order_vector;          //!< Vector of uniquew flow orders
@@ -109,6 +164,7 @@ struct CalibrationContext
 
 
   bool InitializeFromOpts(OptArgs &opts);
+  bool ClaimRegionShard(BamRegionShard & shard);
   void DetectFlowOrderzAndKeyFromBam(const BamTools::SamReadGroupDictionary & read_groups);
   void Verbose();
   void Close(Json::Value &json);
@@ -34,6 +34,7 @@
 
 #include "PinnedInFlow.h"
 #include "SynchDat.h"
+#include "SynchDatSerialize.h"
 #include "IonImageSem.h"
 #include "PCACompression.h"
 
@@ -442,6 +443,14 @@ void Image::SmoothMeTikhonov ( TikhonovSmoother *tikSmoother, bool dont_smooth_m
 }
 
 void Image::InitFromSdat(SynchDat *sdat) {
+  InitFromSdatHeader(sdat);
+  GridMesh<TraceChunk> &mesh = sdat->GetMesh();
+  for (size_t bIx = 0; bIx < mesh.GetNumBin(); bIx++) {
+    CopyFromTraceChunk(mesh.GetItem(bIx));
+  }
+}
+
+void Image::InitFromSdatHeader(SynchDat *sdat) {
   cleanupRaw();
   delete raw;
   raw = new RawImage();
@@ -458,15 +467,38 @@ void Image::InitFromSdat(SynchDat *sdat) {
   raw->image = (short *)malloc(raw->rows * raw->cols * raw->frames * sizeof(short));
   raw->timestamps = (int *) malloc(raw->frames * sizeof(int));
   copy(timestamps.begin(), timestamps.end(), &raw->timestamps[0]);
-  for (int row = 0; row < raw->rows; row++) {
-    for (int col = 0; col < raw->cols; col++) {
-      for (int frame = 0; frame < raw->frames; frame++) {
-        At(row,col,frame) = sdat->AtWell(row,col,frame);
-      }
+}
+
+void Image::CopyFromTraceChunk(const TraceChunk &chunk) {
+  if (chunk.mDepth == 0) {
+    return;
+  }
+  // chunks are frame major, a frame is mHeight rows of mWidth wells
+  for (int frame = 0; frame < raw->frames; frame++) {
+    const int16_t *src = &chunk.mData[0] + chunk.mFrameStep * min((size_t)frame, chunk.mDepth - 1);
+    short *dst = raw->image + frame * raw->frameStride + chunk.mRowStart * raw->cols + chunk.mColStart;
+    for (size_t row = 0; row < chunk.mHeight; row++) {
+      memcpy(dst + row * raw->cols, src + row * chunk.mWidth, chunk.mWidth * sizeof(short));
     }
   }
 }
 
+/* Copies each chunk into the image as it comes out of the decompressor. */
+class SdatImageConsumer : public TraceChunkConsumer {
+public:
+  SdatImageConsumer(Image &img) : mImg(img) {}
+  virtual void Prepare(SynchDat &header) { mImg.InitFromSdatHeader(&header); }
+  virtual void Consume(const TraceChunk &chunk) { mImg.CopyFromTraceChunk(chunk); }
+private:
+  Image &mImg;
+};
+
+bool Image::LoadSdat(const char *sdatFileName, TraceChunkSerializer &serializer) {
+  SynchDat header;
+  SdatImageConsumer consumer(*this);
+  return serializer.Read(sdatFileName, header, consumer);
+}
+
 int Image::ActuallyLoadRaw ( const char *rawFileName, int frames,  bool headerOnly, bool timeTransform )
 {
   int rc;
@@ -32,6 +32,8 @@ enum InterlaceType {
 class Image;
 class ImageCropping; // forward declaration of this global state
 class SynchDat;
+class TraceChunk;
+class TraceChunkSerializer;
 
 class AcqMovie {
  public:
@@ -57,6 +59,12 @@ public:
     int ActuallyLoadRaw_noSem ( const char *rawFileName, int frames,  bool headerOnly );
     /** Not perfect as sdat has a particular time compression per region but good workaround for some use cases. */
     void InitFromSdat(SynchDat *sdat);
+    /** InitFromSdat() streamed: chunks are copied in as serializer decompresses them, no SynchDat of the whole file is kept. */
+    bool LoadSdat(const char *sdatFileName, TraceChunkSerializer &serializer);
+    /** Size the image and set the timestamps from the sdat's chunk headers, the data is left uninitialized. */
+    void InitFromSdatHeader(SynchDat *sdat);
+    /** Copy in one chunk's wells, frames past the chunk's last repeat it as in SynchDat::AtWell(). */
+    void CopyFromTraceChunk(const TraceChunk &chunk);
     int GetRows() const {
         return raw->rows;
     }
@@ -26,6 +26,11 @@
 #include <limits.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <vector>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "datahdr.h"
 #include "AdvCompr.h"
 #ifdef BB_DC
@@ -698,6 +703,510 @@ void InterpolateFramesBeforeT0 ( int* regionalT0, short *out, int rows, int cols
 
 
 
+#ifndef WIN32
+// threads used to decode one region compressed image, 0 picks a default
+static int deInterlaceThreads = 0;
+
+void SetDeInterlaceThreads ( int numThreads )
+{
+  deInterlaceThreads = numThreads;
+}
+
+static int GetDeInterlaceThreads()
+{
+  if ( deInterlaceThreads > 0 )
+    return deInterlaceThreads;
+  // several images are usually being loaded at once, so don't take the whole machine
+  long cores = sysconf ( _SC_NPROCESSORS_ONLN );
+  return ( int ) std::max ( 1L, std::min ( 4L, cores ) );
+}
+
+// sum of the bytes, which is what the file checksum is
+static unsigned int ByteSum ( const unsigned char *ptr, size_t len )
+{
+  unsigned int sum = 0;
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = zero;
+  for ( ; i + 16 <= len; i += 16 )
+    acc = _mm_add_epi64 ( acc, _mm_sad_epu8 ( _mm_loadu_si128 ( ( const __m128i * ) ( ptr + i ) ), zero ) );
+  sum = _mm_cvtsi128_si32 ( acc ) + _mm_cvtsi128_si32 ( _mm_srli_si128 ( acc, 8 ) );
+#endif
+  for ( ; i < len; i++ )
+    sum += ptr[i];
+  return sum;
+}
+
+// byte swap big endian samples and mask them to 14 bits
+static void CopySwappedSamples ( unsigned short *dst, const unsigned char *src, int n )
+{
+  int i = 0;
+#ifdef __SSE2__
+  const __m128i mask = _mm_set1_epi16 ( 0x3fff );
+  for ( ; i + 8 <= n; i += 8 )
+  {
+    __m128i v = _mm_loadu_si128 ( ( const __m128i * ) ( src + 2*i ) );
+    v = _mm_or_si128 ( _mm_slli_epi16 ( v, 8 ), _mm_srli_epi16 ( v, 8 ) );
+    _mm_storeu_si128 ( ( __m128i * ) ( dst + i ), _mm_and_si128 ( v, mask ) );
+  }
+#endif
+  for ( ; i < n; i++ )
+  {
+    unsigned short val;
+    memcpy ( &val, src + 2*i, 2 );
+    dst[i] = ( unsigned short ) ( BYTE_SWAP_2 ( val ) & 0x3fff );
+  }
+}
+
+// unpack the next group of 8 deltas, same bit layouts as LoadCompressedRegionImage
+static inline bool UnpackVfcGroup ( const unsigned char *&CompPtr, unsigned int state, short *Val )
+{
+  switch ( state )
+  {
+    case 3:
+      Val[0] = ( CompPtr[0] >> 5 ) & 0x7;
+      Val[1] = ( CompPtr[0] >> 2 ) & 0x7;
+      Val[2] = ( ( CompPtr[0] << 1 ) & 0x6 ) | ( ( CompPtr[1] >> 7 ) & 1 );
+      Val[3] = ( ( CompPtr[1] >> 4 ) & 0x7 );
+      Val[4] = ( ( CompPtr[1] >> 1 ) & 0x7 );
+      Val[5] = ( ( CompPtr[1] << 2 ) & 0x4 ) | ( ( CompPtr[2] >> 6 ) & 3 );
+      Val[6] = ( ( CompPtr[2] >> 3 ) & 0x7 );
+      Val[7] = ( ( CompPtr[2] ) & 0x7 );
+      CompPtr += 3;
+      return true;
+    case 4:
+      for ( int i = 0; i < 4; i++ )
+      {
+        Val[2*i] = ( CompPtr[i] >> 4 ) & 0xf;
+        Val[2*i+1] = CompPtr[i] & 0xf;
+      }
+      CompPtr += 4;
+      return true;
+    case 5:
+      Val[0] = ( CompPtr[0] >> 3 ) & 0x1f;
+      Val[1] = ( ( CompPtr[0] << 2 ) & 0x1c ) | ( ( CompPtr[1] >> 6 ) & 0x3 );
+      Val[2] = ( CompPtr[1] >> 1 ) & 0x1f;
+      Val[3] = ( ( CompPtr[1] << 4 ) & 0x10 ) | ( ( CompPtr[2] >> 4 ) & 0xf );
+      Val[4] = ( ( CompPtr[2] << 1 ) & 0x1e ) | ( ( CompPtr[3] >> 7 ) & 0x1 );
+      Val[5] = ( CompPtr[3] >> 2 ) & 0x1f;
+      Val[6] = ( ( CompPtr[3] << 3 ) & 0x18 ) | ( ( CompPtr[4] >> 5 ) & 0x7 );
+      Val[7] = ( CompPtr[4] ) & 0x1f;
+      CompPtr += 5;
+      return true;
+    case 6:
+      Val[0] = ( CompPtr[0] >> 2 ) & 0x3f;
+      Val[1] = ( ( CompPtr[0] << 4 ) & 0x30 ) | ( ( CompPtr[1] >> 4 ) & 0xf );
+      Val[2] = ( ( CompPtr[1] << 2 ) & 0x3c ) | ( ( CompPtr[2] >> 6 ) & 0x3 );
+      Val[3] = ( CompPtr[2] & 0x3f );
+      Val[4] = ( CompPtr[3] >> 2 ) & 0x3f;
+      Val[5] = ( ( CompPtr[3] << 4 ) & 0x30 ) | ( ( CompPtr[4] >> 4 ) & 0xf );
+      Val[6] = ( ( CompPtr[4] << 2 ) & 0x3c ) | ( ( CompPtr[5] >> 6 ) & 0x3 );
+      Val[7] = ( CompPtr[5] & 0x3f );
+      CompPtr += 6;
+      return true;
+    case 7:
+      Val[0] = ( CompPtr[0] >> 1 ) & 0x7f;
+      Val[1] = ( ( CompPtr[0] << 6 ) & 0x40 ) | ( ( CompPtr[1] >> 2 ) & 0x3f );
+      Val[2] = ( ( CompPtr[1] << 5 ) & 0x60 ) | ( ( CompPtr[2] >> 3 ) & 0x1f );
+      Val[3] = ( ( CompPtr[2] << 4 ) & 0x70 ) | ( ( CompPtr[3] >> 4 ) & 0x0f );
+      Val[4] = ( ( CompPtr[3] << 3 ) & 0x78 ) | ( ( CompPtr[4] >> 5 ) & 0x07 );
+      Val[5] = ( ( CompPtr[4] << 2 ) & 0x7c ) | ( ( CompPtr[5] >> 6 ) & 0x3 );
+      Val[6] = ( ( CompPtr[5] << 1 ) & 0x7e ) | ( ( CompPtr[6] >> 7 ) & 0x1 );
+      Val[7] = ( CompPtr[6] & 0x7f );
+      CompPtr += 7;
+      return true;
+    case 8:
+      for ( int i = 0; i < 8; i++ )
+        Val[i] = CompPtr[i];
+      CompPtr += 8;
+      return true;
+    case 16:
+      for ( int i = 0; i < 8; i++ )
+        Val[i] = ( CompPtr[2*i] << 8 ) | CompPtr[2*i+1];
+      CompPtr += 16;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// decode one region of one compressed frame against the previous frame,
+// returns the region's contribution to the frame total
+static unsigned int DecodeVfcRegion ( const unsigned char *CompPtr, unsigned int compressed,
+                                      unsigned short *frame, const unsigned short *prevFrame,
+                                      int cols, int realx, int realy, int nelems_x, int nelems_y,
+                                      unsigned int &Transitions, int ignoreErrors )
+{
+  short Val[8] = {0};
+  unsigned int state = 0; // first entry better be a state change
+  int leftShift = 0;
+  unsigned int total = 0;
+  unsigned short RegionAverage = 0;
+
+  if ( compressed >= 3 )
+  {
+    RegionAverage = CompPtr[0] << 8 | CompPtr[1];
+    CompPtr += 2;
+  }
+#ifdef __SSE2__
+  const __m128i ones = _mm_set1_epi16 ( 1 );
+  const __m128i average = _mm_set1_epi16 ( ( short ) RegionAverage );
+  __m128i acc = _mm_setzero_si128();
+#endif
+
+  for ( int y = 0; y < nelems_y; y++ )
+  {
+    unsigned short *WholeFrame = frame + ( size_t ) ( realy + y ) * cols + realx;
+    const unsigned short *PrevWholeFrame = prevFrame + ( size_t ) ( realy + y ) * cols + realx;
+
+    for ( int x = 0; x < nelems_x; x += 8, WholeFrame += 8, PrevWholeFrame += 8 )
+    {
+      if ( CompPtr[0] == 0x7F )
+      {
+        if ( ( CompPtr[1] & 0x0f ) == KEY_16_1 )
+          state = 16;
+        else
+          state = CompPtr[1] & 0xf;
+        leftShift = ( compressed >= 2 ) ? ( ( CompPtr[1] >> 4 ) & 0xf ) : 0;
+        CompPtr += 2;
+        Transitions++;
+      }
+
+#ifdef __SSE2__
+      __m128i v;
+      if ( state == 8 )
+      {
+        v = _mm_unpacklo_epi8 ( _mm_loadl_epi64 ( ( const __m128i * ) CompPtr ), _mm_setzero_si128() );
+        CompPtr += 8;
+      }
+      else if ( state == 16 )
+      {
+        v = _mm_loadu_si128 ( ( const __m128i * ) CompPtr );
+        v = _mm_or_si128 ( _mm_slli_epi16 ( v, 8 ), _mm_srli_epi16 ( v, 8 ) );
+        CompPtr += 16;
+      }
+      else
+      {
+        if ( !UnpackVfcGroup ( CompPtr, state, Val ) )
+        {
+          printf ( "corrupt file\n" );
+          if ( !ignoreErrors )
+            exit ( 2 );
+        }
+        v = _mm_loadu_si128 ( ( const __m128i * ) Val );
+      }
+      if ( state != 16 )
+        v = _mm_sub_epi16 ( v, _mm_set1_epi16 ( ( short ) ( 1 << ( state-1 ) ) ) );
+      if ( leftShift )
+        v = _mm_sll_epi16 ( v, _mm_cvtsi32_si128 ( leftShift ) );
+      v = _mm_add_epi16 ( v, _mm_add_epi16 ( _mm_loadu_si128 ( ( const __m128i * ) PrevWholeFrame ), average ) );
+      _mm_storeu_si128 ( ( __m128i * ) WholeFrame, v );
+      acc = _mm_add_epi32 ( acc, _mm_madd_epi16 ( v, ones ) );
+#else
+      if ( !UnpackVfcGroup ( CompPtr, state, Val ) )
+      {
+        printf ( "corrupt file\n" );
+        if ( !ignoreErrors )
+          exit ( 2 );
+      }
+      for ( int i = 0; i < 8; i++ )
+      {
+        if ( state != 16 )
+          Val[i] -= 1 << ( state-1 );
+        Val[i] <<= leftShift;
+        Val[i] += PrevWholeFrame[i] + RegionAverage;
+        total += Val[i];
+        WholeFrame[i] = Val[i];
+      }
+#endif
+    }
+  }
+#ifdef __SSE2__
+  acc = _mm_add_epi32 ( acc, _mm_srli_si128 ( acc, 8 ) );
+  acc = _mm_add_epi32 ( acc, _mm_srli_si128 ( acc, 4 ) );
+  total += ( unsigned int ) _mm_cvtsi128_si32 ( acc );
+#endif
+  return total;
+}
+
+struct VfcFrame
+{
+  const unsigned char *data; // pixels, or the region offsets followed by the regions
+  unsigned int compressed;
+  unsigned int Transitions;
+  unsigned int total;
+  unsigned int end_offset;
+};
+
+// one band of region rows, decoded through all frames
+struct VfcBand
+{
+  const VfcFrame *frames;
+  int numFrames;
+  unsigned short *out;
+  int rows, cols;
+  int x_region_size, y_region_size;
+  int num_regions_x;
+  int first_region_row, end_region_row;
+  int *regionalT0;
+  int ignoreErrors;
+  std::vector<unsigned int> totals;      // per frame, this band only
+  std::vector<unsigned int> Transitions; // per frame, this band only
+};
+
+static void *DecodeVfcBand ( void *arg )
+{
+  VfcBand *band = ( VfcBand * ) arg;
+  size_t frameStride = ( size_t ) band->rows * band->cols;
+  int row_start = band->first_region_row * band->y_region_size;
+  int row_end = std::min ( band->rows, band->end_region_row * band->y_region_size );
+
+  for ( int frame = 0; frame < band->numFrames; frame++ )
+  {
+    const VfcFrame &hdr = band->frames[frame];
+    unsigned short *WholeFrame = band->out + frame * frameStride;
+
+    if ( !hdr.compressed )
+    {
+      for ( int y = row_start; y < row_end; y++ )
+        CopySwappedSamples ( WholeFrame + ( size_t ) y * band->cols, hdr.data + ( size_t ) 2 * y * band->cols, band->cols );
+      continue;
+    }
+
+    const unsigned short *PrevWholeFrame = WholeFrame - frameStride;
+    unsigned int total = 0;
+    unsigned int Transitions = 0;
+    for ( int y_reg = band->first_region_row; y_reg < band->end_region_row; y_reg++ )
+    {
+      for ( int x_reg = 0; x_reg < band->num_regions_x; x_reg++ )
+      {
+        int reg = y_reg * band->num_regions_x + x_reg;
+        uint32_t roff;
+        memcpy ( &roff, hdr.data + 4*reg, 4 );
+        roff = BYTE_SWAP_4 ( roff );
+
+        int nelems_x = std::min ( band->x_region_size, band->cols - x_reg * band->x_region_size );
+        int nelems_y = std::min ( band->y_region_size, band->rows - y_reg * band->y_region_size );
+        int realx = x_reg * band->x_region_size;
+        int realy = y_reg * band->y_region_size;
+
+        if ( roff == 0xFFFFFFFF )
+        {
+          // region not in this frame, carry the previous one forward
+          for ( int y = 0; y < nelems_y; y++ )
+            memcpy ( WholeFrame + ( size_t ) ( realy + y ) * band->cols + realx,
+                     PrevWholeFrame + ( size_t ) ( realy + y ) * band->cols + realx, nelems_x * sizeof ( short ) );
+          continue;
+        }
+        if ( band->regionalT0[reg] == -1 )
+          band->regionalT0[reg] = ( frame == 1 ) ? -2 : frame;
+
+        total += DecodeVfcRegion ( hdr.data + roff - sizeof ( struct _expmt_hdr_cmp_frame ) + 8, hdr.compressed,
+                                   WholeFrame, PrevWholeFrame, band->cols, realx, realy, nelems_x, nelems_y,
+                                   Transitions, band->ignoreErrors );
+      }
+    }
+    band->totals[frame] = total;
+    band->Transitions[frame] = Transitions;
+  }
+  return NULL;
+}
+
+// Whole image version of LoadCompressedRegionImage.  Maps the file once, walks the
+// frame headers, then decodes bands of region rows through all frames in parallel:
+// a region only depends on the same region of the previous frame.  Returns -1 without
+// touching fd if the image can't be decoded this way.
+static int LoadCompressedRegionImageBanded ( DeCompFile *fd, short *out, int rows, int cols, int totalFrames,
+                                             int end_frame, int *timestamps, int x_region_size, int y_region_size,
+                                             unsigned int offset, int ignoreErrors )
+{
+  size_t fileLen = fd->fileLen;
+  if ( fileLen == 0 || x_region_size <= 0 || y_region_size <= 0 )
+    return -1;
+  const unsigned char *file = ( const unsigned char * ) mmap ( 0, fileLen, PROT_READ, MAP_PRIVATE, fd->hFile, 0 );
+  if ( file == MAP_FAILED )
+    return -1;
+  madvise ( ( void * ) file, fileLen, MADV_SEQUENTIAL );
+
+  int num_regions_x = ( cols + x_region_size - 1 ) / x_region_size;
+  int num_regions_y = ( rows + y_region_size - 1 ) / y_region_size;
+  int numRegions = num_regions_x * num_regions_y;
+  int frameLen = rows * cols * 2;
+  const int hdrLen = sizeof ( struct _expmt_hdr_cmp_frame ) - 8;
+
+#define VFC_FAIL(msg) \
+  { \
+    printf ( msg ); \
+    munmap ( ( void * ) file, fileLen ); \
+    CloseFile ( fd ); \
+    if ( ignoreErrors&IGNORE_ALWAYS_RETURN ) \
+      return 0; \
+    else \
+      exit ( -1 ); \
+  }
+
+  // walk the frame headers
+  std::vector<VfcFrame> frames ( end_frame + 1 );
+  for ( int frame = 0; frame <= end_frame; frame++ )
+  {
+    VfcFrame &hdr = frames[frame];
+    if ( offset + 8 > fileLen )
+      VFC_FAIL ( "corrupt file! Failed to get file data\n" );
+    unsigned int timestamp;
+    memcpy ( &timestamp, file + offset, 4 );
+    memcpy ( &hdr.compressed, file + offset + 4, 4 );
+    ByteSwap4 ( timestamp );
+    ByteSwap4 ( hdr.compressed );
+    offset += 8;
+    if ( timestamps )
+      timestamps[frame] = timestamp;
+
+    if ( frame == 0 && hdr.compressed )
+    {
+      // nothing to take the deltas from, leave it to the general reader
+      munmap ( ( void * ) file, fileLen );
+      return -1;
+    }
+
+    if ( !hdr.compressed )
+    {
+      if ( offset + frameLen > fileLen )
+        VFC_FAIL ( "corrupt file\n" );
+      hdr.data = file + offset;
+      offset += frameLen;
+      hdr.end_offset = offset;
+      continue;
+    }
+
+    if ( offset + hdrLen > fileLen )
+      VFC_FAIL ( "corrupt file! Failed to get file data\n" );
+    struct _expmt_hdr_cmp_frame frameHdr;
+    memcpy ( &frameHdr.len, file + offset, hdrLen );
+    ByteSwap4 ( frameHdr.Transitions );
+    ByteSwap4 ( frameHdr.len );
+    ByteSwap4 ( frameHdr.sentinel );
+    ByteSwap4 ( frameHdr.total );
+    if ( frameHdr.sentinel != PLACEKEY )
+    {
+      printf ( "corrupt file!  No Sentinel\n" );
+      if ( !ignoreErrors )
+        exit ( 2 );
+    }
+    offset += hdrLen;
+
+    unsigned int len = frameHdr.len - sizeof ( frameHdr ) + 8;
+    if ( offset + len > fileLen || len < ( unsigned int ) numRegions * 4 )
+      VFC_FAIL ( "Failed to get file data.\n" );
+    hdr.data = file + offset;
+    hdr.Transitions = frameHdr.Transitions;
+    hdr.total = frameHdr.total;
+    offset += len;
+    hdr.end_offset = offset;
+  }
+#undef VFC_FAIL
+
+  int *regionalT0 = ( int * ) malloc ( numRegions * sizeof ( int ) );
+  for ( int reg = 0; reg < numRegions; ++reg )
+    regionalT0[reg] = -1;
+
+  // regions are decoded 8 columns at a time, so a region row whose width isn't a multiple of 8
+  // spills its last group into the following row; only split the rows when nothing can spill
+  // into another band, otherwise decode in one band, in the order of the serial reader
+  int numBands = std::min ( GetDeInterlaceThreads(), num_regions_y );
+  if ( ( x_region_size % 8 ) != 0 || ( cols % 8 ) != 0 )
+    numBands = 1;
+  std::vector<VfcBand> bands ( numBands );
+  for ( int b = 0; b < numBands; b++ )
+  {
+    VfcBand &band = bands[b];
+    band.frames = &frames[0];
+    band.numFrames = end_frame + 1;
+    band.out = ( unsigned short * ) out;
+    band.rows = rows;
+    band.cols = cols;
+    band.x_region_size = x_region_size;
+    band.y_region_size = y_region_size;
+    band.num_regions_x = num_regions_x;
+    band.first_region_row = ( b * num_regions_y ) / numBands;
+    band.end_region_row = ( ( b + 1 ) * num_regions_y ) / numBands;
+    band.regionalT0 = regionalT0;
+    band.ignoreErrors = ignoreErrors;
+    band.totals.assign ( end_frame + 1, 0 );
+    band.Transitions.assign ( end_frame + 1, 0 );
+  }
+
+  std::vector<pthread_t> threads ( numBands );
+  std::vector<bool> started ( numBands, false );
+  for ( int b = 1; b < numBands; b++ )
+    started[b] = ( pthread_create ( &threads[b], NULL, DecodeVfcBand, &bands[b] ) == 0 );
+  // the checksum covers everything up to the last frame read
+  unsigned int cksum = ByteSum ( file, offset );
+  DecodeVfcBand ( &bands[0] );
+  for ( int b = 1; b < numBands; b++ )
+  {
+    if ( started[b] )
+      pthread_join ( threads[b], NULL );
+    else
+      DecodeVfcBand ( &bands[b] );
+  }
+
+  for ( int frame = 1; frame <= end_frame; frame++ )
+  {
+    if ( !frames[frame].compressed )
+      continue;
+    unsigned int total = 0;
+    unsigned int Transitions = 0;
+    for ( int b = 0; b < numBands; b++ )
+    {
+      total += bands[b].totals[frame];
+      Transitions += bands[b].Transitions[frame];
+    }
+    if ( Transitions != frames[frame].Transitions )
+    {
+      printf ( "transitions don't match %x %x!!\n",Transitions,frames[frame].Transitions );
+      printf ( "corrupt file\n" );
+      if ( !ignoreErrors )
+        exit ( 2 );
+    }
+    if ( total != frames[frame].total )
+    {
+      printf ( "totals don't match!! %x %x %d\n",total,frames[frame].total,frames[frame].end_offset );
+      printf ( "corrupt file\n" );
+      if ( !ignoreErrors )
+        exit ( 2 );
+    }
+  }
+
+  // only interpolate for full time histories as the checks aren't sufficient for sub-sets
+  if ( ( totalFrames-1 ) == end_frame )
+    InterpolateFramesBeforeT0 ( regionalT0, out, rows, cols, 0, end_frame,
+                                0, 0, cols, rows, x_region_size, y_region_size, timestamps );
+
+  if ( ( end_frame >= ( totalFrames-1 ) ) && ( offset + 4 <= fileLen ) )
+  {
+    // there is a checksum?
+    const unsigned char *cksmPtr = file + offset;
+    unsigned int tmpcksum = cksmPtr[3];
+    tmpcksum |= cksmPtr[2] << 8;
+    tmpcksum |= cksmPtr[1] << 16;
+    tmpcksum |= cksmPtr[0] << 24;
+    if ( tmpcksum != cksum )
+    {
+      printf ( "checksums don't match %x %x %x-%x-%x-%x\n",cksum,tmpcksum,cksmPtr[0],cksmPtr[1],cksmPtr[2],cksmPtr[3] );
+      printf ( "corrupt file\n" );
+      if ( !ignoreErrors )
+        exit ( 2 );
+    }
+  }
+
+  free ( regionalT0 );
+  munmap ( ( void * ) file, fileLen );
+  CloseFile ( fd );
+  return 1;
+}
+#endif
+
 // inputs:
 //        fd:  input file descriptor
 //        out:  array of unsigned short pixel values (three-dimensional   frames:rows:cols
@@ -734,6 +1243,17 @@ int LoadCompressedRegionImage ( DeCompFile *fd, short *out, int rows, int cols,
   unInterlacedData = ( unsigned short * ) malloc ( 2*frameStride );
 #endif
 
+#if !defined(WIN32) && !defined(DEBUG)
+  if ( ( start_frame == 0 ) && ( mincols == 0 ) && ( minrows == 0 ) &&
+       ( maxcols == cols ) && ( maxrows == rows ) )
+  {
+    int rc = LoadCompressedRegionImageBanded ( fd, out, rows, cols, totalFrames, end_frame, timestamps,
+                                               x_region_size, y_region_size, offset, ignoreErrors );
+    if ( rc >= 0 )
+      return rc;
+  }
+#endif
+
   WholeFrameOrig = LocalWholeFrameOriginal = WholeFrame = ( unsigned short * ) malloc ( 2 * frameStride );
 
   uint32_t y_reg,x_reg,i;
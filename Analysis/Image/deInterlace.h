@@ -66,5 +66,9 @@ extern "C" int __declspec(dllexport) deInterlaceUncomp(
 #endif
         short *_out, int *_timestamps, int frames, int uncFrames, int stride, short *outUncomp, int *timestampsUncomp);
 
+#ifndef WIN32
+// threads used to decode one region compressed (VFC) image, 0 picks a default
+void SetDeInterlaceThreads ( int numThreads );
+#endif
 
 #endif // DEINTERLACE_H
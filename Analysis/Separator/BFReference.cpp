@@ -271,10 +271,9 @@ void BFReference::CalcDualReference(const std::string &datFile1, const std::stri
 bool BFReference::LoadImage(Image &img, const std::string &fileName) {
   bool loaded = false;
   if (doSdat) {
-    SynchDat sdat;
     TraceChunkSerializer readSerializer;
-    readSerializer.Read(fileName.c_str(), sdat);
-    img.InitFromSdat(&sdat);
+    readSerializer.SetNumThreads(numCores());
+    img.LoadSdat(fileName.c_str(), readSerializer);
     loaded = true;
   }
   else {
@@ -2027,8 +2027,6 @@ void DifferentialSeparator::LoadKeyDats(PJobQueue &jQueue, TraceStoreCol &traceS
   traceStore.SetSize(T0_RIGHT_OFFSET);
   traceStore.SetT0(mT0);
   Mask cncMask(&mMask);
-  Mat<float> traceSdMin(numWells, loadMinFlows);
-  traceSdMin.zeros();
   // Ready in the sdata data
   std::vector<LoadDatJob> loadJobs(loadMinFlows);
   char buff[resultsSuffix.size() + resultsRoot.size() + 21];
@@ -2041,7 +2039,8 @@ void DifferentialSeparator::LoadKeyDats(PJobQueue &jQueue, TraceStoreCol &traceS
     p = resultsRoot.c_str();
     s = resultsSuffix.c_str();
     snprintf (buff, sizeof (buff), "%s%.4d.%s", p, (int) i, s);
-    loadJobs[i].Init(buff, i, &traceStore, traceSdMin.colptr(i), &mMask, &cncMask, &mFilteredWells, &mT0, &opts);
+    // LoadDat doesn't fill in a per flow trace sd, so no wells x flows matrix for it
+    loadJobs[i].Init(buff, i, &traceStore, NULL, &mMask, &cncMask, &mFilteredWells, &mT0, &opts);
     //  loadJobs[i].Run();
     jQueue.AddJob(loadJobs[i]);
   }
@@ -2057,16 +2056,12 @@ void DifferentialSeparator::LoadKeyDats(PJobQueue &jQueue, TraceStoreCol &traceS
   mRefWells.resize(numWells, 0);
 
   traceSd.resize(numWells);
+  std::fill(traceSd.begin(), traceSd.end(), 0.0f);
   int non_filt_wells = 0;
-  for (size_t i = 0; i < traceSdMin.n_rows; i++) {
-    float mean = 0;
+  for (size_t i = 0; i < numWells; i++) {
     if (mFilteredWells[i] == GoodWell) {
       non_filt_wells++;
     }
-    for (size_t j = 0; j < traceSdMin.n_cols; j++) {
-      mean += traceSdMin(i,j);
-    }
-    traceSd[i] = sqrt(mean / traceSdMin.n_cols);
   }
   std::vector<float> comp_mad_stats;
   comp_mad_stats.reserve(non_filt_wells);
@@ -3460,22 +3455,72 @@ void DifferentialSeparator::DoBeadfindFlowAndT0(DifSepOpt &opts, Mask &mask, con
   img.Close();
 }
 
-void SmoothTraces(DifSepOpt &opts, TraceStoreCol &traceStore, Mask &mask, float *traceMad, char *filtWells) {
+/** 
+ * Job class for pca smoothing one region of one flow in the trace store. Regions
+ * don't share wells so a flow's regions can run together, the flows have to go
+ * in order as the residuals accumulate per well across them.
+ */
+class PcaSmoothJob : public PJob {
+public:
+  PcaSmoothJob() {
+    mRowStart = mRowEnd = mColStart = mColEnd = mFlowIx = 0;
+    mTraceStore = NULL;
+    mTraceMad = NULL;
+    mFiltWells = NULL;
+  }
+
+  void Init(int rowStart, int rowEnd, int colStart, int colEnd, int flowIx,
+            TraceStoreCol *traceStore, float *traceMad, char *filtWells) {
+    mRowStart = rowStart;
+    mRowEnd = rowEnd;
+    mColStart = colStart;
+    mColEnd = colEnd;
+    mFlowIx = flowIx;
+    mTraceStore = traceStore;
+    mTraceMad = traceMad;
+    mFiltWells = filtWells;
+  }
+
+  virtual void Run() {
+    mTraceStore->PcaLossyCompress(mRowStart, mRowEnd, mColStart, mColEnd, mFlowIx,
+                                  mTraceMad, mFiltWells,
+                                  2, 2, 6, &mStats);
+  }
+
+  int mRowStart, mRowEnd, mColStart, mColEnd;
+  int mFlowIx;
+  TraceStoreCol *mTraceStore;
+  float *mTraceMad;
+  char *mFiltWells;
+  LossyCompressStats mStats;
+};
+
+void SmoothTraces(PJobQueue &jQueue, DifSepOpt &opts, TraceStoreCol &traceStore, Mask &mask, float *traceMad, char *filtWells) {
   ClockTimer timer;
   if (opts.smoothTrace) {
     printf("Smoothing traces.\n");
     timer.PrintMicroSecondsUpdate(stdout, "Total Timer: Before smoothing traces.");
+    GridMesh<int> pcaMesh;
+    pcaMesh.Init (mask.H(), mask.W(), PCA_COMP_GRID_SIZE, PCA_COMP_GRID_SIZE);
+    std::vector<PcaSmoothJob> smoothJobs(pcaMesh.GetNumBin());
+    // chunks of a flow run in parallel on the queue, any cores left over project their bands
+    traceStore.SetLossyCompressThreads(opts.nCores / (int)pcaMesh.GetNumBin());
     for (size_t flow_ix = 0; flow_ix < traceStore.GetNumFlows(); flow_ix++) {
-      GridMesh<int> pcaMesh;
-      pcaMesh.Init (mask.H(), mask.W(), PCA_COMP_GRID_SIZE, PCA_COMP_GRID_SIZE);
       for (size_t binIx = 0; binIx < pcaMesh.GetNumBin(); binIx++) {
         int rowStart = -1, rowEnd = -1, colStart = -1, colEnd = -1;
         pcaMesh.GetBinCoords (binIx, rowStart, rowEnd, colStart, colEnd);
-        traceStore.PcaLossyCompress(rowStart, rowEnd, colStart, colEnd, flow_ix,
-                                    traceMad, filtWells,
-                                    2, 2, 6);
+        smoothJobs[binIx].Init(rowStart, rowEnd, colStart, colEnd, flow_ix,
+                               &traceStore, traceMad, filtWells);
+        jQueue.AddJob(smoothJobs[binIx]);
       }
+      jQueue.WaitUntilDone();
+    }
+    LossyCompressStats stats;
+    for (size_t binIx = 0; binIx < smoothJobs.size(); binIx++) {
+      stats.Add(smoothJobs[binIx].mStats);
     }
+    printf("Pca smoothed %d chunks, %.1f us per chunk, rms reconstruction error %.2f\n",
+           (int)stats.calls, stats.calls > 0 ? stats.micro_sec / stats.calls : 0.0, stats.RmsError());
     timer.PrintMicroSecondsUpdate(stdout, "Total Timer: After smoothing traces.");
   }
 }
@@ -3739,7 +3784,8 @@ int DifferentialSeparator::Run(DifSepOpt opts) {
   }
 
   // Smooth or not according to the options
-  SmoothTraces(opts, traceStore, mMask, &mTraceMad[0], &mFilteredWells.at(0));
+  mTraceMad.resize(mNumWells, 0.0f);
+  SmoothTraces(mQueue, opts, traceStore, mMask, &mTraceMad[0], &mFilteredWells.at(0));
 
   // Set the reference well sin the trace store and 
   for (size_t i = 0; i < mRefWells.size(); i++) { traceStore.SetReference(i, mRefWells[i] == 1); }
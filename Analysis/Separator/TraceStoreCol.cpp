@@ -10,6 +10,8 @@
 #define MIN_SAMPLE_WELL 100
 #define SMOOTH_REDUCE_STEP 10
 #define SMOOTH_REDUCE_REGION 100
+// wells per band for the banded pca projection, keeps the working matrices cache sized
+#define PCA_BAND_WELLS 4096
 #define INTEGRATION_START 6
 #define INTEGRATION_END 12
 void TraceStoreCol::WellProj(TraceStoreCol &store,
@@ -146,6 +148,7 @@ void TraceStoreCol::Init(Mask &mask, size_t frames, const char *flowOrder,
 
     pthread_mutex_init (&mLock, NULL);
     mUseMeshNeighbors = 1;
+    mLossyThreads = 1;
     mRowRefStep = rowStep;
     mColRefStep = colStep;
     mMinRefProbes = floor (mRowRefStep * mColRefStep * .1);
@@ -563,15 +566,103 @@ void TraceStoreCol::SplineLossyCompress(const std::string &strategy, int order,
 
 
 
+/* Shared state for the threads projecting the row bands of one pca chunk onto its basis. */
+struct PcaBandJob {
+  const Eigen::MatrixXf *SX;
+  const Eigen::MatrixXf *Basis;
+  const Eigen::VectorXf *col_mean;
+  int row_start, row_end, col_start, col_end;
+  size_t num_cols, num_frames;
+  size_t frame_stride, flow_frame_stride;
+  int flow_ix;
+  int16_t *data;
+  float *ssq;
+  int band_rows, num_bands;
+  volatile int next_band;
+  pthread_mutex_t lock;
+  double chunk_ssq;
+};
+
+static void *PcaBandWorker(void *arg) {
+  PcaBandJob &job = *(PcaBandJob *)arg;
+  Eigen::MatrixXf Y, B, Yhat;
+  int loc_num_cols = job.col_end - job.col_start;
+  int num_frames = (int)job.num_frames;
+  double band_ssq = 0;
+  int band;
+  while ((band = __sync_fetch_and_add(&job.next_band, 1)) < job.num_bands) {
+    int row_start = job.row_start + band * job.band_rows;
+    int row_end = min(row_start + job.band_rows, job.row_end);
+    int n = (row_end - row_start) * loc_num_cols;
+
+    // Copy the band's data into working matrix, frame major, less the chunk's frame means
+    Y.resize(n, num_frames);
+    for (int frame_ix = 0; frame_ix < num_frames; frame_ix++) {
+      float mean = job.col_mean->coeff(frame_ix);
+      float *y_start = Y.data() + n * frame_ix;
+      for (int row_ix = row_start; row_ix < row_end; row_ix++) {
+        int16_t *trace_start = job.data + job.flow_frame_stride * frame_ix + job.flow_ix * job.frame_stride + row_ix * job.num_cols + job.col_start;
+        int16_t *trace_end = trace_start + loc_num_cols;
+        while (trace_start != trace_end) {
+          *y_start++ = *trace_start++ - mean;
+        }
+      }
+    }
+
+    // Get coefficients to solve and uncompress data into yhat matrix, all wells in the band at once
+    B.noalias() = Y * job.SX->transpose();
+    Yhat.noalias() = B * job.Basis->transpose();
+
+    // Copy data out of yhat matrix into original data structure, keeping track of residuals
+    for (int frame_ix = 0; frame_ix < num_frames; frame_ix++) {
+      float mean = job.col_mean->coeff(frame_ix);
+      const float *y_start = Y.data() + n * frame_ix;
+      const float *yhat_start = Yhat.data() + n * frame_ix;
+      for (int row_ix = row_start; row_ix < row_end; row_ix++) {
+        size_t store_offset = row_ix * job.num_cols + job.col_start;
+        int16_t *trace_start = job.data + job.flow_frame_stride * frame_ix + job.flow_ix * job.frame_stride + store_offset;
+        int16_t *trace_end = trace_start + loc_num_cols;
+        float *ssq_start = job.ssq + store_offset;
+        while (trace_start != trace_end) {
+          float yhat = *yhat_start + mean;
+          *trace_start = (int16_t)(yhat + .5);
+          float val = (*y_start + mean) - yhat;
+          *ssq_start += val * val;
+          band_ssq += val * val;
+          y_start++;
+          yhat_start++;
+          trace_start++;
+          ssq_start++;
+        }
+      }
+    }
+
+    // divide ssq data out for per frame avg
+    for (int row_ix = row_start; row_ix < row_end; row_ix++) {
+      float *ssq_start = job.ssq + row_ix * job.num_cols + job.col_start;
+      float *ssq_end = ssq_start + loc_num_cols;
+      while (ssq_start != ssq_end) {
+        *ssq_start /= num_frames;
+        ssq_start++;
+      }
+    }
+  }
+  pthread_mutex_lock(&job.lock);
+  job.chunk_ssq += band_ssq;
+  pthread_mutex_unlock(&job.lock);
+  return NULL;
+}
+
 // Compress a block of a data using pca
 void TraceStoreCol::PcaLossyCompress(int row_start, int row_end,
                                      int col_start, int col_end,
                                      int flow_ix,
                                      float *ssq, char *filters,
                                      int row_step, int col_step,
-                                     int num_pca) {
+                                     int num_pca, LossyCompressStats *stats) {
 
-  Eigen::MatrixXf Ysub, Y, S, Basis;
+  ClockTimer timer;
+  Eigen::MatrixXf Ysub, S, Basis;
 
   int loc_num_wells = (col_end - col_start) * (row_end - row_start);
   int loc_num_cols = col_end - col_start;
@@ -632,25 +723,20 @@ void TraceStoreCol::PcaLossyCompress(int row_start, int row_end,
     }
   }
 
-  // Copy in all the data into working matrix
-  Y.resize(loc_num_wells, (int)mFrames);
+  // Mean of each frame over the whole chunk, subtracted off before the projection
+  Eigen::VectorXf col_mean(mFrames);
   for (int frame_ix = 0; frame_ix < (int)mFrames; frame_ix++) {
+    int64_t sum = 0;
     for (int row_ix = row_start; row_ix < row_end; row_ix++) {
-      size_t store_offset = row_ix * mCols + col_start;
-      int16_t *trace_start = &mData[0] + (mFlowFrameStride * frame_ix) + (flow_ix * mFrameStride) + store_offset;
+      int16_t *trace_start = &mData[0] + (mFlowFrameStride * frame_ix) + (flow_ix * mFrameStride) + row_ix * mCols + col_start;
       int16_t *trace_end = trace_start + loc_num_cols;
-      float * y_start = Y.data() + loc_num_wells * frame_ix + (row_ix - row_start) * loc_num_cols;
       while( trace_start != trace_end ) {
-        *y_start++ = *trace_start++;
+        sum += *trace_start++;
       }
     }
+    col_mean.coeffRef(frame_ix) = (float)((double)sum / loc_num_wells);
   }
-  Eigen::VectorXf col_mean = Y.colwise().sum();
-  col_mean /= Y.rows();
 
-  for (int i = 0; i < Y.cols(); i++) {
-    Y.col(i).array() -= col_mean.coeff(i);
-  }
   // Create scatter matrix
   S = Ysub.transpose() * Ysub;
   // Compute the eigenvectors
@@ -666,229 +752,51 @@ void TraceStoreCol::PcaLossyCompress(int row_start, int row_end,
   }
   // Create solver matrix, often not a good way of solving things but eigen vectors should be stable and fast
   Eigen::MatrixXf SX = (Basis.transpose() * Basis).inverse() * Basis.transpose();
-  // Get coefficients to solve
-  Eigen::MatrixXf B = Y * SX.transpose();
-  // Uncompress data into yhat matrix
-  Eigen::MatrixXf Yhat = B * Basis.transpose();
-
-  for (int i = 0; i < Yhat.cols(); i++) {
-    Yhat.col(i).array() += col_mean.coeff(i);
-    Y.col(i).array() += col_mean.coeff(i);
-  }
-  
-  // H5File h5("pca_lossy.h5");
-  // h5.Open();
-  // char buff[256];
-  // snprintf(buff, sizeof(buff), "/Y_%d_%d_%d", flow_ix, row_start, col_start);
-  // H5Eigen::WriteMatrix(h5, buff, Y);
-  // snprintf(buff, sizeof(buff), "/Yhat_%d_%d_%d", flow_ix, row_start, col_start);
-  // H5Eigen::WriteMatrix(h5, buff, Yhat);
-  // snprintf(buff, sizeof(buff), "/Basis_%d_%d_%d", flow_ix, row_start, col_start);
-  // H5Eigen::WriteMatrix(h5, buff, Basis);
-  // h5.Close();
-  // Copy data out of yhat matrix into original data structure, keeping track of residuals
-  for (int frame_ix = 0; frame_ix < (int)mFrames; frame_ix++) {
-    for (int row_ix = row_start; row_ix < row_end; row_ix++) {
-      size_t store_offset = row_ix * mCols + col_start;
-      int16_t *trace_start = &mData[0] + mFlowFrameStride * frame_ix + flow_ix * mFrameStride + store_offset;
-      int16_t *trace_end = trace_start + loc_num_cols;
-      float * ssq_start = ssq + store_offset;
-      size_t loc_offset = (row_ix - row_start) * loc_num_cols;
-      float * y_start = Y.data() + loc_num_wells * frame_ix + loc_offset;
-      float * yhat_start = Yhat.data() + loc_num_wells * frame_ix + loc_offset;
-      while( trace_start != trace_end ) {
-        *trace_start = (int16_t)(*yhat_start + .5);
-        float val = *y_start - *yhat_start;
-        *ssq_start += val * val;
-        y_start++;
-        yhat_start++;
-        trace_start++;
-        ssq_start++;
-      }
-    }
-  }
-
-  // divide ssq data out for per frame avg
-  for (int row_ix = row_start; row_ix < row_end; row_ix++) {
-    size_t store_offset = row_ix * mCols + col_start;
-    float * ssq_start = ssq + store_offset;
-    float * ssq_end = ssq_start + loc_num_cols;
-    while (ssq_start != ssq_end) {
-      *ssq_start /= mFrames;
-      ssq_start++;
-    }
+  // Project a band of rows at a time rather than the whole chunk so the working
+  // matrices stay cache sized, the bands don't share wells so they can go on separate threads.
+  PcaBandJob job;
+  job.SX = &SX;
+  job.Basis = &Basis;
+  job.col_mean = &col_mean;
+  job.row_start = row_start;
+  job.row_end = row_end;
+  job.col_start = col_start;
+  job.col_end = col_end;
+  job.num_cols = mCols;
+  job.num_frames = mFrames;
+  job.frame_stride = mFrameStride;
+  job.flow_frame_stride = mFlowFrameStride;
+  job.flow_ix = flow_ix;
+  job.data = &mData[0];
+  job.ssq = ssq;
+  job.band_rows = max(1, PCA_BAND_WELLS / max(loc_num_cols, 1));
+  job.num_bands = (row_end - row_start + job.band_rows - 1) / job.band_rows;
+  job.next_band = 0;
+  job.chunk_ssq = 0;
+  pthread_mutex_init(&job.lock, NULL);
+  int num_threads = min(mLossyThreads, job.num_bands);
+  vector<pthread_t> threads(max(num_threads, 1));
+  vector<bool> started(threads.size(), false);
+  for (int i = 1; i < num_threads; i++) {
+    started[i] = pthread_create(&threads[i], NULL, PcaBandWorker, &job) == 0;
+  }
+  PcaBandWorker(&job);
+  for (int i = 1; i < num_threads; i++) {
+    if (started[i]) {
+      pthread_join(threads[i], NULL);
+    }
+  }
+  pthread_mutex_destroy(&job.lock);
+
+  if (stats != NULL) {
+    stats->calls++;
+    stats->wells += loc_num_wells;
+    stats->values += (size_t)loc_num_wells * mFrames;
+    stats->ssq += job.chunk_ssq;
+    stats->micro_sec += timer.GetMicroSec();
   }
 }
 
-bool TraceStoreCol::PcaLossyCompressChunk(int row_start, int row_end,
-                                          int col_start, int col_end,
-                                          int num_rows, int num_cols, int num_frames,
-                                          int frame_stride,
-                                          int flow_ix, int flow_frame_stride,
-                                          short *data, bool replace,
-                                          float *ssq, char *filters,
-                                          int row_step, int col_step,
-                                          int num_pca) {
-
-  Eigen::MatrixXf Ysub, Y, S, Basis;
-
-  int loc_num_wells = (col_end - col_start) * (row_end - row_start);
-  int loc_num_cols = col_end - col_start;
-
-  // Take a sample of the data at rate step, avoiding flagged wells
-  // Count the good rows
-  int sample_wells = 0;
-  for (int row_ix = row_start; row_ix < row_end; row_ix+= row_step) {
-    char *filt_start = filters + row_ix * num_cols + col_start;
-    char *filt_end = filt_start + loc_num_cols;
-    while (filt_start < filt_end) {
-      if (*filt_start == 0) {
-        sample_wells++;
-      }
-      filt_start += col_step;
-    }
-  }
-  // try backing off to every well rather than just sampled if we didn't get enough
-  if (sample_wells < MIN_SAMPLE_WELL) {
-    row_step = 1;
-    col_step = 1;
-    int sample_wells = 0;
-    for (int row_ix = row_start; row_ix < row_end; row_ix+= row_step) {
-      char *filt_start = filters + row_ix * num_cols + col_start;
-      char *filt_end = filt_start + loc_num_cols;
-      while (filt_start < filt_end) {
-        if (*filt_start == 0) {
-          sample_wells++;
-        }
-        filt_start += col_step;
-      }
-    }
-  }
-
-  if (sample_wells < MIN_SAMPLE_WELL) {
-    return false; // just give up
-  }
-
-  // Got enough data to work with, zero out the ssq array for accumulation
-  for (int row_ix = row_start; row_ix < row_end; row_ix++) {
-    float *ssq_start = ssq + row_ix * num_cols + col_start;
-    float *ssq_end = ssq_start + loc_num_cols;
-    while (ssq_start != ssq_end) {
-      *ssq_start++ = 0;
-    }
-  }
-  // Copy the sampled data in Matrix, frame major
-  Ysub.resize(sample_wells, num_frames);
-  for (int frame_ix = 0; frame_ix < (int)num_frames; frame_ix++) {
-    int sample_offset = 0;
-    for (int row_ix = row_start; row_ix < row_end; row_ix+=row_step) {
-      size_t store_offset = row_ix * num_cols + col_start;
-      char *filt_start = filters + store_offset;
-      char *filt_end = filt_start + loc_num_cols;
-      int16_t *trace_start = data + (flow_frame_stride * frame_ix) + (flow_ix * frame_stride) + store_offset;
-      float *ysub_start = Ysub.data() + sample_wells * frame_ix + sample_offset;
-      while (filt_start < filt_end) {
-        if (*filt_start == 0) {
-          *ysub_start = *trace_start;
-          ysub_start++;
-          sample_offset++;
-        }
-        trace_start += col_step;
-        filt_start += col_step;
-      }
-    }
-  }
-
-  // Copy in all the data into working matrix
-  Y.resize(loc_num_wells, (int)num_frames);
-  for (int frame_ix = 0; frame_ix < (int)num_frames; frame_ix++) {
-    for (int row_ix = row_start; row_ix < row_end; row_ix++) {
-      size_t store_offset = row_ix * num_cols + col_start;
-      int16_t *trace_start = data + (flow_frame_stride * frame_ix) + (flow_ix * frame_stride) + store_offset;
-      int16_t *trace_end = trace_start + loc_num_cols;
-      float * y_start = Y.data() + loc_num_wells * frame_ix + (row_ix - row_start) * loc_num_cols;
-      while( trace_start != trace_end ) {
-        *y_start++ = *trace_start++;
-      }
-    }
-  }
-  Eigen::VectorXf col_mean = Y.colwise().sum();
-  col_mean /= Y.rows();
-
-  for (int i = 0; i < Y.cols(); i++) {
-    Y.col(i).array() -= col_mean.coeff(i);
-  }
-  // Create scatter matrix
-  S = Ysub.transpose() * Ysub;
-  // Compute the eigenvectors
-  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXf> es;
-  es.compute(S);
-  Eigen::MatrixXf Pca_Basis = es.eigenvectors();
-  Eigen::VectorXf Pca_Values = es.eigenvalues();
-  // Copy top eigen vectors into basis for projection
-  Basis.resize(num_frames, num_pca);
-  for (int i = 0; i < Basis.cols(); i++) {
-    //    Basis.col(i) = es.eigenvectors().col(es.eigenvectors().cols() - i -1);
-    Basis.col(i) = Pca_Basis.col(Pca_Basis.cols() - i - 1);
-  }
-  // Create solver matrix, often not a good way of solving things but eigen vectors should be stable and fast
-  Eigen::MatrixXf SX = (Basis.transpose() * Basis).inverse() * Basis.transpose();
-  // Get coefficients to solve
-  Eigen::MatrixXf B = Y * SX.transpose();
-  // Uncompress data into yhat matrix
-  Eigen::MatrixXf Yhat = B * Basis.transpose();
-
-  for (int i = 0; i < Yhat.cols(); i++) {
-    Yhat.col(i).array() += col_mean.coeff(i);
-    Y.col(i).array() += col_mean.coeff(i);
-  }
-  
-  // H5File h5("pca_lossy.h5");
-  // h5.Open();
-  // char buff[256];
-  // snprintf(buff, sizeof(buff), "/Y_%d_%d_%d", flow_ix, row_start, col_start);
-  // H5Eigen::WriteMatrix(h5, buff, Y);
-  // snprintf(buff, sizeof(buff), "/Yhat_%d_%d_%d", flow_ix, row_start, col_start);
-  // H5Eigen::WriteMatrix(h5, buff, Yhat);
-  // snprintf(buff, sizeof(buff), "/Basis_%d_%d_%d", flow_ix, row_start, col_start);
-  // H5Eigen::WriteMatrix(h5, buff, Basis);
-  // h5.Close();
-  // Copy data out of yhat matrix into original data structure, keeping track of residuals
-  for (int frame_ix = 0; frame_ix < (int)num_frames; frame_ix++) {
-    for (int row_ix = row_start; row_ix < row_end; row_ix++) {
-      size_t store_offset = row_ix * num_cols + col_start;
-      int16_t *trace_start = data + flow_frame_stride * frame_ix + flow_ix * frame_stride + store_offset;
-      int16_t *trace_end = trace_start + loc_num_cols;
-      float * ssq_start = ssq + store_offset;
-      size_t loc_offset = (row_ix - row_start) * loc_num_cols;
-      float * y_start = Y.data() + loc_num_wells * frame_ix + loc_offset;
-      float * yhat_start = Yhat.data() + loc_num_wells * frame_ix + loc_offset;
-      while( trace_start != trace_end ) {
-        if (replace) {
-          *trace_start = (int16_t)(*yhat_start + .5);
-        }
-        float val = *y_start - *yhat_start;
-        *ssq_start += val * val;
-        y_start++;
-        yhat_start++;
-        trace_start++;
-        ssq_start++;
-      }
-    }
-  }
-
-  // divide ssq data out for per frame avg
-  for (int row_ix = row_start; row_ix < row_end; row_ix++) {
-    size_t store_offset = row_ix * num_cols + col_start;
-    float * ssq_start = ssq + store_offset;
-    float * ssq_end = ssq_start + loc_num_cols;
-    while (ssq_start != ssq_end) {
-      *ssq_start /= num_frames;
-      ssq_start++;
-    }
-  }
-  return true;
-}
 
 void TraceStoreCol::SplineLossyCompress(const std::string &strategy, int order, int flow_ix, char *bad_wells, 
                                         float *mad, size_t num_rows, size_t num_cols, size_t num_frames, size_t num_flows,
@@ -16,6 +16,26 @@
 #define REF_REDUCTION_SIZE 10
 #define REF_SMOOTH_SIZE 100
 #define THUMBNAIL_SIZE 100
+
+/** Time and reconstruction error of lossy compression calls, for trading speed against accuracy. */
+struct LossyCompressStats {
+  LossyCompressStats() { Clear(); }
+  void Clear() { calls = wells = values = 0; micro_sec = ssq = 0; }
+  void Add(const LossyCompressStats &o) {
+    calls += o.calls;
+    wells += o.wells;
+    values += o.values;
+    micro_sec += o.micro_sec;
+    ssq += o.ssq;
+  }
+  double RmsError() const { return values > 0 ? sqrt(ssq / values) : 0; }
+  size_t calls;
+  size_t wells;
+  size_t values;    // wells * frames reconstructed
+  double micro_sec;
+  double ssq;       // sum of squared residuals over all the values
+};
+
 /**
  * Abstract interface to a repository for getting traces.
  */
@@ -35,6 +55,7 @@ class TraceStoreCol : public TraceStore
     mUseMeshNeighbors = 0;
     mRows = mCols = mFrames = mRowRefStep = mColRefStep = 0;
     mFrames = mFrameStride = mMaxDist = mFlowFrameStride = 0;
+    mLossyThreads = 1;
   }
 
   void Init(Mask &mask, size_t frames, const char *flowOrder,
@@ -54,21 +75,20 @@ class TraceStoreCol : public TraceStore
                                   float *mad, size_t num_rows, size_t num_cols, size_t num_frames, size_t num_flows,
                                   int use_mesh_neighbors, size_t frame_stride, size_t flow_frame_stride, int16_t *data);
 
+  /**
+   * Pca projection of one chunk of wells for a flow, the wells are projected a band of rows
+   * at a time with one matrix product per band and the bands are shared out over the threads
+   * set with SetLossyCompressThreads().
+   */
   void PcaLossyCompress(int row_start, int row_end,
                         int col_start, int col_end,
                         int flow_ix,
                         float *ssq, char *filters,
                         int row_step, int col_step,
-                        int num_pca);
-  static bool PcaLossyCompressChunk(int row_start, int row_end,
-                                    int col_start, int col_end,
-                                    int num_rows, int num_cols, int num_frames,
-                                    int frame_stride,
-                                    int flow_ix, int flow_frame_stride,
-                                    short *data, bool replace,
-                                    float *ssq, char *filters,
-                                    int row_step, int col_step,
-                                    int num_pca);
+                        int num_pca, LossyCompressStats *stats = NULL);
+
+  /** Threads used by each PcaLossyCompress() call. */
+  void SetLossyCompressThreads(int n) { mLossyThreads = std::max(1, n); }
 
   void SetFlowIndex (size_t flowIx, size_t index) {
     // no op, we store things in a specific flow order
@@ -304,6 +324,7 @@ class TraceStoreCol : public TraceStore
   // Cube<int8_t> mData;  // rows = frames, cols = wells,
   pthread_mutex_t mLock;
   int mUseMeshNeighbors;
+  int mLossyThreads;
   };
 
 #endif // TRACESTORECOL_H
@@ -14,6 +14,7 @@ class DeltaComp : public TraceCompressor {
 
 public:
   virtual int GetCompressionType() { return TraceCompressor::DeltaComp; }
+  virtual TraceCompressor *Clone() { return new DeltaComp(); }
   virtual void Compress(TraceChunk &chunk, int8_t **compressed, size_t *outsize, size_t *maxsize);
   virtual void Decompress(TraceChunk &chunk, const int8_t *compressed, size_t size);
   void compress(const std::vector<uint16_t>& data, size_t nRows, size_t nCols, size_t nFrames, std::vector<uint8_t> &compressed);
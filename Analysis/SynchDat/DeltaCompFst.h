@@ -16,6 +16,7 @@ public:
   DeltaCompFst() : mCompressed(NULL), mMaxSize(0), mSize(0) {}
   ~DeltaCompFst() { if (mCompressed != NULL) { free(mCompressed); } }
   virtual int GetCompressionType() { return TraceCompressor::DeltaCompFst; }
+  virtual TraceCompressor *Clone() { return new DeltaCompFst(); }
   virtual void Compress(TraceChunk &chunk, int8_t **compressed, size_t *outsize, size_t *maxsize);
   virtual void Decompress(TraceChunk &chunk, const int8_t *compressed, size_t size);
   void decompress(const int8_t *compressed, size_t size, TraceChunk &chunk);
@@ -16,6 +16,7 @@ public:
   DeltaCompFstSmX() : mWellsCompacted(20) {}
   ~DeltaCompFstSmX() {}
   virtual int GetCompressionType() { return TraceCompressor::DeltaCompFstSmX; }
+  virtual TraceCompressor *Clone() { return new DeltaCompFstSmX(); }
   virtual void Compress(TraceChunk &chunk, int8_t **compressed, size_t *outsize, size_t *maxsize);
   virtual void Decompress(TraceChunk &chunk, const int8_t *compressed, size_t size);
   void decompress(const int8_t *compressed, size_t size, TraceChunk &chunk);
@@ -14,6 +14,7 @@ public:
   SvdDatCompress(float precision, int numVec) { Init(precision, numVec); }
   void Init(float precision, int numVec) { mPrecision = precision; mNumEvec = numVec; }
   virtual int GetCompressionType() { return TraceCompressor::LossySvdDat; }
+  virtual TraceCompressor *Clone() { return new SvdDatCompress(mPrecision, mNumEvec); }
   virtual void Compress(TraceChunk &chunk, int8_t **compressed, size_t *outsize, size_t *maxsize);
   virtual void Decompress(TraceChunk &chunk, const int8_t *compressed, size_t size);
 private:
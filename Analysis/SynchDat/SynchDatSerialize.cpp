@@ -31,6 +31,7 @@ TraceChunkSerializer::TraceChunkSerializer() {
   mTotalTimeout = 100;  // 100 seconds before giving up.
   mDebugMsg = false;
   mUseSemaphore = false;
+  mNumThreads = 1;
   computeMicroSec = ioMicroSec = openMicroSec = compressMicroSec = 0;
 }
 
@@ -44,44 +45,175 @@ TraceChunkSerializer::~TraceChunkSerializer() {
   }
 }
 
+static void ChunkFromFlowChunk(const struct FlowChunk &fc, TraceChunk &tc) {
+  tc.mRowStart = fc.RowStart;
+  tc.mColStart = fc.ColStart;
+  tc.mFrameStart = fc.FrameStart;
+  tc.mFrameStep = fc.FrameStep;
+  tc.mChipRow = fc.ChipRow;
+  tc.mChipCol = fc.ChipCol;
+  tc.mChipFrame = fc.ChipFrame;
+  tc.mStartDetailedTime = fc.StartDetailedTime;
+  tc.mStopDetailedTime = fc.StopDetailedTime;
+  tc.mLeftAvg = fc.LeftAvg;
+  tc.mOrigFrames = fc.OrigFrames;
+  tc.mT0 = fc.T0;
+  tc.mSigma = fc.Sigma;
+  tc.mTMidNuc = fc.TMidNuc;
+  tc.mHeight = fc.Height;
+  tc.mWidth = fc.Width;
+  tc.mDepth = fc.Depth;
+  tc.mBaseFrameRate = fc.BaseFrameRate;
+  tc.mTimePoints.resize(tc.mDepth);
+  float * tmp = (float *)fc.DeltaFrame.p;
+  copy(tmp,tmp+fc.Depth, tc.mTimePoints.begin());
+}
+
+static void FlowChunkFromChunk(const TraceChunk &tc, struct FlowChunk &fc) {
+  fc.RowStart = tc.mRowStart;
+  fc.ColStart = tc.mColStart;
+  fc.FrameStart = tc.mFrameStart;
+  fc.FrameStep = tc.mFrameStep;
+  fc.ChipRow = tc.mChipRow;
+  fc.ChipCol = tc.mChipCol;
+  fc.ChipFrame = tc.mChipFrame;
+  fc.StartDetailedTime = tc.mStartDetailedTime;
+  fc.StopDetailedTime = tc.mStopDetailedTime;
+  fc.LeftAvg = tc.mLeftAvg;
+  fc.OrigFrames = tc.mOrigFrames;
+  fc.T0 = tc.mT0;
+  fc.Sigma = tc.mSigma;
+  fc.TMidNuc = tc.mTMidNuc;
+  fc.Height = tc.mHeight;
+  fc.Width = tc.mWidth;
+  fc.Depth = tc.mDepth;
+  fc.BaseFrameRate = tc.mBaseFrameRate;
+}
+
+/** 
+ * A pass over all the chunks of a flow. Either decompress readChunks into the mesh (or into
+ * a scratch chunk per thread that is handed to the consumer) or compress the mesh into writeChunks.
+ */
+struct ChunkCodecJob {
+  const struct FlowChunk *readChunks;
+  struct FlowChunk *writeChunks;
+  GridMesh<TraceChunk> *mesh;
+  TraceChunkConsumer *consumer;
+  size_t numChunks;
+  size_t maxSize; // starting size of each thread's compression buffer
+  volatile size_t nextChunk;
+  volatile size_t compressMicroSec;
+};
+
+struct ChunkCodecWorker {
+  ChunkCodecJob *job;
+  TraceCompressor *compressor;
+};
+
+static void *ChunkCodecThread(void *arg) {
+  ChunkCodecWorker *worker = (ChunkCodecWorker *)arg;
+  ChunkCodecJob &job = *worker->job;
+  TraceCompressor *compressor = worker->compressor;
+  TraceChunk scratch;
+  size_t maxSize = job.maxSize;
+  int8_t *compressed = job.writeChunks != NULL ? new int8_t[maxSize] : NULL;
+  size_t microSec = 0;
+  // chunks are claimed one at a time so a slow chunk doesn't hold up a whole slice of them
+  size_t bIx;
+  while ((bIx = __sync_fetch_and_add(&job.nextChunk, 1)) < job.numChunks) {
+    if (job.writeChunks != NULL) {
+      TraceChunk &tc = job.mesh->GetItem(bIx);
+      struct FlowChunk &fc = job.writeChunks[bIx];
+      fc.CompressionType = compressor->GetCompressionType();
+      FlowChunkFromChunk(tc, fc);
+      size_t outsize;
+      ClockTimer timer;
+      compressor->Compress(tc, &compressed, &outsize, &maxSize);
+      microSec += timer.GetMicroSec();
+      //cout <<"Doing: " << fc.CompressionType << " Bytes per wells: " << outsize/(float) (tc.mHeight * tc.mWidth) <<" Compression ratio: "<< tc.mData.size()*2/(float)outsize << endl;
+      fc.Data.p = (int8_t *)malloc(outsize*sizeof(int8_t));
+      memcpy(fc.Data.p, compressed, outsize*sizeof(int8_t));
+      fc.Data.len = outsize;
+      if (0 == outsize) {
+        cout << "How can there be zero blocks." << endl;
+      }
+      float * tmp = (float *)malloc(tc.mTimePoints.size() * sizeof(float));
+      copy(tc.mTimePoints.begin(), tc.mTimePoints.end(), tmp);
+      fc.DeltaFrame.p = tmp;
+      fc.DeltaFrame.len = tc.mTimePoints.size() * sizeof(float);
+    }
+    else {
+      const struct FlowChunk &fc = job.readChunks[bIx];
+      ION_ASSERT(fc.CompressionType == (size_t)compressor->GetCompressionType(), "Wrong compression type: " + ToStr(fc.CompressionType) + " vs: " + ToStr(compressor->GetCompressionType()));
+      TraceChunk &tc = job.consumer != NULL ? scratch : job.mesh->GetItem(bIx);
+      ChunkFromFlowChunk(fc, tc);
+      tc.mData.resize(fc.Height * fc.Width * fc.Depth);
+      ClockTimer timer;
+      compressor->Decompress(tc, (int8_t *)fc.Data.p, fc.Data.len);
+      microSec += timer.GetMicroSec();
+      if (job.consumer != NULL) {
+        job.consumer->Consume(tc);
+      }
+    }
+  }
+  delete [] compressed;
+  __sync_fetch_and_add(&job.compressMicroSec, microSec);
+  return NULL;
+}
+
+/** 
+ * Run job on up to numThreads threads including this one. The extra threads use clones of
+ * compressor; if it can't be cloned or a thread can't be started the rest just do more of the chunks.
+ */
+static size_t RunChunkCodecJob(ChunkCodecJob &job, TraceCompressor *compressor, int numThreads) {
+  job.nextChunk = 0;
+  job.compressMicroSec = 0;
+  numThreads = (int)min((size_t)max(numThreads, 1), max(job.numChunks, (size_t)1));
+  vector<TraceCompressor *> compressors(1, compressor);
+  for (int i = 1; i < numThreads; i++) {
+    TraceCompressor *clone = compressor->Clone();
+    if (clone == NULL) {
+      break;
+    }
+    compressors.push_back(clone);
+  }
+  vector<ChunkCodecWorker> workers(compressors.size());
+  vector<pthread_t> threads(compressors.size());
+  vector<bool> started(compressors.size(), false);
+  for (size_t i = 0; i < workers.size(); i++) {
+    workers[i].job = &job;
+    workers[i].compressor = compressors[i];
+  }
+  for (size_t i = 1; i < workers.size(); i++) {
+    started[i] = pthread_create(&threads[i], NULL, ChunkCodecThread, &workers[i]) == 0;
+  }
+  ChunkCodecThread(&workers[0]);
+  for (size_t i = 1; i < workers.size(); i++) {
+    if (started[i]) {
+      pthread_join(threads[i], NULL);
+    }
+    delete compressors[i];
+  }
+  return job.compressMicroSec;
+}
+
 void TraceChunkSerializer::DecompressFromReading(const struct FlowChunk *chunks, GridMesh<TraceChunk> &dataMesh) {
   compressMicroSec = 0;
-  for (size_t bIx = 0; bIx < dataMesh.GetNumBin(); bIx++) {
-    TraceChunk &tc = dataMesh.GetItem(bIx);
-    const struct FlowChunk &fc = chunks[bIx];
-    if (mCompressor == NULL) {
-      if (mDebugMsg) { cout << "Got compression type: " << chunks[bIx].CompressionType << endl;}
-      mCompressor = CompressorFactory::MakeCompressor((TraceCompressor::CodeType)chunks[bIx].CompressionType);
-    }
-    ION_ASSERT(chunks[bIx].CompressionType == (size_t)mCompressor->GetCompressionType(), "Wrong compression type: " + ToStr(chunks[bIx].CompressionType) + " vs: " + ToStr(mCompressor->GetCompressionType()));
-    tc.mRowStart = fc.RowStart;
-    tc.mColStart = fc.ColStart;
-    tc.mFrameStart = fc.FrameStart;
-    tc.mFrameStep = fc.FrameStep;
-    tc.mChipRow = fc.ChipRow;
-    tc.mChipCol = fc.ChipCol;
-    tc.mChipFrame = fc.ChipFrame;
-    tc.mStartDetailedTime = fc.StartDetailedTime;
-    tc.mStopDetailedTime = fc.StopDetailedTime;
-    tc.mLeftAvg = fc.LeftAvg;
-    tc.mOrigFrames = fc.OrigFrames;
-    tc.mT0 = fc.T0;
-    tc.mSigma = fc.Sigma;
-    tc.mTMidNuc = fc.TMidNuc;
-    tc.mHeight = fc.Height;
-    tc.mWidth = fc.Width;
-    tc.mDepth = fc.Depth;
-    tc.mBaseFrameRate = fc.BaseFrameRate;
-    size_t outsize = fc.Height * fc.Width * fc.Depth;
-    tc.mData.resize(outsize);
-    tc.mTimePoints.resize(tc.mDepth);
-    float * tmp = (float *)fc.DeltaFrame.p;
-    copy(tmp,tmp+fc.Depth, tc.mTimePoints.begin());
-    ClockTimer timer;
-    mCompressor->Decompress(tc, (int8_t *)fc.Data.p, fc.Data.len);
-    compressMicroSec += timer.GetMicroSec();
-    outsize = fc.Height * fc.Width * fc.Depth;
+  if (dataMesh.GetNumBin() == 0) {
+    return;
+  }
+  if (mCompressor == NULL) {
+    if (mDebugMsg) { cout << "Got compression type: " << chunks[0].CompressionType << endl;}
+    mCompressor = CompressorFactory::MakeCompressor((TraceCompressor::CodeType)chunks[0].CompressionType);
   }
+  ChunkCodecJob job;
+  job.readChunks = chunks;
+  job.writeChunks = NULL;
+  job.mesh = &dataMesh;
+  job.consumer = NULL;
+  job.numChunks = dataMesh.GetNumBin();
+  job.maxSize = 0;
+  compressMicroSec = RunChunkCodecJob(job, mCompressor, mNumThreads);
 }
   
 void TraceChunkSerializer::SetCompressor(TraceCompressor *compressor) {
@@ -97,50 +229,42 @@ void TraceChunkSerializer::ArrangeDataForWriting(GridMesh<TraceChunk> &dataMesh,
   if (dataMesh.GetNumBin() == 0) {
     return;
   }
-  size_t maxSize = dataMesh.mBins[0].mDepth * dataMesh.mBins[0].mHeight * dataMesh.mBins[1].mWidth * 3;
-  int8_t *compressed = new int8_t[maxSize];
-  compressMicroSec = 0;
-  for (size_t bIx = 0; bIx < dataMesh.GetNumBin(); bIx++) {
-    TraceChunk &tc = dataMesh.GetItem(bIx);
-    struct FlowChunk &fc = chunks[bIx];
-    fc.CompressionType = mCompressor->GetCompressionType();
-    fc.RowStart = tc.mRowStart;
-    fc.ColStart = tc.mColStart;
-    fc.FrameStart = tc.mFrameStart;
-    fc.FrameStep = tc.mFrameStep;
-    fc.ChipRow = tc.mChipRow;
-    fc.ChipCol = tc.mChipCol;
-    fc.ChipFrame = tc.mChipFrame;
-    fc.StartDetailedTime = tc.mStartDetailedTime;
-    fc.StopDetailedTime = tc.mStopDetailedTime;
-    fc.LeftAvg = tc.mLeftAvg;
-    fc.OrigFrames = tc.mOrigFrames;
-    fc.T0 = tc.mT0;
-    fc.Sigma = tc.mSigma;
-    fc.TMidNuc = tc.mTMidNuc;
-    fc.Height = tc.mHeight;
-    fc.Width = tc.mWidth;
-    fc.Depth = tc.mDepth;
-    fc.BaseFrameRate = tc.mBaseFrameRate;
-    size_t outsize;
-    ClockTimer timer;
-    mCompressor->Compress(tc, &compressed, &outsize, &maxSize);
-    compressMicroSec += timer.GetMicroSec();
-    //cout <<"Doing: " << fc.CompressionType << " Bytes per wells: " << outsize/(float) (tc.mHeight * tc.mWidth) <<" Compression ratio: "<< tc.mData.size()*2/(float)outsize << endl;
-    fc.Data.p = (int8_t *)malloc(outsize*sizeof(int8_t));
-    memcpy(fc.Data.p, compressed, outsize*sizeof(int8_t));
-    fc.Data.len = outsize;
-    if (0 == outsize) {
-      cout << "How can there be zero blocks." << endl;
-    }
-    float * tmp = (float *)malloc(tc.mTimePoints.size() * sizeof(float));
-    copy(tc.mTimePoints.begin(), tc.mTimePoints.end(), tmp);
-    fc.DeltaFrame.p = tmp;
-    fc.DeltaFrame.len = tc.mTimePoints.size() * sizeof(float);
-  }
-  delete [] compressed;
+  ChunkCodecJob job;
+  job.readChunks = NULL;
+  job.writeChunks = chunks;
+  job.mesh = &dataMesh;
+  job.consumer = NULL;
+  job.numChunks = dataMesh.GetNumBin();
+  job.maxSize = dataMesh.mBins[0].mDepth * dataMesh.mBins[0].mHeight * dataMesh.mBins[0].mWidth * 3;
+  compressMicroSec = RunChunkCodecJob(job, mCompressor, mNumThreads);
 }
 
+/* Compound type of struct FlowChunk as stored in the "FlowChunk" dataset. */
+static hid_t CreateFlowChunkType(hid_t charArrayType, hid_t charArrayType2) {
+  hid_t fcType = H5Tcreate(H5T_COMPOUND, sizeof(struct FlowChunk));
+  H5Tinsert(fcType, "CompressionType", HOFFSET(struct FlowChunk, CompressionType), H5T_NATIVE_B64);
+  H5Tinsert(fcType, "ChipRow", HOFFSET(struct FlowChunk, ChipRow), H5T_NATIVE_B64);
+  H5Tinsert(fcType, "ChipCol", HOFFSET(struct FlowChunk, ChipCol), H5T_NATIVE_B64);
+  H5Tinsert(fcType, "ChipFrame", HOFFSET(struct FlowChunk, ChipFrame), H5T_NATIVE_B64);
+  H5Tinsert(fcType, "RowStart", HOFFSET(struct FlowChunk, RowStart), H5T_NATIVE_B64);
+  H5Tinsert(fcType, "ColStart", HOFFSET(struct FlowChunk, ColStart), H5T_NATIVE_B64);
+  H5Tinsert(fcType, "FrameStart", HOFFSET(struct FlowChunk, FrameStart), H5T_NATIVE_B64);
+  H5Tinsert(fcType, "FrameStep", HOFFSET(struct FlowChunk, FrameStep), H5T_NATIVE_B64);
+  H5Tinsert(fcType, "Height", HOFFSET(struct FlowChunk, Height), H5T_NATIVE_B64);
+  H5Tinsert(fcType, "Width", HOFFSET(struct FlowChunk, Width), H5T_NATIVE_B64);
+  H5Tinsert(fcType, "Depth", HOFFSET(struct FlowChunk, Depth), H5T_NATIVE_B64);
+  H5Tinsert(fcType, "OrigFrames", HOFFSET(struct FlowChunk, OrigFrames), H5T_NATIVE_B64);
+  H5Tinsert(fcType, "StartDetailedTime", HOFFSET(struct FlowChunk, StartDetailedTime), H5T_NATIVE_INT);
+  H5Tinsert(fcType, "StopDetailedTime", HOFFSET(struct FlowChunk, StopDetailedTime), H5T_NATIVE_INT);
+  H5Tinsert(fcType, "LeftAvg", HOFFSET(struct FlowChunk, LeftAvg), H5T_NATIVE_INT);
+  H5Tinsert(fcType, "T0", HOFFSET(struct FlowChunk, T0), H5T_NATIVE_FLOAT);
+  H5Tinsert(fcType, "Sigma", HOFFSET(struct FlowChunk, Sigma), H5T_NATIVE_FLOAT);
+  H5Tinsert(fcType, "TMidNuc", HOFFSET(struct FlowChunk, TMidNuc), H5T_NATIVE_FLOAT);
+  H5Tinsert(fcType, "BaseFrameRate", HOFFSET(struct FlowChunk, BaseFrameRate), H5T_NATIVE_FLOAT);
+  H5Tinsert(fcType, "DeltaFrame", HOFFSET(struct FlowChunk, DeltaFrame), charArrayType2);
+  H5Tinsert(fcType, "Data", HOFFSET(struct FlowChunk, Data), charArrayType);
+  return fcType;
+}
 
 void InitSdatReadSem(void) {
   sdatSemPtr = NULL;
@@ -148,6 +272,10 @@ void InitSdatReadSem(void) {
 
 
 bool TraceChunkSerializer::Read(H5File &h5, GridMesh<TraceChunk> &dataMesh) {
+  return ReadChunks(h5, dataMesh, NULL, NULL);
+}
+
+bool TraceChunkSerializer::ReadChunks(H5File &h5, GridMesh<TraceChunk> &dataMesh, SynchDat *header, TraceChunkConsumer *consumer) {
   hid_t dataset = H5Dopen2(h5.GetFileId(), "FlowChunk", H5P_DEFAULT);
   //    hid_t datatype  = H5Dget_type(dataset);     /* datatype handle */
   static pthread_once_t onceControl = PTHREAD_ONCE_INIT;
@@ -166,28 +294,7 @@ bool TraceChunkSerializer::Read(H5File &h5, GridMesh<TraceChunk> &dataMesh) {
   hid_t fcDataSpace = H5Screate_simple(1, &dims[0], NULL);
   hid_t charArrayType = H5Tvlen_create (H5T_NATIVE_CHAR);
   hid_t charArrayType2 = H5Tvlen_create (H5T_NATIVE_CHAR);
-  hid_t fcType = H5Tcreate(H5T_COMPOUND, sizeof(struct FlowChunk));
-  H5Tinsert(fcType, "CompressionType", HOFFSET(struct FlowChunk, CompressionType), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "ChipRow", HOFFSET(struct FlowChunk, ChipRow), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "ChipCol", HOFFSET(struct FlowChunk, ChipCol), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "ChipFrame", HOFFSET(struct FlowChunk, ChipFrame), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "RowStart", HOFFSET(struct FlowChunk, RowStart), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "ColStart", HOFFSET(struct FlowChunk, ColStart), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "FrameStart", HOFFSET(struct FlowChunk, FrameStart), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "FrameStep", HOFFSET(struct FlowChunk, FrameStep), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "Height", HOFFSET(struct FlowChunk, Height), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "Width", HOFFSET(struct FlowChunk, Width), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "Depth", HOFFSET(struct FlowChunk, Depth), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "OrigFrames", HOFFSET(struct FlowChunk, OrigFrames), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "StartDetailedTime", HOFFSET(struct FlowChunk, StartDetailedTime), H5T_NATIVE_INT);
-  H5Tinsert(fcType, "StopDetailedTime", HOFFSET(struct FlowChunk, StopDetailedTime), H5T_NATIVE_INT);
-  H5Tinsert(fcType, "LeftAvg", HOFFSET(struct FlowChunk, LeftAvg), H5T_NATIVE_INT);
-  H5Tinsert(fcType, "T0", HOFFSET(struct FlowChunk, T0), H5T_NATIVE_FLOAT);
-  H5Tinsert(fcType, "Sigma", HOFFSET(struct FlowChunk, Sigma), H5T_NATIVE_FLOAT);
-  H5Tinsert(fcType, "TMidNuc", HOFFSET(struct FlowChunk, TMidNuc), H5T_NATIVE_FLOAT);
-  H5Tinsert(fcType, "BaseFrameRate", HOFFSET(struct FlowChunk, BaseFrameRate), H5T_NATIVE_FLOAT);
-  H5Tinsert(fcType, "DeltaFrame", HOFFSET(struct FlowChunk, DeltaFrame), charArrayType2);
-  H5Tinsert(fcType, "Data", HOFFSET(struct FlowChunk, Data), charArrayType);
+  hid_t fcType = CreateFlowChunkType(charArrayType, charArrayType2);
   ClockTimer timer;
   IonImageSem::Take();
   status = H5Dread(dataset, fcType, H5S_ALL, H5S_ALL, H5P_DEFAULT, mChunks);
@@ -197,7 +304,27 @@ bool TraceChunkSerializer::Read(H5File &h5, GridMesh<TraceChunk> &dataMesh) {
   timer.StartTimer();
   dataMesh.Init(mChunks[0].ChipRow, mChunks[0].ChipCol, mChunks[0].Height, mChunks[0].Width);
   ION_ASSERT(dataMesh.GetNumBin() == mNumChunks, "Didn't get number of chunks expected");
-  DecompressFromReading(mChunks, dataMesh);
+  if (consumer != NULL) {
+    // headers only in the mesh, the data goes to the consumer a chunk at a time
+    for (size_t bIx = 0; bIx < mNumChunks; bIx++) {
+      ChunkFromFlowChunk(mChunks[bIx], dataMesh.GetItem(bIx));
+    }
+    consumer->Prepare(*header);
+    if (mCompressor == NULL) {
+      mCompressor = CompressorFactory::MakeCompressor((TraceCompressor::CodeType)mChunks[0].CompressionType);
+    }
+    ChunkCodecJob job;
+    job.readChunks = mChunks;
+    job.writeChunks = NULL;
+    job.mesh = &dataMesh;
+    job.consumer = consumer;
+    job.numChunks = mNumChunks;
+    job.maxSize = 0;
+    compressMicroSec = RunChunkCodecJob(job, mCompressor, mNumThreads);
+  }
+  else {
+    DecompressFromReading(mChunks, dataMesh);
+  }
   computeMicroSec = timer.GetMicroSec();
   timer.StartTimer();
   status = H5Dvlen_reclaim(fcType, fcDataSpace, H5P_DEFAULT, mChunks);
@@ -224,28 +351,7 @@ bool TraceChunkSerializer::Write(H5File &h5, GridMesh<TraceChunk> &dataMesh) {
   hid_t fcDataSpace = H5Screate_simple(1, dims1, NULL);
   hid_t charArrayType = H5Tvlen_create (H5T_NATIVE_CHAR);
   hid_t charArrayType2 = H5Tvlen_create (H5T_NATIVE_CHAR);
-  hid_t fcType = H5Tcreate(H5T_COMPOUND, sizeof(struct FlowChunk));
-  H5Tinsert(fcType, "CompressionType", HOFFSET(struct FlowChunk, CompressionType), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "ChipRow", HOFFSET(struct FlowChunk, ChipRow), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "ChipCol", HOFFSET(struct FlowChunk, ChipCol), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "ChipFrame", HOFFSET(struct FlowChunk, ChipFrame), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "RowStart", HOFFSET(struct FlowChunk, RowStart), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "ColStart", HOFFSET(struct FlowChunk, ColStart), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "FrameStart", HOFFSET(struct FlowChunk, FrameStart), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "FrameStep", HOFFSET(struct FlowChunk, FrameStep), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "Height", HOFFSET(struct FlowChunk, Height), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "Width", HOFFSET(struct FlowChunk, Width), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "Depth", HOFFSET(struct FlowChunk, Depth), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "OrigFrames", HOFFSET(struct FlowChunk, OrigFrames), H5T_NATIVE_B64);
-  H5Tinsert(fcType, "StartDetailedTime", HOFFSET(struct FlowChunk, StartDetailedTime), H5T_NATIVE_INT);
-  H5Tinsert(fcType, "StopDetailedTime", HOFFSET(struct FlowChunk, StopDetailedTime), H5T_NATIVE_INT);
-  H5Tinsert(fcType, "LeftAvg", HOFFSET(struct FlowChunk, LeftAvg), H5T_NATIVE_INT);
-  H5Tinsert(fcType, "T0", HOFFSET(struct FlowChunk, T0), H5T_NATIVE_FLOAT);
-  H5Tinsert(fcType, "Sigma", HOFFSET(struct FlowChunk, Sigma), H5T_NATIVE_FLOAT);
-  H5Tinsert(fcType, "TMidNuc", HOFFSET(struct FlowChunk, TMidNuc), H5T_NATIVE_FLOAT);
-  H5Tinsert(fcType, "BaseFrameRate", HOFFSET(struct FlowChunk, BaseFrameRate), H5T_NATIVE_FLOAT);
-  H5Tinsert(fcType, "DeltaFrame", HOFFSET(struct FlowChunk, DeltaFrame), charArrayType2);
-  H5Tinsert(fcType, "Data", HOFFSET(struct FlowChunk, Data), charArrayType);
+  hid_t fcType = CreateFlowChunkType(charArrayType, charArrayType2);
   timer.StartTimer();
   hid_t dataset = H5Dcreate2(h5.GetFileId(), "FlowChunk", fcType, fcDataSpace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
   herr_t status = H5Dwrite(dataset, fcType, H5S_ALL, H5S_ALL, H5P_DEFAULT, mChunks);
@@ -264,6 +370,14 @@ bool TraceChunkSerializer::Write(H5File &h5, GridMesh<TraceChunk> &dataMesh) {
 }
 
 bool TraceChunkSerializer::Read(const char *filename, SynchDat &data) {
+  return ReadFile(filename, data, NULL);
+}
+
+bool TraceChunkSerializer::Read(const char *filename, SynchDat &header, TraceChunkConsumer &consumer) {
+  return ReadFile(filename, header, &consumer);
+}
+
+bool TraceChunkSerializer::ReadFile(const char *filename, SynchDat &data, TraceChunkConsumer *consumer) {
   data.Clear();
   if (!H5File::IsH5File(filename)) {
     return false;
@@ -292,8 +406,9 @@ bool TraceChunkSerializer::Read(const char *filename, SynchDat &data) {
 
     if (result) {
       h5.SetReadOnly(true);
-      result &= Read(h5, data.GetMesh());
+      // info first so a consumer has it when the chunk headers are in
       ReadInfo(h5, data);
+      result &= ReadChunks(h5, data.GetMesh(), &data, consumer);
     }
     h5.Close();
   }
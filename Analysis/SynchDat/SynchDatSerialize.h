@@ -3,6 +3,7 @@
 #ifndef SYNCHDATSERIALIZE_H
 #define SYNCHDATSERIALIZE_H
 #include <semaphore.h>
+#include <algorithm>
 #include "SynchDat.h"
 
 /* /\* shared mem sem.h *\/ */
@@ -42,6 +43,9 @@ public:
 
   virtual void Decompress(TraceChunk &chunk, const int8_t *compressed, size_t size) = 0;
 
+  /** New compressor with the same settings for another thread, NULL if this one can't be copied. */
+  virtual TraceCompressor *Clone() { return NULL; }
+
   virtual void ReallocBuffer(size_t newSize, int8_t **compressed, size_t *maxSize) {
     ION_ASSERT(newSize > *maxSize, "Shouldn't be resizing");
     if (*compressed != NULL) {
@@ -65,6 +69,8 @@ class TraceNoCompress : public TraceCompressor {
 public:
   virtual int GetCompressionType() { return 0; }
 
+  virtual TraceCompressor *Clone() { return new TraceNoCompress(); }
+
   virtual void Compress(TraceChunk &chunk, int8_t **compressed, size_t *outSize, size_t *maxSize) {
     size_t row = chunk.mHeight;
     size_t col = chunk.mWidth;
@@ -144,8 +150,28 @@ public:
   
 };
 
+/**
+ * Receives the chunks of a streamed read as they are decompressed, see
+ * TraceChunkSerializer::Read(const char *, SynchDat &, TraceChunkConsumer &).
+ */
+class TraceChunkConsumer {
+
+public:
+  virtual ~TraceChunkConsumer() {}
+
+  /** Called once before any chunk. header has the info and every chunk's metadata and time points but no data. */
+  virtual void Prepare(SynchDat &header) = 0;
+
+  /**
+   * Called from the decoding threads in no particular order. Chunks never overlap and
+   * the chunk is reused for the next one once this returns.
+   */
+  virtual void Consume(const TraceChunk &chunk) = 0;
+};
+
 /** 
  * Write collections of trace chunks to disk and read them back. 
+ * Chunks are compressed and decompressed by mNumThreads threads, each with its own compressor.
  */ 
 class TraceChunkSerializer {
   
@@ -163,6 +189,11 @@ public:
 
   bool Read(const char *filename, SynchDat &data);
   bool Write(const char *filename, SynchDat &data);
+  /** 
+   * Decompress straight into consumer rather than into data, which only gets the info and
+   * chunk headers. Only a chunk per thread is held decompressed at any time.
+   */
+  bool Read(const char *filename, SynchDat &header, TraceChunkConsumer &consumer);
   void ReadInfo(H5File &h5, SynchDat &sdat);
   int GetCompressionType() { return mCompressor->GetCompressionType(); }
   void SetCompressor(TraceCompressor *compressor);
@@ -173,7 +204,10 @@ public:
     mTotalTimeout = _total_timeout;
   }
   void SetUseSemaphore(bool use) { mUseSemaphore = use; }
+  // Threads compressing/decompressing chunks, the calling thread is one of them
+  void SetNumThreads(int numThreads) { mNumThreads = std::max(1, numThreads); }
   bool mUseSemaphore;
+  int mNumThreads;
   TraceCompressor *mCompressor;
   struct FlowChunk *mChunks;
   size_t mNumChunks;
@@ -184,7 +218,11 @@ public:
   size_t computeMicroSec;
   size_t ioMicroSec;
   size_t openMicroSec;
-  size_t compressMicroSec;
+  size_t compressMicroSec; // summed over the threads
+
+private:
+  bool ReadChunks(H5File &h5, GridMesh<TraceChunk> &dataMesh, SynchDat *header, TraceChunkConsumer *consumer);
+  bool ReadFile(const char *filename, SynchDat &data, TraceChunkConsumer *consumer);
 };
 
 #endif // SYNCHDATSERIALIZE_H
@@ -4,6 +4,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <sys/mman.h>
 
 #include "../util/tmap_error.h"
 #include "../util/tmap_alloc.h"
@@ -39,6 +40,33 @@ tmap_sa_read(const char *fn_fasta)
 
   sa = tmap_calloc(1, sizeof(tmap_sa_t), "sa");
 
+#ifdef TMAP_MMAP
+  size_t fp_length = 0;
+  tmap_bwt_int_t *sa_ptr = NULL;
+  tmap_bwt_int_t sa_intv;
+
+  sa_ptr = tmap_file_mmap(fp_sa, &fp_length);
+  if(NULL == sa_ptr || fp_length < 3*sizeof(tmap_bwt_int_t)) {
+      tmap_error(NULL, Exit, ReadFileError);
+  }
+  sa->mmap_fp = (void*)fp_sa;
+  sa->primary = sa_ptr[0];
+  sa_intv = sa_ptr[1];
+  sa->sa_intv = sa_intv;
+  sa->seq_len = sa_ptr[2];
+
+  sa->n_sa = (sa->seq_len + sa->sa_intv) / sa->sa_intv;
+  if(fp_length < (2 + sa->n_sa) * sizeof(tmap_bwt_int_t)) {
+      tmap_error(NULL, Exit, ReadFileError);
+  }
+  // the entries follow the three header words, so sa[0] overlays seq_len; make just that page
+  // copy-on-write and store the sentinel, the rest stays shared through the page cache
+  if(0 != mprotect(sa_ptr, sysconf(_SC_PAGESIZE), PROT_READ | PROT_WRITE)) {
+      tmap_error("could not make the first SA page writable", Exit, OutOfRange);
+  }
+  sa->sa = sa_ptr + 2;
+  sa->sa[0] = -1;
+#else
   if(1 != tmap_file_fread(&sa->primary, sizeof(tmap_bwt_int_t), 1, fp_sa)
      || 1 != tmap_file_fread(&sa->sa_intv, sizeof(tmap_bwt_int_t), 1, fp_sa)
      || 1 != tmap_file_fread(&sa->seq_len, sizeof(tmap_bwt_int_t), 1, fp_sa)) {
@@ -52,10 +80,11 @@ tmap_sa_read(const char *fn_fasta)
   if(sa->n_sa-1 != tmap_file_fread(sa->sa + 1, sizeof(tmap_bwt_int_t), sa->n_sa - 1, fp_sa)) {
       tmap_error(NULL, Exit, ReadFileError);
   }
+  tmap_file_fclose(fp_sa);
+#endif
 
   sa->sa_intv_log2 = tmap_log2(sa->sa_intv);
 
-  tmap_file_fclose(fp_sa);
   free(fn_sa);
 
   sa->is_shm = 0;
@@ -195,7 +224,12 @@ tmap_sa_destroy(tmap_sa_t *sa)
   free(sa);
   }
   else {
-  free(sa->sa);
+  if(sa->mmap_fp) {
+      tmap_file_fclose((tmap_file_t *)sa->mmap_fp); // unmaps sa->sa
+  }
+  else {
+      free(sa->sa);
+  }
   free(sa);
   }
 }
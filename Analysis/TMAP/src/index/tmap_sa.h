@@ -24,6 +24,7 @@ typedef struct {
     uint32_t is_shm;  /*!< 1 if loaded from shared memory, 0 otherwise */
     // Not stored in the file
     uint32_t sa_intv_log2;  /*!< the log2 suffix array interval (sampled) */
+    void *mmap_fp;  /*!< the memory-mapped SA file, NULL if sa was read into the heap */
 } tmap_sa_t;
 
 /*! 
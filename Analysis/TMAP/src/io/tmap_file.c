@@ -332,21 +332,50 @@ tmap_file_fread(void *ptr, size_t size, size_t count, tmap_file_t *fp)
   return num_read;
 }
 
+static int32_t tmap_file_mmap_hugepages = 0;
+
+void
+tmap_file_mmap_set_hugepages(int32_t hugepages)
+{
+  tmap_file_mmap_hugepages = hugepages;
+}
+
 void *
 tmap_file_mmap(tmap_file_t *fp, size_t *fp_length)
 {
-	  // size_t len;
+  struct stat statbuf;
+  void *ptr = NULL;
 
-	  struct stat statbuf;
-	  fstat ( fileno(fp->fp),&statbuf );
-	  fp->fileLen = statbuf.st_size;
+  if(TMAP_FILE_NO_COMPRESSION != fp->c || 0 != fstat(fileno(fp->fp), &statbuf)) {
+      return NULL;
+  }
+  fp->fileLen = statbuf.st_size;
 
-	  if(fp_length)
-		  *fp_length = fp->fileLen;
+  if(fp_length)
+      *fp_length = fp->fileLen;
 
-	  fp->CurrentAllocPtr = ( char * ) mmap ( 0,fp->fileLen,PROT_READ,MAP_PRIVATE,fileno(fp->fp),0);
+  // MAP_HUGETLB only works on hugetlbfs, so index files on a regular file system can
+  // only get huge pages through the transparent huge page advice below
+  ptr = mmap(0, fp->fileLen, PROT_READ, MAP_PRIVATE, fileno(fp->fp), 0);
+  if(MAP_FAILED == ptr) {
+      return NULL;
+  }
+  fp->CurrentAllocPtr = (char*)ptr;
+  fp->CurrentAllocLen = fp->fileLen;
+
+  if(1 == tmap_file_mmap_hugepages) {
+#ifdef MADV_HUGEPAGE
+      if(0 != madvise(ptr, fp->fileLen, MADV_HUGEPAGE)) {
+          tmap_error("transparent huge pages are not available for the index", Warn, OutOfRange);
+      }
+#endif
+      // start reading the pages in the background; already cached pages are simply shared
+      if(0 != madvise(ptr, fp->fileLen, MADV_WILLNEED)) {
+          tmap_error("could not start reading the index ahead", Warn, OutOfRange);
+      }
+  }
 
-	  return fp->CurrentAllocPtr;
+  return fp->CurrentAllocPtr;
 }
 
 int 
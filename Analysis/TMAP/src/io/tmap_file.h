@@ -46,12 +46,11 @@ typedef struct {
     int32_t n_unused;  /*!< for bz2 function 'BZ2_bzReadGetUnused' */
     int32_t bzerror;  /*!< stores the last BZ2 error */
     int32_t open_type;  /*!< the type of bzip2 stream */
-    char *CurrentAllocPtr;
-    int CurrentAllocLen;
+#endif
+    char *CurrentAllocPtr;  /*!< the mapping returned by tmap_file_mmap, unmapped on close */
+    size_t CurrentAllocLen;  /*!< the length of CurrentAllocPtr in bytes */
     size_t PageSize;
     size_t fileLen;
-
-#endif
 } tmap_file_t;
 
 extern tmap_file_t *tmap_file_stdout; // to use, initialize this in your main
@@ -120,11 +119,19 @@ tmap_file_fread2(tmap_file_t *fp, void *ptr, unsigned int len);
   emulates mmap
   @param  fp   pointer to the file structure from which to mmap
   @param  fp_length  return pointer to size of the file in bytes
-  @return      mmap'd pointer to the file data
+  @return      mmap'd pointer to the file data, NULL on failure
+  @details     the mapping is read-only and shared with other processes through the page cache
   */
 void *
 tmap_file_mmap(tmap_file_t *fp, size_t *fp_length);
 
+/*!
+  sets whether subsequent tmap_file_mmap calls advise huge pages and read-ahead
+  @param  hugepages  1 to madvise(MADV_HUGEPAGE) and madvise(MADV_WILLNEED) new mappings, 0 otherwise
+  */
+void
+tmap_file_mmap_set_hugepages(int32_t hugepages);
+
 
 /*! 
   emulates fgetc from stdio.h
@@ -25,6 +25,7 @@
 #include "../index/tmap_bwt_match_hash.h"
 #include "../index/tmap_sa.h"
 #include "../index/tmap_index.h"
+#include "../io/tmap_file.h"
 #include "../io/tmap_seqs_io.h"
 #include "../server/tmap_shm.h"
 #include "../sw/tmap_fsw.h"
@@ -514,47 +515,85 @@ static void cigar_log (const uint32_t* cigar, unsigned cigar_sz)
 }
 
 
-void
-tmap_map_driver_core_worker(sam_header_t *sam_header,
-                            tmap_seqs_t **seqs_buffer, 
-                            tmap_map_record_t **records, 
-                            tmap_map_bams_t **bams,
-                            int32_t seqs_buffer_length,
-                            int32_t *buffer_idx,
-                            tmap_index_t *index,
-                            tmap_map_driver_t *driver,
-                            tmap_map_stats_t *stat,
-                            tmap_rand_t *rand,
-                            // DVK - realigner
-                            struct RealignProxy* realigner,
-                            struct RealignProxy* context,
-                            int32_t do_pairing,
-                            int32_t tid)
-{
-  int32_t i, j, k, low = 0;
-  int32_t found;
-  tmap_seq_t ***seqs = NULL;
-  tmap_bwt_match_hash_t *hash=NULL;
-  int32_t max_num_ends = 0;
+// per thread scratch for mapping, kept across the buffers/batches a thread maps
+typedef struct {
+    tmap_seq_t ***seqs;
+    int32_t max_num_ends;
+    tmap_bwt_match_hash_t *hash;
+} tmap_map_driver_worker_scratch_t;
 
+static void
+tmap_map_driver_worker_scratch_init(tmap_map_driver_worker_scratch_t *scratch, tmap_map_driver_t *driver, int32_t tid)
+{
+  int32_t i;
+  scratch->hash = NULL;
 #ifdef TMAP_DRIVER_USE_HASH
   // init the occurence hash
-  hash = tmap_bwt_match_hash_init(); 
+  scratch->hash = tmap_bwt_match_hash_init(); 
 #endif
 
   // init memory
-  max_num_ends = 2;
-  seqs = tmap_malloc(sizeof(tmap_seq_t**)*max_num_ends, "seqs");
-  for(i=0;i<max_num_ends;i++) {
-      seqs[i] = tmap_calloc(4, sizeof(tmap_seq_t*), "seqs[i]");
+  scratch->max_num_ends = 2;
+  scratch->seqs = tmap_malloc(sizeof(tmap_seq_t**)*scratch->max_num_ends, "seqs");
+  for(i=0;i<scratch->max_num_ends;i++) {
+      scratch->seqs[i] = tmap_calloc(4, sizeof(tmap_seq_t*), "seqs[i]");
   }
   
   // initialize thread data
   tmap_map_driver_do_threads_init(driver, tid);
+}
+
+static void
+tmap_map_driver_worker_scratch_destroy(tmap_map_driver_worker_scratch_t *scratch, tmap_map_driver_t *driver, int32_t tid)
+{
+  int32_t i;
+  // free thread variables
+  for(i=0;i<scratch->max_num_ends;i++) 
+  {
+    free(scratch->seqs[i]);
+  }
+  free(scratch->seqs);
+  scratch->seqs = NULL;
+
+  // cleanup
+  tmap_map_driver_do_threads_cleanup(driver, tid);
+#ifdef TMAP_DRIVER_USE_HASH
+  // free hash
+  tmap_bwt_match_hash_destroy(scratch->hash);
+#endif
+  scratch->hash = NULL;
+}
+
+// maps and converts to BAM the reads in [low, high) with low % stride == offset
+static void
+tmap_map_driver_core_map(tmap_seqs_t **seqs_buffer, 
+                         tmap_map_record_t **records, 
+                         tmap_map_bams_t **bams,
+                         int32_t low,
+                         int32_t high,
+                         int32_t stride,
+                         int32_t offset,
+                         int32_t *buffer_idx,
+                         tmap_index_t *index,
+                         tmap_map_driver_t *driver,
+                         tmap_map_stats_t *stat,
+                         tmap_rand_t *rand,
+                         // DVK - realigner
+                         struct RealignProxy* realigner,
+                         struct RealignProxy* context,
+                         int32_t do_pairing,
+                         int32_t tid,
+                         tmap_map_driver_worker_scratch_t *scratch)
+{
+  int32_t i, j, k;
+  int32_t found;
+  tmap_seq_t ***seqs = scratch->seqs;
+  tmap_bwt_match_hash_t *hash = scratch->hash;
+  int32_t max_num_ends = scratch->max_num_ends;
 
   // Go through the buffer
-  while(low < seqs_buffer_length) {
-      if(tid == (low % driver->opt->num_threads)) {
+  while(low < high) {
+      if(offset == (low % stride)) {
           tmap_map_stats_t *stage_stat = NULL;
           tmap_map_record_t *record_prev = NULL;
           int32_t num_ends;
@@ -1221,24 +1260,38 @@ tmap_map_driver_core_worker(sam_header_t *sam_header,
           tmap_map_record_destroy (record_prev);
       }
       // next
-      (*buffer_idx) = low;
+      if(NULL != buffer_idx) (*buffer_idx) = low;
       low++;
   }
-  (*buffer_idx) = seqs_buffer_length;
+  if(NULL != buffer_idx) (*buffer_idx) = high;
 
-  // free thread variables
-  for(i=0;i<max_num_ends;i++) 
-  {
-    free(seqs[i]);
-  }
-  free(seqs);
+  // keep any growth for the next call
+  scratch->seqs = seqs;
+  scratch->max_num_ends = max_num_ends;
+}
 
-  // cleanup
-  tmap_map_driver_do_threads_cleanup(driver, tid);
-#ifdef TMAP_DRIVER_USE_HASH
-  // free hash
-  tmap_bwt_match_hash_destroy(hash);
-#endif
+void
+tmap_map_driver_core_worker(sam_header_t *sam_header,
+                            tmap_seqs_t **seqs_buffer, 
+                            tmap_map_record_t **records, 
+                            tmap_map_bams_t **bams,
+                            int32_t seqs_buffer_length,
+                            int32_t *buffer_idx,
+                            tmap_index_t *index,
+                            tmap_map_driver_t *driver,
+                            tmap_map_stats_t *stat,
+                            tmap_rand_t *rand,
+                            // DVK - realigner
+                            struct RealignProxy* realigner,
+                            struct RealignProxy* context,
+                            int32_t do_pairing,
+                            int32_t tid)
+{
+  tmap_map_driver_worker_scratch_t scratch;
+  tmap_map_driver_worker_scratch_init(&scratch, driver, tid);
+  tmap_map_driver_core_map(seqs_buffer, records, bams, 0, seqs_buffer_length, driver->opt->num_threads, tid, buffer_idx,
+                           index, driver, stat, rand, realigner, context, do_pairing, tid, &scratch);
+  tmap_map_driver_worker_scratch_destroy(&scratch, driver, tid);
 }
 
 void *
@@ -1253,6 +1306,31 @@ tmap_map_driver_core_thread_worker(void *arg)
   return arg;
 }
 
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+// keeps a random sample of the reads at the front of the buffer, returns how many were kept
+static int32_t
+tmap_map_driver_sample_reads(tmap_seqs_t **seqs_buffer, int32_t seqs_buffer_length, 
+                             tmap_map_driver_t *driver, tmap_rand_t *rand_core)
+{
+  int32_t i, j;
+  if(driver->opt->sample_reads < 1) {
+      for(i=j=0;i<seqs_buffer_length;i++) {
+          if(driver->opt->sample_reads < tmap_rand_get(rand_core)) continue; // skip
+          if(j < i) {
+              tmap_seqs_t *seqs;
+              seqs = seqs_buffer[j];
+              seqs_buffer[j] = seqs_buffer[i]; 
+              seqs_buffer[i] = seqs;
+          }
+          j++;
+      }
+      tmap_progress_print2("sampling %d out of %d [%.2lf%%]", j, seqs_buffer_length, 100.0*j/(double)seqs_buffer_length);
+      seqs_buffer_length = j;
+  }
+  return seqs_buffer_length;
+}
+#endif
+
 //static inline void
 static int32_t
 tmap_map_driver_create_threads(sam_header_t *header,
@@ -1277,31 +1355,12 @@ tmap_map_driver_create_threads(sam_header_t *header,
 #endif
                                int32_t do_pairing)
 {
-#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
-  int32_t j;
-#endif
   int32_t buffer_idx; // buffer index for processing data with a single thread
 
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
   // sample reads
-  {
-      int32_t i;
-      if(driver->opt->sample_reads < 1) {
-          for(i=j=0;i<seqs_buffer_length;i++) {
-              if(driver->opt->sample_reads < tmap_rand_get(rand_core)) continue; // skip
-              if(j < i) {
-                  tmap_seqs_t *seqs;
-                  seqs = seqs_buffer[j];
-                  seqs_buffer[j] = seqs_buffer[i]; 
-                  seqs_buffer[i] = seqs;
-              }
-              j++;
-          }
-          tmap_progress_print2("sampling %d out of %d [%.2lf%%]", j, seqs_buffer_length, 100.0*j/(double)seqs_buffer_length);
-          seqs_buffer_length = j;
-          if(0 == seqs_buffer_length) return 0;
-      }
-  }
+  seqs_buffer_length = tmap_map_driver_sample_reads(seqs_buffer, seqs_buffer_length, driver, rand_core);
+  if(0 == seqs_buffer_length) return 0;
 #endif
 
   // do alignment
@@ -1549,47 +1608,375 @@ tmap_map_driver_infer_pairing(tmap_seqs_io_t *io_in,
   return seqs_buffer_length;
 }
 
+static void
+tmap_map_driver_print_progress(tmap_map_driver_t *driver, tmap_map_stats_t *stat, uint32_t n_reads_processed)
+{
+  tmap_progress_print2("processed %d reads", n_reads_processed);
+  tmap_progress_print2("stats [%.2lf,%.2lf,%.2lf,%.2lf,%.2lf,%.2lf]",
+                       stat->num_with_mapping * 100.0 / (double)stat->num_reads,
+                       stat->num_after_seeding/(double)stat->num_with_mapping,
+                       stat->num_after_grouping/(double)stat->num_with_mapping,
+                       stat->num_after_scoring/(double)stat->num_with_mapping,
+                       stat->num_after_rmdup/(double)stat->num_with_mapping,
+                       stat->num_after_filter/(double)stat->num_with_mapping);
+  if (driver->opt->do_repeat_clip)
+  {
+      tmap_progress_print2("total %llu, mapped %llu, clipped %llu, rejected %llu, %.2f%% bases]",
+                            stat->num_reads,
+                            stat->num_with_mapping,
+                            stat->num_tailclipped,
+                            stat->num_fully_tailclipped,
+                            ((double) stat->bases_tailclipped) * 100 / stat->bases_seen_tailclipped
+      );
+  }
+}
+
+static void
+tmap_map_driver_write_bams(tmap_sam_io_t *io_out, tmap_map_bams_t **bams, int32_t n)
+{
+  int32_t i, j, k;
+  for(i=0;i<n;i++) {
+      for(j=0;j<bams[i]->n;j++) { // for each end
+          for(k=0;k<bams[i]->bams[j]->n;k++) { // for each hit
+              bam1_t *b = NULL;
+              b = bams[i]->bams[j]->bams[k]; // that's a lot of BAMs
+              if(NULL == b) tmap_bug();
+              if(samwrite(io_out->fp, b) <= 0) {
+                  tmap_error("Error writing the SAM file", Exit, WriteFileError);
+              }
+          }
+      }
+      tmap_map_bams_destroy(bams[i]);
+      bams[i] = NULL;
+  }
+}
+
 #ifdef HAVE_LIBPTHREAD
+/*
+  Streaming pipeline for the main mapping pass: a reader thread fills small
+  batches of reads, the mapping threads take whichever batch is next, and
+  the calling thread writes the batches back out in input order as they
+  complete.  A slow read only holds up the writer, the other threads keep
+  mapping later batches until the ring of batches is full, and the reads
+  in memory are bounded by the ring instead of reads_queue_size.
+ */
+
+// reads per batch, small so one long or repetitive read only holds up its own batch
+#define TMAP_MAP_DRIVER_BATCH_SIZE 256
+// batches in flight per mapping thread
+#define TMAP_MAP_DRIVER_BATCHES_PER_THREAD 4
+
+enum {
+    TMAP_MAP_DRIVER_BATCH_FREE = 0, // waiting for the reader
+    TMAP_MAP_DRIVER_BATCH_READY, // read, waiting for a mapping thread
+    TMAP_MAP_DRIVER_BATCH_MAPPING, // being mapped
+    TMAP_MAP_DRIVER_BATCH_DONE // mapped, waiting for the writer
+};
+
 typedef struct {
-    tmap_seqs_io_t *io_in;
-    tmap_sam_io_t *io_out;
     tmap_seqs_t **seqs_buffer;
-    int32_t seqs_buffer_length;
-    int32_t reads_queue_size;
-} tmap_map_driver_thread_io_data_t;
+    tmap_map_record_t **records;
+    tmap_map_bams_t **bams;
+    int32_t n;
+    int32_t state;
+    int64_t seq; // sequence number, seeds the random numbers for the batch
+} tmap_map_driver_batch_t;
+
+typedef struct {
+    tmap_map_driver_batch_t *batches;
+    int32_t num_batches;
+    int32_t batch_size;
+    // batch sequence numbers, batch i lives in batches[i % num_batches]
+    int64_t num_read;
+    int64_t num_claimed;
+    int64_t num_written;
+    int32_t eof;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    // reader
+    tmap_seqs_io_t *io_in;
+    sam_header_t *header;
+    tmap_seqs_t **preloaded; // reads already loaded when inferring the pairing, handed out first
+    int32_t preloaded_length;
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+    tmap_rand_t *rand_core;
+#endif
+    // mapping threads
+    tmap_index_t *index;
+    tmap_map_driver_t *driver;
+    tmap_map_stats_t *stat;
+    tmap_map_stats_t **stats;
+    tmap_rand_t **rand;
+    struct RealignProxy **realigner;
+    struct RealignProxy **context;
+} tmap_map_driver_pipeline_t;
+
+typedef struct {
+    tmap_map_driver_pipeline_t *pipeline;
+    int32_t tid;
+} tmap_map_driver_pipeline_thread_t;
 
 static void *
-tmap_map_driver_thread_io_worker(void *arg)
+tmap_map_driver_pipeline_reader(void *arg)
 {
-  tmap_map_driver_thread_io_data_t *d = (tmap_map_driver_thread_io_data_t*)arg;
-  d->seqs_buffer_length = tmap_seqs_io_read_buffer(d->io_in, d->seqs_buffer, d->reads_queue_size, d->io_out->fp->header->header);
-  return d;
+  tmap_map_driver_pipeline_t *p = (tmap_map_driver_pipeline_t*)arg;
+  int32_t preloaded_idx = 0;
+
+  while(1) {
+      tmap_map_driver_batch_t *batch = NULL;
+      int32_t n = 0;
+
+      pthread_mutex_lock(&p->mutex);
+      batch = &p->batches[p->num_read % p->num_batches];
+      while(TMAP_MAP_DRIVER_BATCH_FREE != batch->state) {
+          pthread_cond_wait(&p->cond, &p->mutex);
+      }
+      pthread_mutex_unlock(&p->mutex);
+
+      if(preloaded_idx < p->preloaded_length) {
+          // swap in the reads we already have
+          while(n < p->batch_size && preloaded_idx < p->preloaded_length) {
+              tmap_seqs_t *seqs = batch->seqs_buffer[n];
+              batch->seqs_buffer[n++] = p->preloaded[preloaded_idx];
+              p->preloaded[preloaded_idx++] = seqs;
+          }
+      }
+      else {
+          n = tmap_seqs_io_read_buffer(p->io_in, batch->seqs_buffer, p->batch_size, p->header);
+      }
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+      if(0 < n) {
+          n = tmap_map_driver_sample_reads(batch->seqs_buffer, n, p->driver, p->rand_core);
+          if(0 == n) continue; // nothing sampled, read some more
+      }
+#endif
+
+      pthread_mutex_lock(&p->mutex);
+      if(0 == n) {
+          p->eof = 1;
+      }
+      else {
+          batch->n = n;
+          batch->state = TMAP_MAP_DRIVER_BATCH_READY;
+          p->num_read++;
+      }
+      pthread_cond_broadcast(&p->cond);
+      pthread_mutex_unlock(&p->mutex);
+      if(0 == n) break;
+  }
+  return arg;
+}
+
+static void *
+tmap_map_driver_pipeline_mapper(void *arg)
+{
+  tmap_map_driver_pipeline_thread_t *thread = (tmap_map_driver_pipeline_thread_t*)arg;
+  tmap_map_driver_pipeline_t *p = thread->pipeline;
+  int32_t tid = thread->tid;
+  tmap_map_driver_worker_scratch_t scratch;
+
+  tmap_map_driver_worker_scratch_init(&scratch, p->driver, tid);
+  while(1) {
+      tmap_map_driver_batch_t *batch = NULL;
+
+      // take the next batch that has been read
+      pthread_mutex_lock(&p->mutex);
+      while(p->num_claimed == p->num_read && 0 == p->eof) {
+          pthread_cond_wait(&p->cond, &p->mutex);
+      }
+      if(p->num_claimed == p->num_read) { // no more reads
+          pthread_mutex_unlock(&p->mutex);
+          break;
+      }
+      batch = &p->batches[p->num_claimed % p->num_batches];
+      batch->state = TMAP_MAP_DRIVER_BATCH_MAPPING;
+      batch->seq = p->num_claimed++;
+      pthread_mutex_unlock(&p->mutex);
+
+      // which thread maps a batch varies from run to run, so the random numbers follow the batch instead
+      tmap_rand_reinit(p->rand[tid], batch->seq);
+
+      tmap_map_driver_core_map(batch->seqs_buffer, batch->records, batch->bams, 0, batch->n, 1, 0, NULL,
+                               p->index, p->driver, p->stats[tid], p->rand[tid], p->realigner[tid], p->context[tid],
+                               0, tid, &scratch);
+
+      pthread_mutex_lock(&p->mutex);
+      tmap_map_stats_add(p->stat, p->stats[tid]);
+      tmap_map_stats_zero(p->stats[tid]);
+      batch->state = TMAP_MAP_DRIVER_BATCH_DONE;
+      pthread_cond_broadcast(&p->cond);
+      pthread_mutex_unlock(&p->mutex);
+  }
+  tmap_map_driver_worker_scratch_destroy(&scratch, p->driver, tid);
+  return arg;
+}
+
+// writes the batches in input order as they are mapped, returns the number of reads written
+static uint32_t
+tmap_map_driver_pipeline_write(tmap_map_driver_pipeline_t *p, tmap_sam_io_t *io_out, int32_t reads_queue_size)
+{
+  uint32_t n_reads_processed = 0;
+  uint32_t next_progress = reads_queue_size;
+
+  while(1) {
+      tmap_map_driver_batch_t *batch = NULL;
+
+      pthread_mutex_lock(&p->mutex);
+      while(1) {
+          if(p->num_written < p->num_read) {
+              batch = &p->batches[p->num_written % p->num_batches];
+              if(TMAP_MAP_DRIVER_BATCH_DONE == batch->state) break;
+          }
+          else if(1 == p->eof) {
+              break;
+          }
+          pthread_cond_wait(&p->cond, &p->mutex);
+      }
+      if(p->num_written == p->num_read) { // all written
+          pthread_mutex_unlock(&p->mutex);
+          break;
+      }
+      pthread_mutex_unlock(&p->mutex);
+
+      tmap_map_driver_write_bams(io_out, batch->bams, batch->n);
+      n_reads_processed += batch->n;
+
+      pthread_mutex_lock(&p->mutex);
+      batch->state = TMAP_MAP_DRIVER_BATCH_FREE;
+      p->num_written++;
+      // print statistics about as often as we used to, once per reads queue
+      if(-1 != p->driver->opt->reads_queue_size && next_progress <= n_reads_processed) {
+          tmap_map_driver_print_progress(p->driver, p->stat, n_reads_processed);
+          next_progress = (n_reads_processed / reads_queue_size + 1) * reads_queue_size;
+      }
+      pthread_cond_broadcast(&p->cond);
+      pthread_mutex_unlock(&p->mutex);
+  }
+  return n_reads_processed;
+}
+
+static uint32_t
+tmap_map_driver_pipeline_run(tmap_seqs_io_t *io_in,
+                             tmap_sam_io_t *io_out,
+                             tmap_seqs_t **preloaded,
+                             int32_t preloaded_length,
+                             int32_t reads_queue_size,
+                             int32_t seq_type,
+                             tmap_index_t *index,
+                             tmap_map_driver_t *driver,
+                             tmap_map_stats_t *stat,
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+                             tmap_rand_t *rand_core,
+#endif
+                             tmap_rand_t **rand,
+                             tmap_map_stats_t **stats,
+                             struct RealignProxy** realigner,
+                             struct RealignProxy** context)
+{
+  int32_t i, j;
+  uint32_t n_reads_processed;
+  tmap_map_driver_pipeline_t p;
+  pthread_attr_t attr;
+  pthread_t thread_reader;
+  pthread_t *threads = NULL;
+  tmap_map_driver_pipeline_thread_t *thread_data = NULL;
+
+  p.batch_size = (reads_queue_size < TMAP_MAP_DRIVER_BATCH_SIZE) ? reads_queue_size : TMAP_MAP_DRIVER_BATCH_SIZE;
+  p.num_batches = driver->opt->num_threads * TMAP_MAP_DRIVER_BATCHES_PER_THREAD;
+  p.batches = tmap_calloc(p.num_batches, sizeof(tmap_map_driver_batch_t), "p.batches");
+  for(i=0;i<p.num_batches;i++) {
+      p.batches[i].seqs_buffer = tmap_malloc(sizeof(tmap_seqs_t*)*p.batch_size, "p.batches[i].seqs_buffer");
+      for(j=0;j<p.batch_size;j++) {
+          p.batches[i].seqs_buffer[j] = tmap_seqs_init(seq_type);
+      }
+      p.batches[i].records = tmap_calloc(p.batch_size, sizeof(tmap_map_record_t*), "p.batches[i].records");
+      p.batches[i].bams = tmap_calloc(p.batch_size, sizeof(tmap_map_bams_t*), "p.batches[i].bams");
+      p.batches[i].n = 0;
+      p.batches[i].state = TMAP_MAP_DRIVER_BATCH_FREE;
+  }
+  p.num_read = p.num_claimed = p.num_written = 0;
+  p.eof = 0;
+  pthread_mutex_init(&p.mutex, NULL);
+  pthread_cond_init(&p.cond, NULL);
+  p.io_in = io_in;
+  p.header = io_out->fp->header->header;
+  p.preloaded = preloaded;
+  p.preloaded_length = preloaded_length;
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+  p.rand_core = rand_core;
+#endif
+  p.index = index;
+  p.driver = driver;
+  p.stat = stat;
+  p.stats = stats;
+  p.rand = rand;
+  p.realigner = realigner;
+  p.context = context;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+  if(0 != pthread_create(&thread_reader, &attr, tmap_map_driver_pipeline_reader, &p)) {
+      tmap_error("error creating threads", Exit, ThreadError);
+  }
+  threads = tmap_calloc(driver->opt->num_threads, sizeof(pthread_t), "threads");
+  thread_data = tmap_calloc(driver->opt->num_threads, sizeof(tmap_map_driver_pipeline_thread_t), "thread_data");
+  for(i=0;i<driver->opt->num_threads;i++) {
+      thread_data[i].pipeline = &p;
+      thread_data[i].tid = i;
+      if(0 != pthread_create(&threads[i], &attr, tmap_map_driver_pipeline_mapper, &thread_data[i])) {
+          tmap_error("error creating threads", Exit, ThreadError);
+      }
+  }
+
+  n_reads_processed = tmap_map_driver_pipeline_write(&p, io_out, reads_queue_size);
+
+  if(0 != pthread_join(thread_reader, NULL)) {
+      tmap_error("error joining IO thread", Exit, ThreadError);
+  }
+  for(i=0;i<driver->opt->num_threads;i++) {
+      if(0 != pthread_join(threads[i], NULL)) {
+          tmap_error("error joining threads", Exit, ThreadError);
+      }
+  }
+  pthread_attr_destroy(&attr);
+  free(threads);
+  free(thread_data);
+
+  pthread_mutex_destroy(&p.mutex);
+  pthread_cond_destroy(&p.cond);
+  for(i=0;i<p.num_batches;i++) {
+      for(j=0;j<p.batch_size;j++) {
+          tmap_seqs_destroy(p.batches[i].seqs_buffer[j]);
+      }
+      free(p.batches[i].seqs_buffer);
+      free(p.batches[i].records);
+      free(p.batches[i].bams);
+  }
+  free(p.batches);
+
+  return n_reads_processed;
 }
 #endif
 
 void 
 tmap_map_driver_core(tmap_map_driver_t *driver)
 {
-  uint32_t i, j, k, n_reads_processed=0; // # of reads processed
+  uint32_t i, j, n_reads_processed=0; // # of reads processed
   int32_t seqs_buffer_length=0; // # of reads read in
+#ifndef HAVE_LIBPTHREAD
   int32_t seqs_loaded=0; // 1 if the seq_buffer is loaded, 0 otherwse
+#endif
   tmap_seqs_io_t *io_in = NULL; // input file(s)
   tmap_sam_io_t *io_out = NULL; // output file
   tmap_seqs_t **seqs_buffer = NULL; // buffer for the reads
-#ifdef HAVE_LIBPTHREAD
-  tmap_seqs_t **seqs_buffer_next = NULL; // buffer for the reads
-#endif
   tmap_map_record_t **records=NULL; // buffer for the mapped data
   tmap_map_bams_t **bams=NULL;// buffer for the mapped BAM data
   tmap_index_t *index = NULL; // reference indes
   tmap_map_stats_t *stat = NULL; // alignment statistics
 #ifdef HAVE_LIBPTHREAD
   pthread_attr_t *attr = NULL;
-  pthread_attr_t attr_io;
   pthread_t *threads = NULL;
-  pthread_t *thread_io = NULL;
   tmap_map_driver_thread_data_t *thread_data=NULL;
-  tmap_map_driver_thread_io_data_t thread_io_data;
   tmap_rand_t **rand = NULL; // random # generator for each thread
   tmap_map_stats_t **stats = NULL; // alignment statistics for each thread
 #else
@@ -1644,6 +2031,7 @@ tmap_map_driver_core(tmap_map_driver_t *driver)
                             driver->opt->bam_start_vfo, driver->opt->bam_end_vfo);
 
   // get the index
+  tmap_file_mmap_set_hugepages(driver->opt->index_hugepages);
   index = tmap_index_init(driver->opt->fn_fasta, driver->opt->shm_key);
 
   // initialize the driver->options and print any relevant information
@@ -1659,14 +2047,8 @@ tmap_map_driver_core(tmap_map_driver_t *driver)
       reads_queue_size = driver->opt->reads_queue_size;
   }
   seqs_buffer = tmap_malloc(sizeof(tmap_seqs_t*)*reads_queue_size, "seqs_buffer");
-#ifdef HAVE_LIBPTHREAD
-  seqs_buffer_next = tmap_malloc(sizeof(tmap_seqs_t*)*reads_queue_size, "seqs_buffer_next");
-#endif
   for(i=0;i<reads_queue_size;i++) { // initialize the buffer
       seqs_buffer[i] = tmap_seqs_init(seq_type);
-#ifdef HAVE_LIBPTHREAD
-      seqs_buffer_next[i] = tmap_seqs_init(seq_type);
-#endif
   }
   records = tmap_malloc(sizeof(tmap_map_record_t*)*reads_queue_size, "records");
   bams = tmap_malloc(sizeof(tmap_map_bams_t*)*reads_queue_size, "bams");
@@ -1772,6 +2154,16 @@ tmap_map_driver_core(tmap_map_driver_t *driver)
                                                      &attr, &threads, &thread_data, rand, stats, realigner, context
 #endif
                                                      );
+#ifdef HAVE_LIBPTHREAD
+  // main processing pipeline, starting with any reads loaded for the pairing
+  tmap_progress_print("processing reads");
+  n_reads_processed = tmap_map_driver_pipeline_run(io_in, io_out, seqs_buffer, seqs_buffer_length, reads_queue_size, seq_type,
+                                                   index, driver, stat,
+#ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
+                                                   rand_core,
+#endif
+                                                   rand, stats, realigner, context);
+#else
   if(0 == seqs_buffer_length) {
       tmap_progress_print("loading reads");
       seqs_buffer_length = tmap_seqs_io_read_buffer(io_in, seqs_buffer, reads_queue_size, io_out->fp->header->header);
@@ -1785,21 +2177,7 @@ tmap_map_driver_core(tmap_map_driver_t *driver)
       // get the reads
       if(0 == seqs_loaded) { 
           tmap_progress_print("loading reads");
-#ifdef HAVE_LIBPTHREAD
-          // join the thread that loads in the reads
-          if(0 != pthread_join((*thread_io), NULL)) {
-              tmap_error("error joining IO thread", Exit, ThreadError);
-          }
-          free(thread_io);
-          thread_io = NULL;
-          // swap buffers
-          seqs_buffer_length = thread_io_data.seqs_buffer_length;
-          seqs_buffer_next = seqs_buffer; // temporarily store this here
-          seqs_buffer = thread_io_data.seqs_buffer; 
-          thread_io_data.seqs_buffer = seqs_buffer_next;
-#else
           seqs_buffer_length = tmap_seqs_io_read_buffer (io_in, seqs_buffer, reads_queue_size, io_out->fp->header->header);
-#endif
           seqs_loaded = 1;
           tmap_progress_print2("loaded %d reads", seqs_buffer_length);
       }
@@ -1807,113 +2185,28 @@ tmap_map_driver_core(tmap_map_driver_t *driver)
           break;
       }
 
-#ifdef HAVE_LIBPTHREAD
-      // launch a new thread that loads in the reads 
-      pthread_attr_init(&attr_io);
-      pthread_attr_setdetachstate(&attr_io, PTHREAD_CREATE_JOINABLE);
-      thread_io = tmap_malloc(sizeof(pthread_t), "thread_io");
-      thread_io_data.io_in = io_in;
-      thread_io_data.io_out = io_out;
-      thread_io_data.seqs_buffer_length = 0;
-      thread_io_data.reads_queue_size = reads_queue_size;
-      thread_io_data.seqs_buffer = seqs_buffer_next;
-      if(0 != pthread_create(thread_io, &attr_io, tmap_map_driver_thread_io_worker, &thread_io_data)) {
-          tmap_error("error creating threads", Exit, ThreadError);
-      }
-#endif
-
-      // create the threads
+      // map the reads
       if(0 == tmap_map_driver_create_threads(io_out->fp->header->header, seqs_buffer, records, 
                                              bams, seqs_buffer_length, index, driver, stat,
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
                                              rand_core,
-#endif
-#ifdef HAVE_LIBPTHREAD
-                                             &attr, &threads, &thread_data, rand, stats, realigner, context,
 #endif
                                              0)) {
           break;
       }
 
-      /*
-      if(-1 != driver->opt->reads_queue_size) {
-          tmap_progress_print("writing alignments");
-      }
-      */
-
       // write data
-      for(i=0;i<seqs_buffer_length;i++) {
-#ifdef HAVE_LIBPTHREAD
-          if(1 < driver->opt->num_threads) {
-              // NB: we will write data as threads process the data.  This is to
-              // facilitate SAM/BAM writing, which may be slow, especially for
-              // BAM.
-              int32_t tid = (i % driver->opt->num_threads);
-              while((*thread_data[tid].buffer_idx) <= i) {
-                  usleep(1000*1000); // sleep
-              }
-          }
-#endif
-          // write
-          for(j=0;j<bams[i]->n;j++) { // for each end
-              for(k=0;k<bams[i]->bams[j]->n;k++) { // for each hit
-                  bam1_t *b = NULL;
-                  b = bams[i]->bams[j]->bams[k]; // that's a lot of BAMs
-                  if(NULL == b) tmap_bug();
-                  if(samwrite(io_out->fp, b) <= 0) {
-                      tmap_error("Error writing the SAM file", Exit, WriteFileError);
-                  }
-              }
-          }
-          tmap_map_bams_destroy(bams[i]);
-          bams[i] = NULL;
-      }
-
-#ifdef HAVE_LIBPTHREAD
-      // join threads
-      if(1 < driver->opt->num_threads) {
-          // join threads
-          for(i=0;i<driver->opt->num_threads;i++) {
-              if(0 != pthread_join(threads[i], NULL)) {
-                  tmap_error("error joining threads", Exit, ThreadError);
-              }
-              // add the stats
-              tmap_map_stats_add (stat, stats[i]);
-              tmap_map_stats_zero (stats[i]);
-              // free the buffer index
-              free(thread_data[i].buffer_idx);
-          }
-          free(threads); threads = NULL;
-          free(thread_data); thread_data = NULL;
-          free(attr); attr = NULL;
-      }
-#endif
+      tmap_map_driver_write_bams(io_out, bams, seqs_buffer_length);
       // TODO: should we flush when writing SAM and processing one read at a time?
 
       // print statistics
       n_reads_processed += seqs_buffer_length;
       if(-1 != driver->opt->reads_queue_size) {
-          tmap_progress_print2("processed %d reads", n_reads_processed);
-          tmap_progress_print2("stats [%.2lf,%.2lf,%.2lf,%.2lf,%.2lf,%.2lf]",
-                               stat->num_with_mapping * 100.0 / (double)stat->num_reads,
-                               stat->num_after_seeding/(double)stat->num_with_mapping,
-                               stat->num_after_grouping/(double)stat->num_with_mapping,
-                               stat->num_after_scoring/(double)stat->num_with_mapping,
-                               stat->num_after_rmdup/(double)stat->num_with_mapping,
-                               stat->num_after_filter/(double)stat->num_with_mapping);
-          if (driver->opt->do_repeat_clip)
-          {
-              tmap_progress_print2("total %llu, mapped %llu, clipped %llu, rejected %llu, %.2f%% bases]",
-                                    stat->num_reads,
-                                    stat->num_with_mapping,
-                                    stat->num_tailclipped,
-                                    stat->num_fully_tailclipped,
-                                    ((double) stat->bases_tailclipped) * 100 / stat->bases_seen_tailclipped
-              );
-          }
+          tmap_map_driver_print_progress(driver, stat, n_reads_processed);
       }
       seqs_loaded = 0;
   }
+#endif
   if(-1 == driver->opt->reads_queue_size) {
       tmap_progress_print2("processed %d reads", n_reads_processed);
       tmap_progress_print2("stats [%.2lf,%.2lf,%.2lf,%.2lf,%.2lf,%.2lf]",
@@ -2026,14 +2319,8 @@ tmap_map_driver_core(tmap_map_driver_t *driver)
   tmap_seqs_io_destroy(io_in);
   for(i=0;i<reads_queue_size;i++) {
       tmap_seqs_destroy(seqs_buffer[i]);
-#ifdef HAVE_LIBPTHREAD
-      tmap_seqs_destroy(seqs_buffer_next[i]);
-#endif
   }
   free(seqs_buffer);
-#ifdef HAVE_LIBPTHREAD
-  free(seqs_buffer_next);
-#endif
 
 // DVK - realigner
 #ifdef HAVE_LIBPTHREAD
@@ -2064,7 +2351,6 @@ tmap_map_driver_core(tmap_map_driver_t *driver)
   }
   free(stats);
   free(rand);
-  free(thread_io);
 #else
   tmap_rand_destroy(rand);
 #endif
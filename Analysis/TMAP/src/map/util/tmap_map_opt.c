@@ -187,6 +187,7 @@ __tmap_map_opt_option_print_func_int_init(min_indel_end_repair)
 __tmap_map_opt_option_print_func_int_init(max_adapter_bases_for_soft_clipping)
 
 __tmap_map_opt_option_print_func_int_init(shm_key)
+__tmap_map_opt_option_print_func_tf_init(index_hugepages)
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
 __tmap_map_opt_option_print_func_double_init(sample_reads)
 #endif
@@ -721,6 +722,12 @@ tmap_map_opt_init_helper(tmap_map_opt_t *opt)
                            NULL,
                            tmap_map_opt_option_print_func_shm_key,
                            TMAP_MAP_ALGO_GLOBAL);
+  tmap_map_opt_options_add(opt->options, "index-hugepages", no_argument, 0, 0 /* no short flag */,
+                           TMAP_MAP_OPT_TYPE_NONE,
+                           "back the memory-mapped index with transparent huge pages where the kernel supports it, and read it ahead",
+                           NULL,
+                           tmap_map_opt_option_print_func_index_hugepages,
+                           TMAP_MAP_ALGO_GLOBAL);
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
   tmap_map_opt_options_add(opt->options, "sample-reads", required_argument, 0, 'x',
                            TMAP_MAP_OPT_TYPE_FLOAT,
@@ -1335,6 +1342,7 @@ tmap_map_opt_init(int32_t algo_id)
   opt->min_indel_end_repair = 3;
   opt->max_adapter_bases_for_soft_clipping = INT32_MAX;
   opt->shm_key = 0;
+  opt->index_hugepages = 0;
   opt->min_seq_len = -1;
   opt->max_seq_len = -1;
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
@@ -1798,6 +1806,9 @@ tmap_map_opt_parse(int argc, char *argv[], tmap_map_opt_t *opt)
       else if(c == 'k' || (0 == c && 0 == strcmp("shared-memory-key", options[option_index].name))) {       
           opt->shm_key = atoi(optarg);
       }
+      else if(0 == c && 0 == strcmp("index-hugepages", options[option_index].name)) {
+          opt->index_hugepages = 1;
+      }
       else if(c == 'o' || (0 == c && 0 == strcmp("output-type", options[option_index].name))) {
           opt->output_type = atoi(optarg);
       }
@@ -2271,6 +2282,9 @@ tmap_map_opt_check_global(tmap_map_opt_t *opt_a, tmap_map_opt_t *opt_b)
     if(opt_a->shm_key != opt_b->shm_key) {
         tmap_error("option -k was specified outside of the common options", Exit, CommandLineArgument);
     }
+    if(opt_a->index_hugepages != opt_b->index_hugepages) {
+        tmap_error("option --index-hugepages was specified outside of the common options", Exit, CommandLineArgument);
+    }
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
     if(opt_a->sample_reads != opt_b->sample_reads) {
         tmap_error("option -x was specified outside of the common options", Exit, CommandLineArgument);
@@ -2435,6 +2449,7 @@ tmap_map_opt_check(tmap_map_opt_t *opt)
   tmap_error_cmd_check_int(opt->bidirectional, 0, 1, "-D");
   tmap_error_cmd_check_int(opt->seq_eq, 0, 1, "-I");
   tmap_error_cmd_check_int(opt->ignore_rg_sam_tags, 0, 1, "-C");
+  tmap_error_cmd_check_int(opt->index_hugepages, 0, 1, "--index-hugepages");
   /*
   if(0 == opt->ignore_rg_sam_tags && NULL != opt->sam_rg) {
       tmap_error("Must use -C with -R", Exit, CommandLineArgument);
@@ -2660,6 +2675,7 @@ tmap_map_opt_copy_global(tmap_map_opt_t *opt_dest, tmap_map_opt_t *opt_src)
     opt_dest->min_indel_end_repair = opt_src->min_indel_end_repair;
     opt_dest->max_adapter_bases_for_soft_clipping = opt_src->max_adapter_bases_for_soft_clipping;
     opt_dest->shm_key = opt_src->shm_key;
+    opt_dest->index_hugepages = opt_src->index_hugepages;
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
     opt_dest->sample_reads = opt_src->sample_reads;
 #endif
@@ -2749,6 +2765,7 @@ tmap_map_opt_print(tmap_map_opt_t *opt)
   fprintf(stderr, "min_indel_end_repair=%d\n", opt->min_indel_end_repair);
   fprintf(stderr, "max_adapter_bases_for_soft_clipping=%d\n", opt->max_adapter_bases_for_soft_clipping);
   fprintf(stderr, "shm_key=%d\n", (int)opt->shm_key);
+  fprintf(stderr, "index_hugepages=%d\n", opt->index_hugepages);
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
   fprintf(stderr, "sample_reads=%lf\n", opt->sample_reads);
 #endif
@@ -217,6 +217,7 @@ typedef struct __tmap_map_opt_t {
     int32_t min_indel_end_repair;  /*!< Try to save long indel from end repair by count a longest indel as 1 error */
     int32_t max_adapter_bases_for_soft_clipping; /*!< specifies to perform 3' soft-clipping (via -g) if at most this # of adapter bases were found (ZB tag) (--max-adapter-bases-for-soft-clipping) */ 
     key_t shm_key;  /*!< the shared memory key (-k,--shared-memory-key) */
+    int32_t index_hugepages;  /*!< 1 to advise huge pages and read-ahead for the memory-mapped index (--index-hugepages) */
 #ifdef ENABLE_TMAP_DEBUG_FUNCTIONS
     double sample_reads;  /*!< sample the reads at this fraction (-x,--sample-reads) */
 #endif
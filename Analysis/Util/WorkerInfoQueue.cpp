@@ -1,6 +1,7 @@
 /* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
 
 #include "WorkerInfoQueue.h"
+#include <sys/time.h>
 
 // create a queue w/ that can hold the specified number of items
 WorkerInfoQueue::WorkerInfoQueue(int _depth)
@@ -20,6 +21,21 @@ WorkerInfoQueue::WorkerInfoQueue(int _depth)
   std::cout << "Analysis pipeline: Worker Info Queue with depth: " << _depth << " created." << std::endl;
 }
 
+WorkerInfoQueue::WorkerInfoQueue()
+{
+  depth = 0;
+  rdndx = 0;
+  wrndx = 0;
+  num = 0;
+  not_done_cnt = 0;
+  qlist = NULL;
+
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&rdcond,NULL);
+  pthread_cond_init(&wrcond,NULL);
+  pthread_cond_init(&donecond,NULL);
+}
+
 // put a new item on the queue.  this will block if the queue is full
 void WorkerInfoQueue::PutItem(WorkerInfoQueueItem &new_item)
 {
@@ -141,6 +157,196 @@ WorkerInfoQueue::~WorkerInfoQueue()
 }
 
 
+// worker thread -> deque binding, set by WorkStealingQueue::RegisterWorker()
+static __thread WorkStealingQueue *worker_queue = NULL;
+static __thread int worker_index = -1;
+
+static unsigned long NowUsec()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (unsigned long)tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+
+WorkStealingQueue::WorkStealingQueue(int _numWorkers)
+{
+  num_workers = std::max(_numWorkers, 1);
+  registered_workers = 0;
+  next_worker = 0;
+  queued = 0;
+  sleepers = 0;
+  deques.resize(num_workers);
+  for (int i = 0; i < num_workers; i++) {
+    deques[i] = new WorkerDeque;
+    pthread_mutex_init(&deques[i]->lock, NULL);
+    deques[i]->local_items = 0;
+    deques[i]->stolen_items = 0;
+    deques[i]->dequeue_usec = 0;
+    deques[i]->idle_usec = 0;
+  }
+  pthread_mutex_init(&idle_lock, NULL);
+  pthread_cond_init(&idle_cond, NULL);
+
+  std::cout << "Analysis pipeline: Work stealing queue for " << num_workers << " workers created." << std::endl;
+}
+
+int WorkStealingQueue::RegisterWorker()
+{
+  int worker = __sync_fetch_and_add(&registered_workers, 1) % num_workers;
+  worker_queue = this;
+  worker_index = worker;
+  return worker;
+}
+
+int WorkStealingQueue::CurrentWorker()
+{
+  return (worker_queue == this) ? worker_index : -1;
+}
+
+void WorkStealingQueue::PutItem(WorkerInfoQueueItem &new_item)
+{
+  // prefer the item's own hint, then keep follow-up work on the putting worker
+  int worker = new_item.affinity;
+  if (worker < 0)
+    worker = CurrentWorker();
+  if (worker < 0)
+    worker = (int)((unsigned int)__sync_fetch_and_add(&next_worker, 1) % num_workers);
+  worker %= num_workers;
+
+  __sync_fetch_and_add(&not_done_cnt, 1);
+
+  WorkerDeque *d = deques[worker];
+  pthread_mutex_lock(&d->lock);
+  d->items.push_back(new_item);
+  pthread_mutex_unlock(&d->lock);
+
+  // queued is bumped before looking for sleepers and sleepers before a worker
+  // re-checks queued, so a worker can't go to sleep on this item
+  __sync_fetch_and_add(&queued, 1);
+  if (__sync_fetch_and_add(&sleepers, 0) > 0) {
+    pthread_mutex_lock(&idle_lock);
+    pthread_cond_signal(&idle_cond);
+    pthread_mutex_unlock(&idle_lock);
+  }
+}
+
+// own deque oldest first, so the planned region order is kept, then steal the
+// newest item of the other workers
+bool WorkStealingQueue::TryPop(int worker, WorkerInfoQueueItem &item)
+{
+  if (__sync_fetch_and_add(&queued, 0) == 0)
+    return false;
+
+  WorkerDeque *own = deques[worker];
+  pthread_mutex_lock(&own->lock);
+  if (!own->items.empty()) {
+    item = own->items.front();
+    own->items.pop_front();
+    pthread_mutex_unlock(&own->lock);
+    __sync_fetch_and_sub(&queued, 1);
+    __sync_fetch_and_add(&own->local_items, 1);
+    return true;
+  }
+  pthread_mutex_unlock(&own->lock);
+
+  for (int i = 1; i < num_workers; i++) {
+    WorkerDeque *victim = deques[(worker + i) % num_workers];
+    pthread_mutex_lock(&victim->lock);
+    if (!victim->items.empty()) {
+      item = victim->items.back();
+      victim->items.pop_back();
+      pthread_mutex_unlock(&victim->lock);
+      __sync_fetch_and_sub(&queued, 1);
+      __sync_fetch_and_add(&own->stolen_items, 1);
+      return true;
+    }
+    pthread_mutex_unlock(&victim->lock);
+  }
+  return false;
+}
+
+WorkerInfoQueueItem WorkStealingQueue::GetItem(void)
+{
+  WorkerInfoQueueItem item;
+  int worker = std::max(CurrentWorker(), 0);
+  unsigned long start = NowUsec();
+  unsigned long idle = 0;
+
+  while (!TryPop(worker, item)) {
+    unsigned long idle_start = NowUsec();
+    pthread_mutex_lock(&idle_lock);
+    __sync_fetch_and_add(&sleepers, 1);
+    while (__sync_fetch_and_add(&queued, 0) == 0)
+      pthread_cond_wait(&idle_cond, &idle_lock);
+    __sync_fetch_and_sub(&sleepers, 1);
+    pthread_mutex_unlock(&idle_lock);
+    idle += NowUsec() - idle_start;
+  }
+
+  __sync_fetch_and_add(&deques[worker]->idle_usec, idle);
+  __sync_fetch_and_add(&deques[worker]->dequeue_usec, NowUsec() - start - idle);
+  return(item);
+}
+
+WorkerInfoQueueItem WorkStealingQueue::TryGetItem(void)
+{
+  WorkerInfoQueueItem item;
+  int worker = std::max(CurrentWorker(), 0);
+  unsigned long start = NowUsec();
+
+  if (!TryPop(worker, item))
+    item.private_data = NULL;
+
+  __sync_fetch_and_add(&deques[worker]->dequeue_usec, NowUsec() - start);
+  return(item);
+}
+
+void WorkStealingQueue::WaitTillDone(void)
+{
+  pthread_mutex_lock(&lock);
+  while (__sync_fetch_and_add(&not_done_cnt, 0) > 0)
+    pthread_cond_wait(&donecond,&lock);
+  pthread_mutex_unlock(&lock);
+}
+
+void WorkStealingQueue::DecrementDone(void)
+{
+  // only the last item of a batch takes the lock
+  if (__sync_sub_and_fetch(&not_done_cnt, 1) == 0) {
+    pthread_mutex_lock(&lock);
+    pthread_cond_broadcast(&donecond);
+    pthread_mutex_unlock(&lock);
+  }
+}
+
+void WorkStealingQueue::LogAndResetStats(const char *label)
+{
+  unsigned long local_items = 0, stolen_items = 0, dequeue_usec = 0, idle_usec = 0, max_idle_usec = 0;
+  for (int i = 0; i < num_workers; i++) {
+    WorkerDeque *d = deques[i];
+    local_items += __sync_fetch_and_and(&d->local_items, 0);
+    stolen_items += __sync_fetch_and_and(&d->stolen_items, 0);
+    dequeue_usec += __sync_fetch_and_and(&d->dequeue_usec, 0);
+    unsigned long worker_idle = __sync_fetch_and_and(&d->idle_usec, 0);
+    idle_usec += worker_idle;
+    max_idle_usec = std::max(max_idle_usec, worker_idle);
+  }
+  unsigned long items = local_items + stolen_items;
+  fprintf(stdout, "%s: %lu items (%lu stolen) on %d workers, dequeue %.1f usec/item, idle %.3f sec total, %.3f sec max per worker\n",
+          label, items, stolen_items, num_workers, items ? (double)dequeue_usec / items : 0.0,
+          idle_usec / 1.0e6, max_idle_usec / 1.0e6);
+}
+
+WorkStealingQueue::~WorkStealingQueue()
+{
+  pthread_cond_destroy(&idle_cond);
+  pthread_mutex_destroy(&idle_lock);
+  for (int i = 0; i < num_workers; i++) {
+    pthread_mutex_destroy(&deques[i]->lock);
+    delete deques[i];
+  }
+}
+
 // create a queue w/ that can hold the specified number of items
 DynamicWorkQueueGpuCpu::DynamicWorkQueueGpuCpu(int _depth)
 {
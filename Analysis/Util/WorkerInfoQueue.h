@@ -22,16 +22,20 @@
 #include <sstream>
 #include <iostream>
 #include <iomanip>
+#include <deque>
+#include <pthread.h>
 
 
 struct WorkerInfoQueueItem
 {
     bool finished;
     void *private_data;
+    int affinity; // preferred worker (e.g. region index) for queues that honour it, -1 for none
     WorkerInfoQueueItem()
     {
       finished = false;
       private_data = NULL;
+      affinity = -1;
     }
 };
 
@@ -44,28 +48,31 @@ class WorkerInfoQueue
   WorkerInfoQueue(int _depth);
 
   /** Put a new item on the queue.  Blocks if the queue is full */
-  void PutItem(WorkerInfoQueueItem &new_item);
+  virtual void PutItem(WorkerInfoQueueItem &new_item);
 
   /** remove an item from the queue.  this will block if the queue is empty */
-  WorkerInfoQueueItem GetItem(void);
+  virtual WorkerInfoQueueItem GetItem(void);
 
   /** try to remove an item from the queue.  this will return item with empty data if the queue is empty */
-  WorkerInfoQueueItem TryGetItem(void);
+  virtual WorkerInfoQueueItem TryGetItem(void);
 
   // NOTE: just because the q is empty...doesn't mean the workers are done with the
   // last item they pulled off.  Worker's decrement the 'not done' count whenever they
   // finish a work item.  
   /** Wait till all the work items have been completed */
-  void WaitTillDone(void);
+  virtual void WaitTillDone(void);
 
   /* Call when a worker has completed a task */
-  void DecrementDone(void);
+  virtual void DecrementDone(void);
 
   inline bool empty(){return (not_done_cnt == 0);}
 
-  ~WorkerInfoQueue();
+  virtual ~WorkerInfoQueue();
+
+protected:
+  /** For derived queues that keep their items elsewhere */
+  WorkerInfoQueue();
 
-private:
     int rdndx;
     int wrndx;
     int num;
@@ -80,6 +87,57 @@ private:
     pthread_cond_t donecond;
 };
 
+/// WorkerInfoQueue with one deque per worker thread instead of a single shared ring.
+/// Items go to the deque of their affinity worker (or the putting worker, or round
+/// robin), workers serve their own deque first and steal from the others when it
+/// runs dry, so each worker only touches a shared lock when it goes idle.
+/// Worker threads must call RegisterWorker() once before taking items.
+class WorkStealingQueue : public WorkerInfoQueue
+{
+ public:
+  WorkStealingQueue(int _numWorkers);
+
+  /** Bind the calling thread to a deque, returns its worker index */
+  int RegisterWorker();
+
+  /** Never blocks, the deques grow as needed */
+  void PutItem(WorkerInfoQueueItem &new_item);
+  WorkerInfoQueueItem GetItem(void);
+  WorkerInfoQueueItem TryGetItem(void);
+  void WaitTillDone(void);
+  void DecrementDone(void);
+
+  /** Print dequeue cost, idle time and steals since the last call */
+  void LogAndResetStats(const char *label);
+
+  ~WorkStealingQueue();
+
+ private:
+  struct WorkerDeque
+  {
+    pthread_mutex_t lock;
+    std::deque<WorkerInfoQueueItem> items;
+    // statistics, updated with atomic adds
+    unsigned long local_items;
+    unsigned long stolen_items;
+    unsigned long dequeue_usec;
+    unsigned long idle_usec;
+    char pad[64]; // keep neighbouring workers' hot fields off this cache line
+  };
+
+  bool TryPop(int worker, WorkerInfoQueueItem &item);
+  int CurrentWorker();
+
+  int num_workers;
+  int registered_workers;
+  int next_worker;       // round robin target for items without a hint
+  int queued;            // items sitting in any deque
+  int sleepers;
+  std::vector<WorkerDeque*> deques;
+  pthread_mutex_t idle_lock;
+  pthread_cond_t idle_cond;
+};
+
 class DynamicWorkQueueGpuCpu {
 
 public:
@@ -10,8 +10,18 @@
 #include <errno.h>
 #include <limits.h>
 #include <set>
+#include <new>
 #include "ReferenceReader.h"
 
+// Sharded reading parameters
+static const int  kShardsPerReader      = 8;      //! Chunks planned per reader thread, for load balance
+static const long kMinShardTargetBases  = 5000;   //! Smallest number of target bases worth a chunk of its own
+static const int  kShardBlockSize       = 512;    //! Reads handed over from a reader to the walker at a time
+static const int  kShardMaxBlocks       = 8;      //! Blocks buffered per chunk before its reader pauses
+
+// Alignment objects are allocated this many at a time, up to the number the recycle stack keeps
+static const int  kAlignmentSlabSize    = 1024;
+static const int  kMaxRecycledReads     = 55000;
 
 
 BAMWalkerEngine::BAMWalkerEngine()
@@ -30,26 +40,42 @@ BAMWalkerEngine::BAMWalkerEngine()
   alignments_first_ = NULL;
   alignments_last_ = NULL;
   read_counter_ = 0;
+  slab_next_ = NULL;
+  slab_left_ = 0;
   recycle_ = NULL;
   recycle_size_ = 0;
+  returned_ = NULL;
+  returned_size_ = 0;
   first_excess_read_ = 0;
   first_useful_read_ = 0;
   bam_writing_enabled_ = false;
-  pthread_mutex_init(&recycle_mutex_, NULL);
   temp_read_size = 100;
   temp_reads.resize(temp_read_size);
   next_temp_read = NULL;
+  shard_window_ = 0;
+  next_shard_ = 0;
+  current_shard_ = 0;
+  current_block_ = NULL;
+  current_block_pos_ = 0;
+  shard_abort_ = false;
+  pthread_mutex_init(&shard_mutex_, NULL);
+  pthread_cond_init(&shard_ready_cond_, NULL);
+  pthread_cond_init(&shard_space_cond_, NULL);
 }
 
 
 BAMWalkerEngine::~BAMWalkerEngine()
 {
-  pthread_mutex_destroy(&recycle_mutex_);
+  for (unsigned int i = 0; i < alignment_slabs_.size(); ++i)
+    delete [] alignment_slabs_[i];
+  pthread_mutex_destroy(&shard_mutex_);
+  pthread_cond_destroy(&shard_ready_cond_);
+  pthread_cond_destroy(&shard_space_cond_);
 }
 
 
 void BAMWalkerEngine::Initialize(const ReferenceReader& ref_reader, TargetsManager& targets_manager,
-    const vector<string>& bam_filenames, const string& postprocessed_bam, int px)
+    const vector<string>& bam_filenames, const string& postprocessed_bam, int px, int num_shard_readers)
 {
 
   InitializeBAMs(ref_reader, bam_filenames);
@@ -59,6 +85,11 @@ void BAMWalkerEngine::Initialize(const ReferenceReader& ref_reader, TargetsManag
   next_position_ = next_target_->begin;
   prefix_exclude = px;
 
+  if (num_shard_readers > 0) {
+    bam_filenames_ = bam_filenames;
+    InitializeShards(ref_reader, num_shard_readers);
+  }
+
   // BAM writing init
   if (not postprocessed_bam.empty()) {
     bam_writing_enabled_ = true;
@@ -76,6 +107,22 @@ void BAMWalkerEngine::Initialize(const ReferenceReader& ref_reader, TargetsManag
 
 void BAMWalkerEngine::Close()
 {
+  pthread_mutex_lock(&shard_mutex_);
+  shard_abort_ = true;
+  pthread_cond_broadcast(&shard_space_cond_);
+  pthread_mutex_unlock(&shard_mutex_);
+  for (unsigned int i = 0; i < shard_threads_.size(); ++i)
+    pthread_join(shard_threads_[i], NULL);
+  shard_threads_.clear();
+  for (unsigned int i = 0; i < shards_.size(); ++i) {
+    while (not shards_[i].blocks.empty()) {
+      delete shards_[i].blocks.front();
+      shards_[i].blocks.pop_front();
+    }
+  }
+  delete current_block_;
+  current_block_ = NULL;
+
   if (bam_writing_enabled_)
     bam_writer_.Close();
   bam_reader_.Close();
@@ -202,6 +249,208 @@ void BAMWalkerEngine::InitializeBAMs(const ReferenceReader& ref_reader, const ve
 
 
 
+// Split the reference into chunks holding about the same number of target bases.
+// Every position of every chromosome belongs to exactly one chunk, so the chunks together
+// deliver the same reads in the same order as a single pass over the whole BAM.
+void BAMWalkerEngine::InitializeShards(const ReferenceReader& ref_reader, int num_shard_readers)
+{
+  long total_target_bases = 0;
+  for (vector<MergedTarget>::const_iterator I = targets_manager_->merged.begin(); I != targets_manager_->merged.end(); ++I)
+    total_target_bases += I->end - I->begin;
+  long quota = max(kMinShardTargetBases, total_target_bases / (num_shard_readers * kShardsPerReader) + 1);
+
+  unsigned int target_idx = 0;
+  for (int chr = 0; chr < ref_reader.chr_count(); ++chr) {
+    long shard_begin = 0;
+    long accumulated = 0;
+    for (; target_idx < targets_manager_->merged.size() and targets_manager_->merged[target_idx].chr == chr; ++target_idx) {
+      const MergedTarget& target = targets_manager_->merged[target_idx];
+      long pos = target.begin;
+      while (accumulated + target.end - pos >= quota) {
+        long cut = pos + quota - accumulated;
+        shards_.push_back(BAMReadShard());
+        shards_.back().chr = chr;
+        shards_.back().begin = shard_begin;
+        shards_.back().end = cut;
+        shards_.back().finished = false;
+        shard_begin = cut;
+        pos = cut;
+        accumulated = 0;
+      }
+      accumulated += target.end - pos;
+    }
+    if (shard_begin < ref_reader.chr_size(chr)) {
+      shards_.push_back(BAMReadShard());
+      shards_.back().chr = chr;
+      shards_.back().begin = shard_begin;
+      shards_.back().end = ref_reader.chr_size(chr);
+      shards_.back().finished = false;
+    }
+  }
+
+  num_shard_readers = min(num_shard_readers, (int)shards_.size());
+  shard_window_ = 2 * num_shard_readers;
+  cout << "BAMWalkerEngine: " << num_shard_readers << " shard reader(s) over " << shards_.size() << " genomic chunk(s)" << endl;
+
+  shard_threads_.resize(num_shard_readers);
+  for (int i = 0; i < num_shard_readers; ++i) {
+    if (pthread_create(&shard_threads_[i], NULL, ShardReaderThread, this)) {
+      cerr << "ERROR: Could not start BAM shard reader thread" << endl;
+      exit(1);
+    }
+  }
+}
+
+
+void *BAMWalkerEngine::ShardReaderThread(void *engine)
+{
+  static_cast<BAMWalkerEngine*>(engine)->ShardReaderLoop();
+  return NULL;
+}
+
+
+// Claim chunks in coordinate order, never running more than shard_window_ chunks ahead of the walker
+void BAMWalkerEngine::ShardReaderLoop()
+{
+  BamMultiReader reader;
+  if (not reader.SetExplicitMergeOrder(BamMultiReader::MergeByCoordinate) or not reader.Open(bam_filenames_)
+      or not reader.LocateIndexes()) {
+    cerr << "ERROR: Could not open input BAM file(s) for shard reader : " << reader.GetErrorString() << endl;
+    exit(1);
+  }
+
+  while (true) {
+    pthread_mutex_lock(&shard_mutex_);
+    while (not shard_abort_ and next_shard_ < (int)shards_.size() and next_shard_ >= current_shard_ + shard_window_)
+      pthread_cond_wait(&shard_space_cond_, &shard_mutex_);
+    if (shard_abort_ or next_shard_ >= (int)shards_.size()) {
+      pthread_mutex_unlock(&shard_mutex_);
+      break;
+    }
+    BAMReadShard& shard = shards_[next_shard_++];
+    pthread_mutex_unlock(&shard_mutex_);
+
+    if (not reader.SetRegion(BamRegion(shard.chr, shard.begin, shard.chr, shard.end))) {
+      cerr << "ERROR: Could not jump to " << reader.GetReferenceData()[shard.chr].RefName << ":" << (shard.begin+1)
+           << " in input BAM file(s) : " << reader.GetErrorString() << endl;
+      exit(1);
+    }
+
+    bool keep_reading = true;
+    vector<BamAlignment> *block = new vector<BamAlignment>;
+    block->reserve(kShardBlockSize);
+    BamAlignment alignment;
+    while (keep_reading and reader.GetNextAlignmentCore(alignment)) {
+      if (alignment.RefID != shard.chr or alignment.Position >= shard.end)
+        break;
+      if (alignment.Position < shard.begin)
+        continue;   // Overlaps this chunk but was delivered by the previous one
+      alignment.BuildCharData();
+      block->push_back(alignment);
+      if ((int)block->size() == kShardBlockSize) {
+        keep_reading = PushShardBlock(shard, block);
+        block = new vector<BamAlignment>;
+        block->reserve(kShardBlockSize);
+      }
+    }
+    if (keep_reading and not block->empty())
+      PushShardBlock(shard, block);
+    else
+      delete block;
+
+    pthread_mutex_lock(&shard_mutex_);
+    shard.finished = true;
+    pthread_cond_broadcast(&shard_ready_cond_);
+    pthread_mutex_unlock(&shard_mutex_);
+  }
+  reader.Close();
+}
+
+
+// Hand a block over to the walker, waiting while the chunk already buffers kShardMaxBlocks.
+// The chunk being consumed always has its reader running, so waiting here cannot deadlock.
+bool BAMWalkerEngine::PushShardBlock(BAMReadShard& shard, vector<BamAlignment> *block)
+{
+  pthread_mutex_lock(&shard_mutex_);
+  while (not shard_abort_ and (int)shard.blocks.size() >= kShardMaxBlocks)
+    pthread_cond_wait(&shard_space_cond_, &shard_mutex_);
+  bool accepted = not shard_abort_;
+  if (accepted) {
+    shard.blocks.push_back(block);
+    pthread_cond_broadcast(&shard_ready_cond_);
+  }
+  pthread_mutex_unlock(&shard_mutex_);
+  if (not accepted)
+    delete block;
+  return accepted;
+}
+
+
+// BamAlignment declares its own copy constructor, so std::swap would copy it three times.
+// Exchange the decoded fields instead; the internal raw record stays behind, which is fine
+// because blocks only hold reads whose char data has already been built.
+static void SwapDecodedAlignment(BamAlignment& a, BamAlignment& b)
+{
+  a.Name.swap(b.Name);
+  swap(a.Length, b.Length);
+  a.QueryBases.swap(b.QueryBases);
+  a.AlignedBases.swap(b.AlignedBases);
+  a.Qualities.swap(b.Qualities);
+  a.TagData.swap(b.TagData);
+  swap(a.RefID, b.RefID);
+  swap(a.Position, b.Position);
+  swap(a.Bin, b.Bin);
+  swap(a.MapQuality, b.MapQuality);
+  swap(a.AlignmentFlag, b.AlignmentFlag);
+  a.CigarData.swap(b.CigarData);
+  swap(a.MateRefID, b.MateRefID);
+  swap(a.MatePosition, b.MatePosition);
+  swap(a.InsertSize, b.InsertSize);
+  a.Filename.swap(b.Filename);
+}
+
+// Called with read_loading_mutex held, so only one consumer walks the chunks
+bool BAMWalkerEngine::GetNextShardedAlignment(BamAlignment& alignment)
+{
+  while (not current_block_ or current_block_pos_ >= current_block_->size()) {
+    delete current_block_;
+    current_block_ = NULL;
+    pthread_mutex_lock(&shard_mutex_);
+    while (current_shard_ < (int)shards_.size()) {
+      BAMReadShard& shard = shards_[current_shard_];
+      if (not shard.blocks.empty()) {
+        current_block_ = shard.blocks.front();
+        current_block_pos_ = 0;
+        shard.blocks.pop_front();
+        break;
+      }
+      if (shard.finished)
+        current_shard_++;
+      else
+        pthread_cond_wait(&shard_ready_cond_, &shard_mutex_);
+    }
+    pthread_cond_broadcast(&shard_space_cond_);
+    pthread_mutex_unlock(&shard_mutex_);
+    if (not current_block_)
+      return false;
+  }
+  SwapDecodedAlignment(alignment, (*current_block_)[current_block_pos_++]);  // the block entry is not read again
+  return true;
+}
+
+
+bool BAMWalkerEngine::GetNextStreamAlignment(BamAlignment& alignment)
+{
+  if (not shards_.empty())
+    return GetNextShardedAlignment(alignment);
+  if (not bam_reader_.GetNextAlignmentCore(alignment))
+    return false;
+  alignment.BuildCharData();
+  return true;
+}
+
+
+
 bool  BAMWalkerEngine::EligibleForReadRemoval()
 {
   return alignments_first_ and alignments_first_->read_number+100 < first_useful_read_;
@@ -243,23 +492,46 @@ void BAMWalkerEngine::SaveAlignments(Alignment* removal_list)
 }
 
 
+// Does not need bam_walker_mutex: the retired reads are published to returned_ with a single CAS
+// and picked up by RequestReadProcessingTask once its own stack runs dry.
+// recycle_ belongs to the loader thread, so the cap only looks at the returned stack.
+// Up to kMaxRecycledReads returned reads keep their buffers for the next reads. Beyond that a read
+// from a slab has its buffers freed and only the empty object is kept, any other read is deleted.
 void BAMWalkerEngine::FinishReadRemovalTask(Alignment* removal_list)
 {
-  pthread_mutex_lock(&recycle_mutex_);
+  int room = kMaxRecycledReads - returned_size_;
+  Alignment *keep_first = NULL;
+  Alignment *keep_last = NULL;
+  int keep_size = 0;
 
   while (removal_list) {
 
     Alignment *excess = removal_list;
     removal_list = removal_list->next;
-    if (recycle_size_ > 55000) {
-      delete excess;
-    } else {
-      excess->next = recycle_;
-      recycle_ = excess;
-      recycle_size_++;
+    if (keep_size >= room) {
+      if (not excess->in_slab) {
+        delete excess;
+        continue;
+      }
+      excess->~Alignment();
+      new (excess) Alignment;
+      excess->in_slab = true;
     }
+    excess->next = keep_first;
+    if (not keep_first)
+      keep_last = excess;
+    keep_first = excess;
+    keep_size++;
   }
-  pthread_mutex_unlock(&recycle_mutex_);
+  if (not keep_first)
+    return;
+
+  Alignment *head;
+  do {
+    head = returned_;
+    keep_last->next = head;
+  } while (not __sync_bool_compare_and_swap(&returned_, head, keep_first));
+  __sync_fetch_and_add(&returned_size_, keep_size);
 }
 
 
@@ -303,22 +575,35 @@ bool BAMWalkerEngine::ReadyForNextPosition()
 void BAMWalkerEngine::RequestReadProcessingTask(Alignment* & new_read)
 {
 
-  pthread_mutex_lock(&recycle_mutex_);
+  // Only one thread pops (under bam_walker_mutex) and it takes the whole returned stack at once, so no ABA
+  if (not recycle_ and returned_) {
+    recycle_ = __sync_lock_test_and_set(&returned_, (Alignment *)NULL);
+    recycle_size_ += __sync_lock_test_and_set(&returned_size_, 0);
+  }
   if (recycle_) {
     new_read = recycle_;
     recycle_ = recycle_->next;
     recycle_size_--;
-    pthread_mutex_unlock(&recycle_mutex_);
     new_read->Reset();
   } else {
-    pthread_mutex_unlock(&recycle_mutex_);
     try {
-      new_read = new Alignment;
+      if (slab_left_ == 0 and (int)alignment_slabs_.size() * kAlignmentSlabSize < kMaxRecycledReads) {
+        alignment_slabs_.push_back(new Alignment[kAlignmentSlabSize]);
+        slab_next_ = alignment_slabs_.back();
+        slab_left_ = kAlignmentSlabSize;
+      }
+      if (slab_left_ > 0) {
+        new_read = slab_next_++;
+        new_read->in_slab = true;
+        slab_left_--;
+      } else {
+        new_read = new Alignment;
+      }
     }
     catch(std::bad_alloc& exc)
     {
       cerr << "ERROR: failed to allocate memory in reading BAM in BAMWalkerEngine::RequestReadProcessingTask" << endl;
-      exit(1);	
+      exit(1);
     }
   }
   new_read->read_number = read_counter_++;
@@ -359,8 +644,7 @@ bool BAMWalkerEngine::GetNextAlignmentCore(Alignment* new_read)
     }
     temp_heap.clear();
     do {
-	if (!bam_reader_.GetNextAlignmentCore(temp_reads[i])) break;
-	temp_reads[i].BuildCharData();
+	if (!GetNextStreamAlignment(temp_reads[i])) break;
 	if (temp_reads[i].RefID < 0) break;
 	if (temp_reads[i].Position != temp_reads[0].Position or temp_reads[i].RefID != temp_reads[0].RefID) {
 	    next_temp_read = &temp_reads[i];
@@ -549,7 +833,8 @@ void BAMWalkerEngine::PrintStatus()
       << " in_memory="   << read_counter_ - alignments_first_->read_number
       << " deleteable=" << first_useful_read_ - alignments_first_->read_number
       << " read_ahead=" << read_counter_ - first_excess_read_
-      << " recycle=" << recycle_size_ << endl;
+      << " recycle=" << recycle_size_ + returned_size_
+      << " slab_reads=" << alignment_slabs_.size() * kAlignmentSlabSize - slab_left_ << endl;
 }
 
 
@@ -10,8 +10,10 @@
 
 #include <list>
 #include <map>
+#include <deque>
 #include <vector>
 #include <string>
+#include <pthread.h>
 #include "api/BamMultiReader.h"
 #include "api/BamWriter.h"
 #include "TargetsManager.h"
@@ -48,7 +50,7 @@ struct Allele {
 // structure to encapsulate registered reads and alleles
 struct Alignment {
 
-  Alignment() { Reset(); }
+  Alignment() : in_slab(false) { Reset(); }
   void Reset() {
     next = NULL;
     read_number = 0;
@@ -91,6 +93,7 @@ struct Alignment {
 
   BamAlignment          alignment;          //! Raw BamTools alignment
   Alignment*            next;               //! Singly-linked list for durable alignments iterator
+  bool                  in_slab;            //! Part of a BAMWalkerEngine slab, must not be deleted on its own
   int                   read_number;        //! Sequential number of this read
   int                   original_position;  //! Alignment position, before primer trimming
 
@@ -148,6 +151,16 @@ struct PositionInProgress {
 };
 
 
+// Genomic chunk of the input BAMs, decoded ahead of time by one shard reader thread
+struct BAMReadShard {
+  int                             chr;      //! Chromosome index of this chunk
+  long                            begin;    //! Reads starting at or after this position belong to the chunk
+  long                            end;      //! Reads starting before this position belong to the chunk
+  deque<vector<BamAlignment> *>   blocks;   //! Decoded reads in coordinate order, waiting to be consumed
+  bool                            finished; //! Has the reader reached the end of this chunk?
+};
+
+
 class ReferenceReader;
 
 class BAMWalkerEngine {
@@ -157,7 +170,7 @@ public:
   BAMWalkerEngine();
   ~BAMWalkerEngine();
   void Initialize(const ReferenceReader& ref_reader, TargetsManager& targets_manager,
-      const vector<string>& bam_filenames, const string& postprocessed_bami, int px);
+      const vector<string>& bam_filenames, const string& postprocessed_bami, int px, int num_shard_readers = 0);
   void Close();
   const SamHeader& GetBamHeader() { return bam_header_; }
 
@@ -198,6 +211,12 @@ public:
 
 private:
   void InitializeBAMs(const ReferenceReader& ref_reader, const vector<string>& bam_filenames);
+  void InitializeShards(const ReferenceReader& ref_reader, int num_shard_readers);
+  static void *ShardReaderThread(void *engine);
+  void ShardReaderLoop();
+  bool PushShardBlock(BAMReadShard& shard, vector<BamAlignment> *block);
+  bool GetNextShardedAlignment(BamAlignment& alignment);
+  bool GetNextStreamAlignment(BamAlignment& alignment);
 
   TargetsManager *          targets_manager_;       //! Manages targets loaded from BED file
   BamMultiReader            bam_reader_;            //! BamTools mulit-bam reader
@@ -218,9 +237,13 @@ private:
   Alignment *               alignments_last_;       //! Last in a list of all alignments in memory
   int                       read_counter_;          //! Total # of reads retrieved so far
 
-  Alignment *               recycle_;               //! Stack of allocated, reusable Alignment objects
+  vector<Alignment *>       alignment_slabs_;       //! Blocks of Alignment objects, all freed together with the engine
+  Alignment *               slab_next_;             //! Next never used Alignment in the newest slab
+  int                       slab_left_;             //! Never used Alignments left in the newest slab
+  Alignment *               recycle_;               //! Stack of allocated, reusable Alignment objects, owned by the read loader
   int                       recycle_size_;          //! Size of the the recycle stack
-  pthread_mutex_t           recycle_mutex_;         //! Mutex controlling access to the recycle stack
+  Alignment * volatile      returned_;              //! Lock-free stack of Alignment objects handed back by read removal
+  volatile int              returned_size_;         //! Approximate size of the returned stack
 
   Alignment *               tmp_begin_;             //! Starts read window of most recent position task
   Alignment *               tmp_end_;               //! Ends read window of most recent position task
@@ -242,6 +265,20 @@ private:
   BamAlignment              *next_temp_read;
   vector<BamAlignment *>    temp_heap;
 
+  // Sharded reading: each reader thread owns a BamMultiReader and decodes whole genomic chunks ahead of the walker
+  vector<string>            bam_filenames_;         //! Input BAMs, reopened by every shard reader
+  vector<BAMReadShard>      shards_;                //! Genomic chunks covering the reference, in coordinate order
+  vector<pthread_t>         shard_threads_;         //! Shard reader threads
+  int                       shard_window_;          //! Max number of chunks decoded ahead of the one being consumed
+  int                       next_shard_;            //! Next chunk to be claimed by a reader
+  int                       current_shard_;         //! Chunk currently being consumed by the walker
+  vector<BamAlignment> *    current_block_;         //! Block of the current chunk being consumed
+  size_t                    current_block_pos_;     //! Next read within current_block_
+  bool                      shard_abort_;           //! Tells shard readers to quit early
+  pthread_mutex_t           shard_mutex_;           //! Mutex controlling access to shards_ queues
+  pthread_cond_t            shard_ready_cond_;      //! Signaled when a block or a finished chunk becomes available
+  pthread_cond_t            shard_space_cond_;      //! Signaled when the walker consumes a block or a chunk
+
 };
 
 
@@ -21,6 +21,7 @@ void VariantCallerHelp() {
   printf("  -v,--version                                      print version and exit\n");
   printf("  -n,--num-threads                      INT         number of worker threads [2]\n");
   printf("  -N,--num-variants-per-thread          INT         worker thread batch size [500]\n");
+  printf("     --num-bam-readers                  INT         threads decoding genomic chunks of the input BAMs ahead of the workers, 0 reads a single stream [4]\n");
   printf("     --parameters-file                  FILE        json file with algorithm control parameters [optional]\n");
   printf("\n");
 
@@ -88,6 +89,7 @@ void VariantCallerHelp() {
   printf("     --sse-relative-safety-level        FLOAT       dampen strand bias detection for SSE events for low coverage [0.025]\n");
   printf("     --tune-sbias                       FLOAT       dampen strand bias detection for low coverage [0.01]\n");
   printf("     --max-detail-level                 INT         number of evaluated frequencies for a given hypothesis, reduce for very high coverage, set to zero to disable this option [0]\n");
+  printf("     --max-scan-log-error               FLOAT       log posterior error allowed where the frequency scan interpolates, set to zero to evaluate every frequency [0.02]\n");
   printf("\n");
 
   printf("Variant filtering:\n");
@@ -183,6 +185,7 @@ ControlCallAndFilters::ControlCallAndFilters() {
 ProgramControlSettings::ProgramControlSettings() {
   nVariantsPerThread = 1000;
   nThreads = 1;
+  nBamReaders = 0;
   DEBUG = 0;
 #ifdef __SSE3__
   use_SSE_basecaller = true;
@@ -314,6 +317,7 @@ void EnsembleEvalTuningParameters::SetOpts(OptArgs &opts, Json::Value& tvc_param
   filter_deletion_bias                  = RetrieveParameterDouble(opts, tvc_params, '-', "filter-deletion-predictions", 100.0f);
   filter_insertion_bias                 = RetrieveParameterDouble(opts, tvc_params, '-', "filter-insertion-predictions", 100.0f);
   max_detail_level                      = RetrieveParameterInt(opts, tvc_params, '-', "max-detail-level", 0);		
+  max_scan_log_error                    = RetrieveParameterDouble(opts, tvc_params, '-', "max-scan-log-error", 0.02f);
 
   // shouldn't majorly affect anything, but still expose parameters for completeness
   pseudo_sigma_base                     = RetrieveParameterDouble(opts, tvc_params, '-', "shift-likelihood-penalty", 0.3f);
@@ -338,6 +342,7 @@ void EnsembleEvalTuningParameters::CheckParameterLimits() {
   CheckParameterLowerBound<float>     ("filter-deletion-predictions",   filter_deletion_bias,         0.0f);
   CheckParameterLowerBound<float>     ("filter-insertion-predictions",  filter_insertion_bias,        0.0f);
   CheckParameterLowerUpperBound<int>     ("max-detail-level",    max_detail_level,   0, 10000);
+  CheckParameterLowerUpperBound<float>("max-scan-log-error",      max_scan_log_error,      0.0f,  1.0f);
 
   CheckParameterLowerBound<float>     ("shift-likelihood-penalty",  pseudo_sigma_base,    0.01f);
   CheckParameterLowerBound<float>     ("minimum-sigma-prior",       magic_sigma_base,     0.01f);
@@ -487,6 +492,7 @@ void ProgramControlSettings::CheckParameterLimits() {
 
   CheckParameterLowerUpperBound<int>  ("num-threads",              nThreads,             1, 128);
   CheckParameterLowerUpperBound<int>  ("num-variants-per-thread",  nVariantsPerThread,   1, 10000);
+  CheckParameterLowerUpperBound<int>  ("num-bam-readers",          nBamReaders,          0, 64);
 }
 
 void ProgramControlSettings::SetOpts(OptArgs &opts, Json::Value &tvc_params) {
@@ -494,6 +500,7 @@ void ProgramControlSettings::SetOpts(OptArgs &opts, Json::Value &tvc_params) {
   DEBUG                                 = opts.GetFirstInt   ('d', "debug", 0);
   nThreads                              = RetrieveParameterInt   (opts, tvc_params, 'n', "num-threads", 12);
   nVariantsPerThread                    = RetrieveParameterInt   (opts, tvc_params, 'N', "num-variants-per-thread", 250);
+  nBamReaders                           = RetrieveParameterInt   (opts, tvc_params, '-', "num-bam-readers", 4);
 #ifdef __SSE3__
   use_SSE_basecaller                    = RetrieveParameterBool  (opts, tvc_params, '-', "use-sse-basecaller", true);
 #else
@@ -40,6 +40,7 @@ class EnsembleEvalTuningParameters {
     float filter_deletion_bias;
     float filter_insertion_bias;
     int   max_detail_level;
+    float max_scan_log_error; // error allowed in interpolated log posteriors of the frequency scan, 0 evaluates every frequency
     
 
     EnsembleEvalTuningParameters() {
@@ -62,6 +63,7 @@ class EnsembleEvalTuningParameters {
       filter_deletion_bias = 10.0f;
       filter_insertion_bias = 10.0f;
       max_detail_level = 0;
+      max_scan_log_error = 0.02f;
       
       //use_all_compare_for_test_flows = false;
     };
@@ -183,6 +185,7 @@ class ProgramControlSettings {
     // how we do things
     int nThreads;
     int nVariantsPerThread;
+    int nBamReaders;
     int DEBUG;
 
     bool rich_json_diagnostic;
@@ -240,10 +240,31 @@ public:
         dpTreephaser_vector.at(flow_order_index).Solve(read, end_flow, begin_flow);
     };
 
+    //@brief Interface for simulating the bases shared by the reads solved next only once
+    int SetPrefixState(const int & flow_order_index, const BasecallerRead& read, const int & num_bases, const int & max_flow){
+#ifdef __SSE3__
+      if (use_SSE_basecaller)
+        return treephaserSSE_vector.at(flow_order_index).SetPrefixState(read, num_bases, max_flow);
+      else
+#endif
+        return dpTreephaser_vector.at(flow_order_index).SetPrefixState(read, num_bases, max_flow);
+    };
+
+    //@brief Interface for dropping the shared bases again
+    void ClearPrefixState(const int & flow_order_index){
+#ifdef __SSE3__
+      if (use_SSE_basecaller)
+        treephaserSSE_vector.at(flow_order_index).ClearPrefixState();
+      else
+#endif
+        dpTreephaser_vector.at(flow_order_index).ClearPrefixState();
+    };
+
 
     bool                   use_SSE_basecaller;    // Switch that tells us which basecaller is active
 
     Realigner              realigner;             // realignment tool
+    vector<int16_t>        quantized_measurements; // ZM tag of the read being unpacked, keeps its capacity across reads
     vector<DPTreephaser >  dpTreephaser_vector;   // c++ treephaser
 #ifdef __SSE3__
     vector<TreephaserSSE>  treephaserSSE_vector;  // vectorized treephaser
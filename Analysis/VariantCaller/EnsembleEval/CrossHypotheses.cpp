@@ -434,15 +434,16 @@ void CrossHypotheses::JointLogLikelihood() {
   // normally delta is at least minimum difference for test flows
   // delta is our official vector
 
-  for (unsigned int i_hyp =0; i_hyp<log_likelihood.size(); i_hyp++) {
+  // ServeDelta hands every hypothesis the same direction, so its scale is computed once
+  float delta_scale = 0.001f; // safety level in case zeros happen
+  for (unsigned int t_flow=0; t_flow<test_flow.size(); t_flow++) {
+    int j_flow = test_flow[t_flow];
+    float d_val = delta_state.ServeDelta(0, j_flow);
+    delta_scale += d_val *d_val;
+  }
+  delta_scale = sqrt(delta_scale);
 
-    float delta_scale = 0.001f; // safety level in case zeros happen
-    for (unsigned int t_flow=0; t_flow<test_flow.size(); t_flow++) {
-      int j_flow = test_flow[t_flow];
-      float d_val = delta_state.ServeDelta(i_hyp, j_flow);
-      delta_scale += d_val *d_val;
-    }
-    delta_scale = sqrt(delta_scale);
+  for (unsigned int i_hyp =0; i_hyp<log_likelihood.size(); i_hyp++) {
 
     // now compute projection of residuals on this vector
     float res_projection=0.0f;
@@ -1,6 +1,7 @@
 /* Copyright (C) 2013 Ion Torrent Systems, Inc. All Rights Reserved */
 
 #include "PosteriorInference.h"
+#include <float.h>
 
 ScanSpace::ScanSpace(){
   scan_done = false;
@@ -11,6 +12,8 @@ ScanSpace::ScanSpace(){
   freq_pair_weight = 1.0f; // everything together
   max_ll = -999999999.0f; // anyting is better than this
   max_index = 0;
+  max_log_error = 0.02f; // < 0.2 in the phred scaled qualities from the integrals
+  num_evaluated = 0;
 }
 
 FreqMaster::FreqMaster(){
@@ -297,21 +300,117 @@ void PosteriorInference::InterpolateFrequencyScan(ShortStack &total_theory, bool
   scan_done = true;
 }*/
 
+float ScanSpace::EvaluateFrequency(ShortStack &total_theory, FreqMaster &base_clustering, vector<float> &hyp_freq, int strand_key, bool scan_ref, unsigned int i_eval) {
+  if (!scan_ref)
+    UpdatePairedFrequency(hyp_freq,base_clustering, eval_at_frequency[i_eval]);
+  else
+    base_clustering.UpdateFrequencyAgainstOne(hyp_freq, eval_at_frequency[i_eval],0);
+
+  num_evaluated++;
+  return(total_theory.PosteriorFrequencyLogLikelihood(hyp_freq, base_clustering.prior_frequency_weight,base_clustering.germline_log_prior_normalization, base_clustering.data_reliability, strand_key));
+}
+
+// The log posterior is a sum of logs of terms linear in the frequency, so it is concave:
+// between two scanned frequencies it lies above their chord and below the extended chords of
+// the neighbouring intervals.  Returns how far above the chord it can be in this interval,
+// the error of filling the interval in by linear interpolation.
+float ScanSpace::ChordError(const vector<unsigned int> &scanned, unsigned int i_scan) {
+  unsigned int a = scanned[i_scan];
+  unsigned int b = scanned[i_scan+1];
+  float width = b-a;
+  float chord_slope = (log_posterior_by_frequency[b]-log_posterior_by_frequency[a])/width;
+  bool has_left = i_scan>0;
+  bool has_right = i_scan+2<scanned.size();
+  float d_left = 0.0f;
+  float d_right = 0.0f;
+  if (has_left) {
+    unsigned int l = scanned[i_scan-1];
+    d_left = (log_posterior_by_frequency[a]-log_posterior_by_frequency[l])/(a-l) - chord_slope;
+  }
+  if (has_right) {
+    unsigned int r = scanned[i_scan+2];
+    d_right = chord_slope - (log_posterior_by_frequency[r]-log_posterior_by_frequency[b])/(r-b);
+  }
+  // no bound without a neighbour, or where rounding broke concavity
+  if ((!has_left & !has_right) | !(d_left>=0.0f) | !(d_right>=0.0f))
+    return(FLT_MAX);
+  if (!has_left)
+    return(d_right*width);
+  if (!has_right)
+    return(d_left*width);
+  if (d_left+d_right<=0.0f)
+    return(0.0f);
+  return(d_left*d_right*width/(d_left+d_right)); // where the two extended chords cross
+}
+
+// coarse grid first, then halve only the intervals whose chord error is too large.
+// The error allowed is max_log_error near the mode and grows in proportion to how far the
+// interval is below it (past depth_scale), so an integral far out in the tail, i.e. a high
+// quality score, keeps the same relative accuracy; a clear call settles after a few levels.
+void ScanSpace::AdaptiveFrequencyScan(ShortStack &total_theory, FreqMaster &base_clustering, vector<float> &hyp_freq, int strand_key, bool scan_ref) {
+  const float depth_scale = 10.0f; // log posterior units, about 43 on the phred scale
+  unsigned int detail_level = eval_at_frequency.size()-1;
+  unsigned int coarse_step = max(1u, detail_level/16);
+  vector<unsigned int> scanned;
+  for (unsigned int i_eval = 0; i_eval < detail_level; i_eval += coarse_step)
+    scanned.push_back(i_eval);
+  scanned.push_back(detail_level);
+  for (unsigned int i_scan = 0; i_scan < scanned.size(); i_scan++)
+    log_posterior_by_frequency[scanned[i_scan]] = EvaluateFrequency(total_theory, base_clustering, hyp_freq, strand_key, scan_ref, scanned[i_scan]);
+
+  vector<unsigned int> refined;
+  bool keep_refining = true;
+  while (keep_refining) {
+    keep_refining = false;
+    float scan_max = log_posterior_by_frequency[scanned[0]];
+    for (unsigned int i_scan = 1; i_scan < scanned.size(); i_scan++)
+      scan_max = max(scan_max, log_posterior_by_frequency[scanned[i_scan]]);
+    refined.resize(0);
+    for (unsigned int i_scan = 0; i_scan+1 < scanned.size(); i_scan++) {
+      refined.push_back(scanned[i_scan]);
+      unsigned int a = scanned[i_scan];
+      unsigned int b = scanned[i_scan+1];
+      if (b-a<2)
+        continue;
+      float chord_error = ChordError(scanned, i_scan);
+      float depth = scan_max - max(log_posterior_by_frequency[a], log_posterior_by_frequency[b]) - chord_error;
+      if (chord_error > max_log_error*max(1.0f, depth/depth_scale)) {
+        unsigned int i_mid = (a+b)/2;
+        log_posterior_by_frequency[i_mid] = EvaluateFrequency(total_theory, base_clustering, hyp_freq, strand_key, scan_ref, i_mid);
+        refined.push_back(i_mid);
+        keep_refining = true;
+      }
+    }
+    refined.push_back(scanned.back());
+    scanned.swap(refined);
+  }
+
+  // fill in the skipped frequencies from the chords
+  for (unsigned int i_scan = 0; i_scan+1 < scanned.size(); i_scan++) {
+    unsigned int a = scanned[i_scan];
+    unsigned int b = scanned[i_scan+1];
+    for (unsigned int i_mid = a+1; i_mid < b; i_mid++) {
+      float delta_low = i_mid-a;
+      float delta_hi = b-i_mid;
+      log_posterior_by_frequency[i_mid] = (log_posterior_by_frequency[a]*delta_hi + log_posterior_by_frequency[b]*delta_low)/(b-a);
+    }
+  }
+}
+
 void ScanSpace::DoPosteriorFrequencyScan(ShortStack &total_theory, FreqMaster &base_clustering, bool update_frequency, int strand_key, bool scan_ref, int max_detail_level) {
 //cout << "ScanningFrequency" << endl;
 // posterior frequency inference given current data/likelihood pairing
-  unsigned int detail_level = ResizeToMatch(total_theory, (unsigned) max_detail_level);  // now fills in frequency
+  ResizeToMatch(total_theory, (unsigned) max_detail_level);  // now fills in frequency
   // local scan size 2
   vector<float> hyp_freq = base_clustering.max_hyp_freq;
+  num_evaluated = 0;
   // should scan genotypes only for dual
-  for (unsigned int i_eval = 0; i_eval < eval_at_frequency.size(); i_eval++) {
-  
-    if (!scan_ref)
-      UpdatePairedFrequency(hyp_freq,base_clustering, eval_at_frequency[i_eval]);
-    else
-      base_clustering.UpdateFrequencyAgainstOne(hyp_freq, eval_at_frequency[i_eval],0);
-
-    log_posterior_by_frequency[i_eval] = total_theory.PosteriorFrequencyLogLikelihood(hyp_freq, base_clustering.prior_frequency_weight,base_clustering.germline_log_prior_normalization, base_clustering.data_reliability, strand_key);
+  if (max_log_error>0.0f) {
+    AdaptiveFrequencyScan(total_theory, base_clustering, hyp_freq, strand_key, scan_ref);
+  }
+  else {
+    for (unsigned int i_eval = 0; i_eval < eval_at_frequency.size(); i_eval++)
+      log_posterior_by_frequency[i_eval] = EvaluateFrequency(total_theory, base_clustering, hyp_freq, strand_key, scan_ref, i_eval);
   }
   // if doing monomorphic eval, set frequency to begin with and don't update
   //FindMaxFrequency(update_frequency);
@@ -59,12 +59,21 @@ public:
   float freq_pair_weight;
   bool scan_done;
 
+  // adaptive scan: largest error allowed in the log posterior of a frequency that is interpolated
+  // instead of evaluated, 0 evaluates every frequency
+  float max_log_error;
+  int num_evaluated; // frequencies evaluated by the last scan
+
   ScanSpace();
   float LogDefiniteIntegral(float alpha, float beta);
   float FindMaxFrequency();
   void UpdatePairedFrequency(vector <float > &tmp_freq, FreqMaster &base_clustering, float local_freq);
   unsigned int ResizeToMatch(ShortStack &total_theory, unsigned max_detail_level = 0);
   void  DoPosteriorFrequencyScan(ShortStack &total_theory, FreqMaster &base_clustering, bool update_frequency, int strand_key, bool scan_ref, int max_detail_level = 0);
+private:
+  float EvaluateFrequency(ShortStack &total_theory, FreqMaster &base_clustering, vector<float> &hyp_freq, int strand_key, bool scan_ref, unsigned int i_eval);
+  float ChordError(const vector<unsigned int> &scanned, unsigned int i_scan);
+  void  AdaptiveFrequencyScan(ShortStack &total_theory, FreqMaster &base_clustering, vector<float> &hyp_freq, int strand_key, bool scan_ref);
 };
 
 class PosteriorInference{
@@ -12,6 +12,9 @@ void LatentSlate::PropagateTuningParameters(EnsembleEvalTuningParameters &my_par
   // prior reliability for outlier read frequency
   cur_posterior.clustering.data_reliability = my_params.DataReliability();
   cur_posterior.clustering.germline_prior_strength = my_params.germline_prior_strength;
+  // frequency scans, the genotype pair included
+  cur_posterior.ref_vs_all.max_log_error = my_params.max_scan_log_error;
+  cur_posterior.gq_pair.max_log_error = my_params.max_scan_log_error;
   //rev_posterior.data_reliability = my_params.DataReliability();
   //fwd_posterior.data_reliability = my_params.DataReliability();
 
@@ -58,7 +58,62 @@ int CalculateHypPredictions(
     flow_upper_bound = min(flow_upper_bound, min(my_read.measurements_length, num_flows));
 
     vector<BasecallerRead> hypothesesReads(Hypotheses.size());
+    vector<int> begin_flows(Hypotheses.size(), 0);
     int max_last_flow  = 0;
+    int min_begin_flow = flow_upper_bound;
+    int num_solved = 0;
+
+    for (unsigned int i_hyp=0; i_hyp<hypothesesReads.size(); ++i_hyp) {
+    	if (same_as_null_hypothesis.at(i_hyp))
+    	  continue;
+
+        hypothesesReads[i_hyp] = master_read;
+
+        // --- add hypothesis sequence to clipped prefix
+        unsigned int i_base = 0;
+        unsigned int max_bases = 2*(unsigned int)flow_order.num_flows()-prefix_size; // Our maximum allocated memory for the sequence vector
+        int i_flow = prefix_flow;
+
+        // Add bases to read object sequence
+        // We add one more base beyond 'flow_upper_bound' (if available) to signal Treephaser to not even start the solver
+        while (i_base<Hypotheses[i_hyp].length() and i_base<max_bases) {
+          IncrementFlow(flow_order, Hypotheses[i_hyp][i_base], i_flow);
+          hypothesesReads[i_hyp].sequence.push_back(Hypotheses[i_hyp][i_base]);
+          if (i_flow >= flow_upper_bound) {
+        	i_flow = flow_upper_bound;
+            break;
+          }
+          i_base++;
+        }
+
+        // Find last main incorporating flow of all hypotheses
+        max_last_flow = max(max_last_flow, i_flow);
+        // Above checks on flow_upper_bound and i_flow guarantee that i_flow <= flow_upper_bound <= num_flows
+        begin_flows[i_hyp] = min(i_flow,flow_upper_bound);
+        min_begin_flow = min(min_begin_flow, begin_flows[i_hyp]);
+        num_solved++;
+    }
+
+    // The hypotheses only differ around the variant; simulate the bases they share once
+    // and let the solver start every hypothesis from that state
+    const BasecallerRead *first_read = NULL;
+    unsigned int shared_bases = 0;
+    if (num_solved > 1) {
+      for (unsigned int i_hyp=0; i_hyp<hypothesesReads.size(); ++i_hyp) {
+        if (same_as_null_hypothesis.at(i_hyp))
+          continue;
+        const vector<char> & sequence = hypothesesReads[i_hyp].sequence;
+        if (first_read == NULL) {
+          first_read = &hypothesesReads[i_hyp];
+          shared_bases = sequence.size();
+          continue;
+        }
+        shared_bases = min(shared_bases, (unsigned int)sequence.size());
+        shared_bases = mismatch(sequence.begin(), sequence.begin()+shared_bases, first_read->sequence.begin()).first - sequence.begin();
+      }
+      if (shared_bases > prefix_size and min_begin_flow > 0)
+        thread_objects.SetPrefixState(my_read.flow_order_index, *first_read, shared_bases, min_begin_flow);
+    }
 
     for (unsigned int i_hyp=0; i_hyp<hypothesesReads.size(); ++i_hyp) {
 
@@ -71,31 +126,8 @@ int CalculateHypPredictions(
             normalizedMeasurements[i_hyp].resize(flow_order.num_flows());
         } else {
 
-            hypothesesReads[i_hyp] = master_read;
-
-            // --- add hypothesis sequence to clipped prefix
-            unsigned int i_base = 0;
-            unsigned int max_bases = 2*(unsigned int)flow_order.num_flows()-prefix_size; // Our maximum allocated memory for the sequence vector
-            int i_flow = prefix_flow;
-
-            // Add bases to read object sequence
-            // We add one more base beyond 'flow_upper_bound' (if available) to signal Treephaser to not even start the solver
-            while (i_base<Hypotheses[i_hyp].length() and i_base<max_bases) {
-              IncrementFlow(flow_order, Hypotheses[i_hyp][i_base], i_flow);
-              hypothesesReads[i_hyp].sequence.push_back(Hypotheses[i_hyp][i_base]);
-              if (i_flow >= flow_upper_bound) {
-            	i_flow = flow_upper_bound;
-                break;
-              }
-              i_base++;
-            }
-
-            // Find last main incorporating flow of all hypotheses
-            max_last_flow = max(max_last_flow, i_flow);
-
             // Solver simulates beginning of the read and then fills in the remaining clipped bases
-            // Above checks on flow_upper_bound and i_flow guarantee that i_flow <= flow_upper_bound <= num_flows
-            thread_objects.SolveRead(my_read.flow_order_index, hypothesesReads[i_hyp], min(i_flow,flow_upper_bound), flow_upper_bound);
+            thread_objects.SolveRead(my_read.flow_order_index, hypothesesReads[i_hyp], begin_flows[i_hyp], flow_upper_bound);
 
             // Store predictions and adaptively normalized measurements
             predictions[i_hyp].swap(hypothesesReads[i_hyp].prediction);
@@ -104,6 +136,7 @@ int CalculateHypPredictions(
             normalizedMeasurements[i_hyp].resize(flow_order.num_flows(), 0);
         }
     }
+    thread_objects.ClearPrefixState(my_read.flow_order_index);
 
     // --- verbose ---
     if (global_context.DEBUG>2)
@@ -108,7 +108,8 @@ void UnpackAlignmentInfo(Alignment *rai)
 // -------------------------------------------------------
 
 
-void UnpackOnLoad(Alignment *rai, const InputStructures &global_context, const ExtendParameters& parameters)
+void UnpackOnLoad(Alignment *rai, const InputStructures &global_context, const ExtendParameters& parameters,
+                  PersistingThreadObjects &thread_objects)
 {
   if (not rai->alignment.IsMapped()) {
     rai->evaluator_filtered = true;
@@ -144,7 +145,7 @@ void UnpackOnLoad(Alignment *rai, const InputStructures &global_context, const E
     rai->well_rowcol.resize(2);
     ion_readname_to_rowcol(rai->alignment.Name.c_str(), &rai->well_rowcol[0], &rai->well_rowcol[1]);
     // extract runid while we are at it
-    rai->runid  = rai->alignment.Name.substr(0,rai->alignment.Name.find(":"));
+    rai->runid.assign(rai->alignment.Name, 0, rai->alignment.Name.find(":"));
   }
   
   if (rai->runid.empty()){
@@ -164,9 +165,9 @@ void UnpackOnLoad(Alignment *rai, const InputStructures &global_context, const E
   rai->flow_order_index = fo_it->second;
   const ion::FlowOrder & flow_order = global_context.flow_order_vector.at(rai->flow_order_index);
 
-  // Retrieve measurements from ZM tag
+  // Retrieve measurements from ZM tag, decoded into the thread's scratch so no allocation per read
 
-  vector<int16_t> quantized_measurements;
+  vector<int16_t>& quantized_measurements = thread_objects.quantized_measurements;
   if (not rai->alignment.GetTag("ZM", quantized_measurements)) {
     cerr << "ERROR: Normalized measurements ZM:tag is not present in read " << rai->alignment.Name << endl;
     exit(1);
@@ -18,7 +18,8 @@ using namespace std;
 
 struct Alignment;
 
-void UnpackOnLoad(Alignment *rai, const InputStructures &global_context, const ExtendParameters& parameters);
+void UnpackOnLoad(Alignment *rai, const InputStructures &global_context, const ExtendParameters& parameters,
+                  PersistingThreadObjects &thread_objects);
 
 //! @brief  Creates a stack of reads that provide evidence in the case of our candidate variant
 void StackUpOneVariant(vector<const Alignment *>& read_stack, int variant_start_pos, int variant_end_pos,
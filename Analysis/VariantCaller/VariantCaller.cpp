@@ -73,7 +73,8 @@ int main(int argc, char* argv[])
   targets_manager.Initialize(ref_reader, parameters.targets, parameters.trim_ampliseq_primers);
 
   BAMWalkerEngine bam_walker;
-  bam_walker.Initialize(ref_reader, targets_manager, parameters.bams, parameters.postprocessed_bam, parameters.prefixExclusion);
+  bam_walker.Initialize(ref_reader, targets_manager, parameters.bams, parameters.postprocessed_bam, parameters.prefixExclusion,
+      parameters.program_flow.nBamReaders);
   bam_walker.GetProgramVersions(parameters.basecaller_version, parameters.tmap_version);
 
   SampleManager sample_manager;
@@ -188,9 +189,7 @@ void * VariantCallerWorker(void *input)
         if (removal_list) {
           Alignment* save_list = vc.bam_writer->process_new_etries(removal_list);
           vc.bam_walker->SaveAlignments(save_list);
-          pthread_mutex_lock(&vc.bam_walker_mutex);
           vc.bam_walker->FinishReadRemovalTask(save_list);
-          pthread_mutex_unlock(&vc.bam_walker_mutex);
         }
         pthread_mutex_unlock(&vc.read_removal_mutex);
 
@@ -277,7 +276,7 @@ void * VariantCallerWorker(void *input)
           continue;
 
         vc.candidate_generator->RegisterAlignment(*new_read[i]);
-        UnpackOnLoad(new_read[i], *vc.global_context, *vc.parameters);
+        UnpackOnLoad(new_read[i], *vc.global_context, *vc.parameters, thread_objects);
       }
 
       pthread_mutex_lock(&vc.bam_walker_mutex);
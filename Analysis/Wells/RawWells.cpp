@@ -8,6 +8,11 @@
 #include <assert.h>
 #include <algorithm>
 #include <iostream>
+#include <deque>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "Utils.h"
 #include "LinuxCompat.h"
 #include "IonErr.h"
@@ -59,6 +64,25 @@ void RWH5DataSet::Close()
 }
 
 int RawWellsWriter::WriteWellsData(RWH5DataSet &dataSet, WellChunk &chunk, float *data) {
+  if(dataSet.mSaveAsUShort)
+  {
+    WellsConverter converter(dataSet.mLower, dataSet.mUpper);
+    size_t dataSize = chunk.rowHeight * chunk.colWidth * chunk.flowDepth;
+    mUShortBuffer.resize(dataSize);
+    for(size_t i = 0; i < dataSize; ++i)
+    {
+      mUShortBuffer[i] = converter.FloatToUInt16(data[i]);
+    }
+    return WriteWellsBuffer(dataSet, chunk, H5T_NATIVE_USHORT, &mUShortBuffer[0]);
+  }
+  return WriteWellsBuffer(dataSet, chunk, H5T_NATIVE_FLOAT, data);
+}
+
+int RawWellsWriter::WriteWellsData(RWH5DataSet &dataSet, WellChunk &chunk, unsigned short *data) {
+  return WriteWellsBuffer(dataSet, chunk, H5T_NATIVE_USHORT, data);
+}
+
+int RawWellsWriter::WriteWellsBuffer(RWH5DataSet &dataSet, WellChunk &chunk, hid_t memType, const void *data) {
   hsize_t count[3];       /* size of the hyperslab in the file */
   hsize_t offset[3];      /* hyperslab offset in the file */
   hsize_t count_out[3];   /* size of the hyperslab in memory */
@@ -100,29 +124,12 @@ int RawWellsWriter::WriteWellsData(RWH5DataSet &dataSet, WellChunk &chunk, float
                 ToStr ( chunk.rowStart ) + "," + ToStr ( chunk.colStart ) + "," +
                 ToStr ( chunk.rowHeight ) + "," + ToStr ( chunk.colWidth ) + " x " +
                 ToStr ( chunk.flowDepth ) );
+    H5Sclose(memspace);
     return 1;
   }
 
-  status = -1;
-  if(dataSet.mSaveAsUShort)
-  {
-    WellsConverter converter(dataSet.mLower, dataSet.mUpper);
-    size_t dataSize = chunk.rowHeight * chunk.colWidth * chunk.flowDepth;
-    unsigned short* buffer = new unsigned short[dataSize];
-    unsigned short* buffer2 = buffer;
-    float* data2 = data;
-    for(size_t i = 0; i < dataSize; ++i, ++buffer2, ++data2)
-    {
-      *buffer2 = converter.FloatToUInt16(*data2);
-	}
-    status = H5Dwrite ( dataSet.mDataset, H5T_NATIVE_USHORT, memspace, dataSet.mDataspace, H5P_DEFAULT, buffer);
-    delete [] buffer;
-    buffer = NULL;
-  }
-  else
-  {
-    status = H5Dwrite ( dataSet.mDataset, H5T_NATIVE_FLOAT, memspace, dataSet.mDataspace, H5P_DEFAULT, data);
-  }
+  status = H5Dwrite ( dataSet.mDataset, memType, memspace, dataSet.mDataspace, H5P_DEFAULT, data);
+  H5Sclose(memspace);
 
   if ( status < 0 ) {
     ION_WARN ( "ERROR - Unsuccessful write to file: " +
@@ -131,7 +138,6 @@ int RawWellsWriter::WriteWellsData(RWH5DataSet &dataSet, WellChunk &chunk, float
                 ToStr ( chunk.flowStart ) + "," + ToStr ( chunk.flowDepth ) + "\t" + dataSet.mName );
     return 1;
   }
-  H5Sclose(memspace);
   return error;
 }
 
@@ -144,6 +150,8 @@ ChunkFlowData::ChunkFlowData()
   numFlows = 0;
   bufferSize = 0;
   lastFlow = false;
+  producerStallSec = 0;
+  queueDepth = 0;
 }
 
 ChunkFlowData::ChunkFlowData(unsigned int colXrow, unsigned int flows, unsigned int bufSize)
@@ -155,6 +163,8 @@ ChunkFlowData::ChunkFlowData(unsigned int colXrow, unsigned int flows, unsigned
   numFlows = flows;
   bufferSize = bufSize;
   lastFlow = false;
+  producerStallSec = 0;
+  queueDepth = 0;
 }
 
 ChunkFlowData::~ChunkFlowData() 
@@ -337,6 +347,10 @@ void RawWells::Init ( const char *experimentPath, const char *rawWellsName, int
   }
   mCurrentWell = 0;
   mCompression = 3;
+  mReadThreads = 1;
+  mFlatMap = NULL;
+  mFlatMapSize = 0;
+  mFlatWells = NULL;
   SetRows ( rows );
   SetCols ( cols );
   SetFlows ( flows );
@@ -1445,6 +1459,11 @@ void RawWells::OpenForIncrementalRead()
     OpenWellsToRead();
     ReadRanks();
     ReadInfo();
+    string flatFile = FlatWellsPath ( mFilePath );
+    if ( mFlatWells == NULL && isFile ( flatFile.c_str() ) )
+    {
+      MapFlatWells ( flatFile );
+    }
   }
   else if ( mHFile < 0 )
   {
@@ -1459,19 +1478,177 @@ void RawWells::OpenForIncrementalRead()
   H5Eset_auto2 ( H5E_DEFAULT, old_func, old_client_data );
 }
 
+/** One hdf5 chunk aligned block of the current region. */
+struct RawWells::WellsBlock
+{
+  uint32_t rowStart, rowEnd, colStart, colEnd;
+  std::vector<float> values;
+  std::vector<unsigned short> quantized; ///< Raw values when stored as unsigned short
+};
+
+/** Hands blocks read from hdf5 over to the decode threads. */
+struct RawWells::WellsBlockQueue
+{
+  RawWells *wells;
+  std::deque<WellsBlock *> pending;
+  size_t inFlight;
+  bool done;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+};
+
+void RawWells::ReadWellsBlock ( WellsBlock &block )
+{
+  hsize_t count[3];       /* size of the hyperslab in the file */
+  hsize_t offset[3];      /* hyperslab offset in the file */
+  hsize_t count_out[3];   /* size of the hyperslab in memory */
+  hsize_t offset_out[3];  /* hyperslab offset in memory */
+  offset[0] = block.rowStart;
+  offset[1] = block.colStart;
+  offset[2] = mChunk.flowStart;
+  count[0] = block.rowEnd - block.rowStart;
+  count[1] = block.colEnd - block.colStart;
+  count[2] = mChunk.flowDepth;
+  herr_t status = 0;
+  status = H5Sselect_hyperslab ( mWells.mDataspace, H5S_SELECT_SET, offset, NULL,
+                                 count, NULL );
+  if ( status < 0 )
+  {
+    ION_ABORT ( "Couldn't read wells dataspace for: " +
+                ToStr ( mChunk.rowStart ) + "," + ToStr ( mChunk.colStart ) + "," +
+                ToStr ( mChunk.rowHeight ) + "," + ToStr ( mChunk.colWidth ) + " x " +
+                ToStr ( mChunk.flowDepth ) );
+  }
+
+  hsize_t     dimsm[3];              /* memory space dimensions */
+  hid_t       memspace;
+  /*
+   * Define the memory dataspace.
+   */
+  dimsm[0] = count[0];
+  dimsm[1] = count[1];
+  dimsm[2] = count[2];
+  memspace = H5Screate_simple ( 3,dimsm,NULL );
+
+  offset_out[0] = 0;
+  offset_out[1] = 0;
+  offset_out[2] = 0;
+  count_out[0] = count[0];
+  count_out[1] = count[1];
+  count_out[2] = count[2];
+  status = H5Sselect_hyperslab ( memspace, H5S_SELECT_SET, offset_out, NULL,
+                                 count_out, NULL );
+  if ( status < 0 )
+  {
+    H5Sclose ( memspace );
+    ION_ABORT ( "Couldn't read wells hyperslab for: " +
+                ToStr ( mChunk.rowStart ) + "," + ToStr ( mChunk.colStart ) + "," +
+                ToStr ( mChunk.rowHeight ) + "," + ToStr ( mChunk.colWidth ) + " x " +
+                ToStr ( mChunk.flowDepth ) );
+  }
+
+  uint64_t numValues = ( uint64_t ) count[0] * count[1] * count[2];
+  if ( mSaveAsUShort )
+  {
+    block.quantized.resize ( numValues, 0 );
+    status = H5Dread ( mWells.mDataset, H5T_NATIVE_USHORT, memspace, mWells.mDataspace,
+                       H5P_DEFAULT, &block.quantized[0] );
+  }
+  else
+  {
+    block.values.resize ( numValues, 0.0f );
+    status = H5Dread ( mWells.mDataset, H5T_NATIVE_FLOAT, memspace, mWells.mDataspace,
+                       H5P_DEFAULT, &block.values[0] );
+  }
+  H5Sclose ( memspace );
+
+  if ( status < 0 )
+  {
+    ION_ABORT ( "Couldn't read wells dataset for file: "  + mFilePath + " dims: " + ToStr ( mChunk.rowStart ) + "," +
+                ToStr ( mChunk.colStart ) + "," + ToStr ( mChunk.rowHeight ) + "," +
+                ToStr ( mChunk.colWidth ) + " x " + ToStr ( mChunk.flowDepth ) );
+  }
+}
+
+void RawWells::DecodeWellsBlock ( WellsBlock &block )
+{
+  if ( mSaveAsUShort )
+  {
+    WellsConverter converter ( mLower, mUpper );
+    block.values.resize ( block.quantized.size() );
+    for ( size_t i = 0; i < block.quantized.size(); i++ )
+    {
+      block.values[i] = converter.UInt16ToFloat ( block.quantized[i] );
+    }
+    std::vector<unsigned short>().swap ( block.quantized );
+  }
+
+  bool applyCopies = mSaveAsUShort && mConvertWithCopies;
+  uint64_t localCount = 0;
+  for ( size_t row = block.rowStart; row < block.rowEnd; row++ )
+  {
+    for ( size_t col = block.colStart; col < block.colEnd; col++, localCount++ )
+    {
+      int idx = ToIndex ( col, row );
+      if ( mIndexes[idx] < 0 )
+      {
+        continue;
+      }
+      const float *src = &block.values[localCount * mChunk.flowDepth];
+      float *dst = &mFlowData[ ( uint64_t ) mIndexes[idx] * mChunk.flowDepth];
+      if ( applyCopies )
+      {
+        float copies = mWellsCopies2[row * mCols + col];
+        for ( size_t flow = 0; flow < mChunk.flowDepth; flow++ )
+        {
+          dst[flow] = copies > 0 ? src[flow] * copies : -1.0f;
+        }
+      }
+      else
+      {
+        copy ( src, src + mChunk.flowDepth, dst );
+      }
+    }
+  }
+  std::vector<float>().swap ( block.values );
+}
+
+void *RawWells::DecodeWellsBlockThread ( void *arg )
+{
+  WellsBlockQueue *queue = ( WellsBlockQueue * ) arg;
+  while ( true )
+  {
+    pthread_mutex_lock ( &queue->mutex );
+    while ( queue->pending.empty() && !queue->done )
+    {
+      pthread_cond_wait ( &queue->cond, &queue->mutex );
+    }
+    if ( queue->pending.empty() )
+    {
+      pthread_mutex_unlock ( &queue->mutex );
+      break;
+    }
+    WellsBlock *block = queue->pending.front();
+    queue->pending.pop_front();
+    pthread_mutex_unlock ( &queue->mutex );
+
+    // Blocks cover disjoint wells so they can be scattered into mFlowData concurrently.
+    queue->wells->DecodeWellsBlock ( *block );
+
+    pthread_mutex_lock ( &queue->mutex );
+    queue->inFlight--;
+    pthread_cond_broadcast ( &queue->cond );
+    pthread_mutex_unlock ( &queue->mutex );
+  }
+  return NULL;
+}
+
 void RawWells::ReadWells()
 {
-  if ( mIsLegacy )
+  if ( mIsLegacy || mFlatWells != NULL )
   {
     return;
   }
-  vector<float> inputBuffer; // 100x100
-  uint64_t stepSize = (uint64_t)mWellChunkSizeRow*(uint64_t)mWellChunkSizeCol;
-  inputBuffer.resize ( stepSize*mChunk.flowDepth,0.0f );
-  // Assume whole chip if region if region isn't set
-  //  int currentWellStart = 0, currentWellEnd = min(stepSize,NumWells());
-  uint32_t currentRowStart = 0, currentRowEnd = min ( mWellChunkSizeRow, mRows );
-  uint32_t currentColStart = 0, currentColEnd = min ( mWellChunkSizeCol, mCols );
 
   size_t wellsInSubset = 0;
   for ( size_t i = 0; i < mIndexes.size(); i++ )
@@ -1484,129 +1661,258 @@ void RawWells::ReadWells()
 
   mFlowData.resize ( ( uint64_t ) wellsInSubset * mChunk.flowDepth );
   fill ( mFlowData.begin(), mFlowData.end(), -1.0f );
-  for ( currentRowStart = mChunk.rowStart, currentRowEnd = mChunk.rowStart + min ( mWellChunkSizeRow, mChunk.rowHeight );
-        currentRowStart < mRows && currentRowStart < mChunk.rowStart + mChunk.rowHeight;
-        currentRowStart = currentRowEnd, currentRowEnd += mWellChunkSizeRow )
-  {
-    currentRowEnd = min ( ( uint32_t ) mRows, currentRowEnd );
-    for ( currentColStart = mChunk.colStart, currentColEnd = mChunk.colStart + min ( mWellChunkSizeCol, mChunk.colWidth );
-          currentColStart < mCols && currentColStart < mChunk.colStart + mChunk.colWidth;
-          currentColStart = currentColEnd, currentColEnd += mWellChunkSizeCol )
+
+  // Cut the region along the hdf5 chunk grid so every hyperslab touches (and
+  // decompresses) a single chunk instead of straddling up to four of them.
+  uint32_t rowEnd = min ( mRows, mChunk.rowStart + mChunk.rowHeight );
+  uint32_t colEnd = min ( mCols, mChunk.colStart + mChunk.colWidth );
+  std::vector<WellsBlock> blocks;
+  for ( uint32_t gridRow = ( mChunk.rowStart / mWellChunkSizeRow ) * mWellChunkSizeRow;
+        gridRow < rowEnd; gridRow += mWellChunkSizeRow )
+  {
+    for ( uint32_t gridCol = ( mChunk.colStart / mWellChunkSizeCol ) * mWellChunkSizeCol;
+          gridCol < colEnd; gridCol += mWellChunkSizeCol )
     {
-      currentColEnd = min ( ( uint32_t ) mCols, currentColEnd );
+      WellsBlock block;
+      block.rowStart = max ( gridRow, ( uint32_t ) mChunk.rowStart );
+      block.rowEnd = min ( ( uint32_t ) ( gridRow + mWellChunkSizeRow ), rowEnd );
+      block.colStart = max ( gridCol, ( uint32_t ) mChunk.colStart );
+      block.colEnd = min ( ( uint32_t ) ( gridCol + mWellChunkSizeCol ), colEnd );
       // Don't go to disk unless we actually have a well to load.
-      if ( WellsInSubset ( currentRowStart, currentRowEnd, currentColStart, currentColEnd ) )
+      if ( WellsInSubset ( block.rowStart, block.rowEnd, block.colStart, block.colEnd ) )
       {
+        blocks.push_back ( block );
+      }
+    }
+  }
 
-        hsize_t count[3];       /* size of the hyperslab in the file */
-        hsize_t offset[3];      /* hyperslab offset in the file */
-        hsize_t count_out[3];   /* size of the hyperslab in memory */
-        hsize_t offset_out[3];  /* hyperslab offset in memory */
-        offset[0] = currentRowStart;
-        offset[1] = currentColStart;
-        offset[2] = 0;
-        count[0] = currentRowEnd - currentRowStart;
-        count[1] = currentColEnd - currentColStart;
-        count[2] = mChunk.flowDepth;
-        herr_t status = 0;
-        status = H5Sselect_hyperslab ( mWells.mDataspace, H5S_SELECT_SET, offset, NULL,
-                                       count, NULL );
-        if ( status < 0 )
-        {
-          ION_ABORT ( "Couldn't read wells dataspace for: " +
-                      ToStr ( mChunk.rowStart ) + "," + ToStr ( mChunk.colStart ) + "," +
-                      ToStr ( mChunk.rowHeight ) + "," + ToStr ( mChunk.colWidth ) + " x " +
-                      ToStr ( mChunk.flowDepth ) );
-        }
+  int numThreads = min ( ( size_t ) mReadThreads, blocks.size() );
+  if ( numThreads <= 1 )
+  {
+    for ( size_t i = 0; i < blocks.size(); i++ )
+    {
+      ReadWellsBlock ( blocks[i] );
+      DecodeWellsBlock ( blocks[i] );
+    }
+    return;
+  }
 
-        hsize_t     dimsm[3];              /* memory space dimensions */
-        hid_t       memspace;
-        /*
-         * Define the memory dataspace.
-         */
-        dimsm[0] = count[0];
-        dimsm[1] = count[1];
-        dimsm[2] = count[2];
-        memspace = H5Screate_simple ( 3,dimsm,NULL );
-
-        offset_out[0] = 0;
-        offset_out[1] = 0;
-        offset_out[2] = 0;
-        count_out[0] = currentRowEnd - currentRowStart;
-        count_out[1] = currentColEnd - currentColStart;
-        count_out[2] = mChunk.flowDepth;
-        // ClockTimer timer;
-        // timer.StartTimer();
-        status = H5Sselect_hyperslab ( memspace, H5S_SELECT_SET, offset_out, NULL,
-                                       count_out, NULL );
-        if ( status < 0 )
-        {
-          ION_ABORT ( "Couldn't read wells hyperslab for: " +
-                      ToStr ( mChunk.rowStart ) + "," + ToStr ( mChunk.colStart ) + "," +
-                      ToStr ( mChunk.rowHeight ) + "," + ToStr ( mChunk.colWidth ) + " x " +
-                      ToStr ( mChunk.flowDepth ) );
-        }
+  // hdf5 serializes reads internally, so this thread keeps reading blocks while
+  // the workers convert and scatter the ones already read.
+  WellsBlockQueue queue;
+  queue.wells = this;
+  queue.inFlight = 0;
+  queue.done = false;
+  pthread_mutex_init ( &queue.mutex, NULL );
+  pthread_cond_init ( &queue.cond, NULL );
+  std::vector<pthread_t> threads ( numThreads );
+  for ( int t = 0; t < numThreads; t++ )
+  {
+    if ( pthread_create ( &threads[t], NULL, DecodeWellsBlockThread, &queue ) )
+    {
+      ION_ABORT ( "Couldn't start wells decode thread." );
+    }
+  }
+  for ( size_t i = 0; i < blocks.size(); i++ )
+  {
+    pthread_mutex_lock ( &queue.mutex );
+    while ( queue.inFlight >= 2 * ( size_t ) numThreads )
+    {
+      pthread_cond_wait ( &queue.cond, &queue.mutex );
+    }
+    pthread_mutex_unlock ( &queue.mutex );
 
-        inputBuffer.resize ( ( uint64_t ) ( currentRowEnd - currentRowStart ) * ( currentColEnd - currentColStart ) * mFlows );
-        status = -1;
-        if(mSaveAsUShort)
-        {
-          WellsConverter converter(mLower, mUpper);
-          vector<unsigned short> inputBuffer2;
-          inputBuffer2.resize ( inputBuffer.size(), 0 );
-          status = H5Dread ( mWells.mDataset, H5T_NATIVE_USHORT, memspace, mWells.mDataspace,
-                           H5P_DEFAULT, &inputBuffer2[0] );
-
-		  vector<float>::iterator iter = inputBuffer.begin();
-		  vector<unsigned short>::iterator iter2 = inputBuffer2.begin();
-          for(; iter2 != inputBuffer2.end(); ++iter, ++iter2)
-          {
-            *iter = converter.UInt16ToFloat(*iter2);
-	      }
-        }
-		else
-        {
-          status = H5Dread ( mWells.mDataset, H5T_NATIVE_FLOAT, memspace, mWells.mDataspace,
-                           H5P_DEFAULT, &inputBuffer[0] );
-        }
+    ReadWellsBlock ( blocks[i] );
 
-        if ( status < 0 )
-        {
-          ION_ABORT ( "Couldn't read wells dataset for file: "  + mFilePath + " dims: " + ToStr ( mChunk.rowStart ) + "," +
-                      ToStr ( mChunk.colStart ) + "," + ToStr ( mChunk.rowHeight ) + "," +
-                      ToStr ( mChunk.colWidth ) + " x " + ToStr ( mChunk.flowDepth ) );
-        }
-        // std::cout << "Just read: " << currentRowStart  << "," << currentRowEnd << "," <<
-        //   currentColStart << "," << currentColEnd << " x " <<
-        //   mChunk.flowDepth << " in: " << timer.GetMicroSec() << "um seconds" << endl;
+    pthread_mutex_lock ( &queue.mutex );
+    queue.pending.push_back ( &blocks[i] );
+    queue.inFlight++;
+    pthread_cond_broadcast ( &queue.cond );
+    pthread_mutex_unlock ( &queue.mutex );
+  }
+  pthread_mutex_lock ( &queue.mutex );
+  queue.done = true;
+  pthread_cond_broadcast ( &queue.cond );
+  pthread_mutex_unlock ( &queue.mutex );
+  for ( int t = 0; t < numThreads; t++ )
+  {
+    pthread_join ( threads[t], NULL );
+  }
+  pthread_cond_destroy ( &queue.cond );
+  pthread_mutex_destroy ( &queue.mutex );
+}
 
-        uint64_t localCount = 0;
-        for ( size_t row = currentRowStart; row < currentRowEnd; row++ )
-        {
-          for ( size_t col = currentColStart; col < currentColEnd; col++ )
-          {
-            int idx = ToIndex ( col, row );
-            if ( mIndexes[idx] >= 0 )
-            {
-              for ( size_t flow = mChunk.flowStart; flow < mChunk.flowStart + mChunk.flowDepth; flow++ )
-              {
-				float val = inputBuffer[localCount * mChunk.flowDepth + flow];
-				if(mSaveAsUShort && mConvertWithCopies)
-				{
-					if(mWellsCopies2[ row * mCols + col] > 0)
-						val *= mWellsCopies2[ row * mCols + col];
-					else
-						val = -1.0;
-				}
-                Set ( row, col, flow, val );
-              }
-            }
-            localCount++;
-          }
-        }
+/** On disk header of the flat wells file, flow data starts at dataOffset. */
+struct FlatWellsHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t rows;
+  uint64_t cols;
+  uint64_t flows;
+  uint64_t sourceSize;   ///< Size of the hdf5 file it was written from
+  int64_t sourceMtime;   ///< Modification time of the hdf5 file it was written from
+  uint64_t dataOffset;
+};
+
+static const char FLAT_WELLS_MAGIC[8] = { 'I','O','N','W','F','L','A','T' };
+static const uint32_t FLAT_WELLS_VERSION = 1;
+static const uint64_t FLAT_WELLS_DATA_OFFSET = 4096; // page aligned flow data
+
+static bool WriteAllAt ( int fd, const char *buf, size_t bytes, off_t offset )
+{
+  while ( bytes > 0 )
+  {
+    ssize_t written = pwrite ( fd, buf, bytes, offset );
+    if ( written <= 0 )
+    {
+      if ( written < 0 && errno == EINTR )
+      {
+        continue;
+      }
+      return false;
+    }
+    buf += written;
+    bytes -= written;
+    offset += written;
+  }
+  return true;
+}
+
+bool RawWells::WriteFlatWells ( const std::string &flatFile )
+{
+  if ( mIsLegacy || mHFile < 0 || mFlatWells != NULL )
+  {
+    ION_WARN ( "Flat wells can only be written from an hdf5 wells file opened for reading." );
+    return false;
+  }
+  struct stat source;
+  if ( stat ( mFilePath.c_str(), &source ) != 0 )
+  {
+    ION_WARN ( "Couldn't stat: " + mFilePath );
+    return false;
+  }
+
+  // Write to a temporary name and rename so readers never map a partial file.
+  string tmpFile = flatFile + ".tmp";
+  int fd = open ( tmpFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+  if ( fd < 0 )
+  {
+    ION_WARN ( "Couldn't open: " + tmpFile + " for writing: " + strerror ( errno ) );
+    return false;
+  }
+
+  FlatWellsHeader header;
+  memset ( &header, 0, sizeof ( header ) );
+  memcpy ( header.magic, FLAT_WELLS_MAGIC, sizeof ( header.magic ) );
+  header.version = FLAT_WELLS_VERSION;
+  header.rows = mRows;
+  header.cols = mCols;
+  header.flows = mFlows;
+  header.sourceSize = source.st_size;
+  header.sourceMtime = source.st_mtime;
+  header.dataOffset = FLAT_WELLS_DATA_OFFSET;
+  bool ok = WriteAllAt ( fd, ( const char * ) &header, sizeof ( header ), 0 );
+
+  // Walk the chip in tiles of whole hdf5 chunks, SetChunk() limits the width.
+  WellChunk saved = mChunk;
+  std::vector<int32_t> savedSubset;
+  savedSubset.swap ( mWriteSubset );
+  size_t tileCols = max ( ( size_t ) 1, ( size_t ) 9999 / mWellChunkSizeCol ) * mWellChunkSizeCol;
+  for ( size_t row = 0; ok && row < mRows; row += mWellChunkSizeRow )
+  {
+    for ( size_t col = 0; ok && col < mCols; col += tileCols )
+    {
+      size_t height = min ( mWellChunkSizeRow, mRows - row );
+      size_t width = min ( tileCols, mCols - col );
+      SetChunk ( row, height, col, width, 0, mFlows );
+      ReadWells();
+      size_t bytes = width * mFlows * sizeof ( float );
+      for ( size_t r = 0; ok && r < height; r++ )
+      {
+        off_t offset = FLAT_WELLS_DATA_OFFSET + ( ( uint64_t ) ( row + r ) * mCols + col ) * mFlows * sizeof ( float );
+        ok = WriteAllAt ( fd, ( const char * ) &mFlowData[ ( uint64_t ) r * width * mFlows], bytes, offset );
       }
     }
   }
+  mWriteSubset.swap ( savedSubset );
+  SetChunk ( saved.rowStart, saved.rowHeight, saved.colStart, saved.colWidth, saved.flowStart, saved.flowDepth );
+
+  ok = ( close ( fd ) == 0 ) && ok;
+  if ( ok && rename ( tmpFile.c_str(), flatFile.c_str() ) == 0 )
+  {
+    return true;
+  }
+  ION_WARN ( "Couldn't write flat wells file: " + flatFile + ": " + strerror ( errno ) );
+  unlink ( tmpFile.c_str() );
+  return false;
+}
+
+bool RawWells::MapFlatWells ( const std::string &flatFile )
+{
+  UnmapFlatWells();
+  int fd = open ( flatFile.c_str(), O_RDONLY );
+  if ( fd < 0 )
+  {
+    ION_WARN ( "Couldn't open flat wells file: " + flatFile );
+    return false;
+  }
+
+  struct stat flat, source;
+  FlatWellsHeader header;
+  string problem;
+  if ( fstat ( fd, &flat ) != 0 ||
+       pread ( fd, &header, sizeof ( header ), 0 ) != ( ssize_t ) sizeof ( header ) ||
+       memcmp ( header.magic, FLAT_WELLS_MAGIC, sizeof ( header.magic ) ) != 0 ||
+       header.version != FLAT_WELLS_VERSION )
+  {
+    problem = "is not a flat wells file";
+  }
+  else if ( header.rows != mRows || header.cols != mCols || header.flows != mFlows )
+  {
+    problem = "doesn't match dimensions of " + mFilePath;
+  }
+  else if ( stat ( mFilePath.c_str(), &source ) != 0 ||
+            header.sourceSize != ( uint64_t ) source.st_size ||
+            header.sourceMtime != ( int64_t ) source.st_mtime )
+  {
+    problem = "is out of date with " + mFilePath;
+  }
+  else if ( ( uint64_t ) flat.st_size < header.dataOffset + ( uint64_t ) mRows * mCols * mFlows * sizeof ( float ) )
+  {
+    problem = "is truncated";
+  }
+  if ( !problem.empty() )
+  {
+    close ( fd );
+    ION_WARN ( "Flat wells file: " + flatFile + " " + problem + ", reading hdf5 instead." );
+    return false;
+  }
+
+  void *map = mmap ( NULL, flat.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+  close ( fd );
+  if ( map == MAP_FAILED )
+  {
+    ION_WARN ( "Couldn't mmap flat wells file: " + flatFile + ": " + strerror ( errno ) );
+    return false;
+  }
+  mFlatMap = map;
+  mFlatMapSize = flat.st_size;
+  mFlatWells = ( const float * ) ( ( const char * ) map + header.dataOffset );
+  std::vector<float>().swap ( mFlowData );
+  return true;
+}
+
+void RawWells::UnmapFlatWells()
+{
+  if ( mFlatMap != NULL )
+  {
+    munmap ( mFlatMap, mFlatMapSize );
+  }
+  mFlatMap = NULL;
+  mFlatMapSize = 0;
+  mFlatWells = NULL;
 }
 
 bool RawWells::WellsInSubset ( uint32_t currentRowStart, uint32_t currentRowEnd,
@@ -1644,6 +1950,10 @@ float RawWells::At ( size_t well, size_t flow ) const
   }
   if ( mIndexes[well] >= 0 )
   {
+    if ( mFlatWells != NULL )
+    {
+      return mFlatWells[ ( uint64_t ) well * mFlows + flow];
+    }
     uint64_t ii = ( uint64_t ) mIndexes[well] * mChunk.flowDepth + flow - mChunk.flowStart;
     assert ( ii < mFlowData.size() );
     return mFlowData[ii];
@@ -1663,6 +1973,10 @@ float RawWells::AtWithoutChecking ( size_t row, size_t col, size_t flow ) const
 
 float RawWells::AtWithoutChecking ( size_t well, size_t flow ) const
 {
+  if ( mFlatWells != NULL )
+  {
+    return mFlatWells[ ( uint64_t ) well * mFlows + flow];
+  }
   uint64_t ii = ( uint64_t ) mIndexes[well] * mChunk.flowDepth + flow - mChunk.flowStart;
   return mFlowData[ii];
 }
@@ -1794,6 +2108,7 @@ void RawWells::Close()
 {
   CloseWithoutCleanupHdf5();
   CleanupHdf5();
+  UnmapFlatWells();
 }
 
 void RawWells::GetRegion ( int &rowStart, int &height, int &colStart, int &width )
@@ -1827,6 +2142,10 @@ void RawWells::IndexToXY ( size_t index, size_t &x, size_t &y ) const
 
 void RawWells::Set ( size_t idx, size_t flow, float val )
 {
+  if ( mFlatWells != NULL )
+  {
+    ION_ABORT ( "Wells are mapped read only from: " + FlatWellsPath ( mFilePath ) );
+  }
   if ( mIndexes[idx] >= 0 )
   {
     uint64_t ii = ( uint64_t ) mIndexes[idx] * mChunk.flowDepth + flow - mChunk.flowStart;
@@ -1911,7 +2230,8 @@ void RawWells::InitIndexes()
       }
     }
   }
-  mFlowData.resize ( count * mChunk.flowDepth );
+  // Values come straight from the mapping when the flat file is in use.
+  mFlowData.resize ( mFlatWells != NULL ? 0 : count * mChunk.flowDepth );
   fill ( mFlowData.begin(), mFlowData.end(), -1.0f );
 }
 
@@ -2084,11 +2404,14 @@ void ChunkyWells::DoneUpThroughFlow( int flow, SemQueue* packQueue, SemQueue* wr
     return;
   }
 
+  // Waiting here means the writer has fallen behind and every buffer is in flight.
+  Timer stallTimer;
   ChunkFlowData* chunkData = NULL;
   while(NULL == chunkData)
   {
     chunkData = packQueue->deQueue();
   }
+  chunkData->producerStallSec = stallTimer.elapsed();
 
   if ( nextFlow == endingFlow )
   {
@@ -2100,6 +2423,7 @@ void ChunkyWells::DoneUpThroughFlow( int flow, SemQueue* packQueue, SemQueue* wr
   copy(mFlowData.begin(), mFlowData.end(), chunkData->flowData);
   copy(mIndexes.begin(), mIndexes.end(), chunkData->indexes);
 
+  chunkData->queueDepth = writeQueue->size();
   writeQueue->enQueue(chunkData);
 
   CloseWithoutCleanupHdf5();
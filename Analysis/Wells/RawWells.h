@@ -98,6 +98,12 @@ class RawWellsWriter {
    * returns 0 if no error and nonzero if error.
    */
   int WriteWellsData(RWH5DataSet &dataSet, WellChunk &chunk, float *data);
+  /** Same as above for data already converted with WellsConverter. */
+  int WriteWellsData(RWH5DataSet &dataSet, WellChunk &chunk, unsigned short *data);
+
+ private:
+  int WriteWellsBuffer(RWH5DataSet &dataSet, WellChunk &chunk, hid_t memType, const void *data);
+  std::vector<unsigned short> mUShortBuffer; ///< Reused conversion buffer for float writes
 };
 
 /**
@@ -161,6 +167,9 @@ public:
   unsigned int numFlows;
   unsigned int bufferSize;
   bool lastFlow;
+  /* Per flow block metrics filled in by ChunkyWells::DoneUpThroughFlow(). */
+  double producerStallSec; ///< Time the fitters waited for a free buffer
+  size_t queueDepth;       ///< Blocks already waiting to be written when this one was queued
 };
 
 /** semaphore control queue for multithreading. */
@@ -375,6 +384,22 @@ public:
   void SetConvertWithCopies(bool withCopies);
   void WriteWellsCopies();
 
+  /** Number of threads ReadWells() uses to decode hdf5 chunk aligned blocks. */
+  void SetReadThreads(int threads) { mReadThreads = std::max(threads, 1); }
+  int GetReadThreads() const { return mReadThreads; }
+
+  /* Flat, uncompressed float copy of the wells data that can be memory mapped.
+   * Laid out as [row][col][flow] with copies and unsigned short conversion
+   * already applied. OpenForIncrementalRead() maps FlatWellsPath() if present,
+   * after which ReadWells() is a no-op and At() reads straight from the mapping. */
+  static std::string FlatWellsPath(const std::string &wellsFile) { return wellsFile + ".flat"; }
+  bool WriteFlatWells(const std::string &flatFile);
+  bool MapFlatWells(const std::string &flatFile);
+  void UnmapFlatWells();
+  bool HaveFlatWells() const { return mFlatWells != NULL; }
+  /** All flows of a well in the mapped file, safe to use from any thread without locking. */
+  const float *FlatWell(size_t row, size_t col) const { return mFlatWells + ToIndex(col, row) * mFlows; }
+
  private:
   bool InChunk(size_t row, size_t col);
 
@@ -388,6 +413,13 @@ public:
   void CreateBuffers();
   bool WellsInSubset(uint32_t rowStart, uint32_t rowEnd, uint32_t colStart, uint32_t colEnd);
 
+  /* Chunk aligned block reading for ReadWells(). */
+  struct WellsBlock;
+  struct WellsBlockQueue;
+  void ReadWellsBlock(WellsBlock &block);
+  void DecodeWellsBlock(WellsBlock &block);
+  static void *DecodeWellsBlockThread(void *arg);
+
   bool OpenForReadLegacy();
   void CleanupHdf5();
 
@@ -460,6 +492,10 @@ private:
   float mUpper;
   std::vector<float> mWellsCopies;
   std::vector<float> mWellsCopies2;
+  int mReadThreads;           ///< Decode threads used by ReadWells()
+  void *mFlatMap;             ///< Memory mapping of the flat wells file, NULL if not mapped
+  size_t mFlatMapSize;
+  const float *mFlatWells;    ///< Start of the flow data inside mFlatMap
 
   // We keep around a write timer.
   SumTimer writeTimer;
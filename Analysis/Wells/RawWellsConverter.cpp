@@ -19,12 +19,14 @@ int main(int argc, const char *argv[])
 	string inFile, outFile;
 	bool help = false;
 	bool version = false;
+	bool flat = false;
 	double lower = -5.0;
 	double upper = 28.0;
 	opts.GetOption(inFile, "", 'i', "input-file");
 	opts.GetOption(outFile, "", 'o', "output-file");
 	opts.GetOption(lower, "-5.0", '-', "wells-convert-low");
 	opts.GetOption(upper, "28.0", '-', "wells-convert-high");
+	opts.GetOption(flat, "false", '-', "flat");
 	opts.GetOption(help, "false", 'h', "help");
 	opts.GetOption(version, "false", 'v', "version");
 	opts.CheckNoLeftovers();
@@ -43,6 +45,7 @@ int main(int argc, const char *argv[])
 			 << "   -o,--output-file   output wells file." << endl
 			 << "     ,--wells-convert-low   lower bound for converting to unsigned short." << endl
 			 << "     ,--wells-convert-high  upper bound for converting to unsigned short." << endl
+			 << "     ,--flat        write a flat, memory mappable copy next to the input (input_path/1.wells.flat)." << endl
 			 << "   -h,--help          this message." << endl
 			 << "" << endl 
 			 << "usage: " << endl
@@ -57,6 +60,24 @@ int main(int argc, const char *argv[])
 		exit (1);
 	}
 
+	if (flat)
+	{
+		RawWells wells("", inFile.c_str());
+		wells.OpenForIncrementalRead();
+		wells.UnmapFlatWells();
+		wells.SetReadThreads(numCores());
+		string flatFile = RawWells::FlatWellsPath(inFile);
+		bool ok = wells.WriteFlatWells(flatFile);
+		wells.Close();
+		if (!ok)
+		{
+			cerr << "RawWellsConverter ERROR: Fail to write " << flatFile << endl;
+			exit(1);
+		}
+		cout << "RawWellsConverter: wrote " << flatFile << endl;
+		exit(0);
+	}
+
 	if (outFile.empty())
 	{
 		outFile = inFile;
@@ -0,0 +1,102 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "deInterlace.h"
+#include "OptArgs.h"
+#include "IonErr.h"
+#include "Utils.h"
+
+using namespace std;
+
+// the DATs the regression tests in tests/test_analysis.py read
+static const char *defaultDats[] = {
+  "/results/PGM/B16-440-cropped/acq_0001.dat",
+  "/results/PGM2/test_B10-33_cropped/acq_0005.dat"
+};
+
+void usage() {
+  cout << "DatDecodeBench - Time deInterlace_c decoding of dat files" << endl;
+  cout << "" << endl;
+  cout << "usage: DatDecodeBench [--threads 1,4] [--reps 5] [file.dat ...]" << endl;
+  cout << "  --threads decode threads per image to try, each result is checked against the first" << endl;
+  cout << "  --reps    number of times each file is decoded per thread count" << endl;
+  cout << "  files default to the dats used by tests/test_analysis.py" << endl;
+  exit(1);
+}
+
+int main(int argc, const char *argv[]) {
+  OptArgs opts;
+  opts.ParseCmdLine(argc, argv);
+  bool help;
+  vector<int> threads;
+  int reps;
+  opts.GetOption(threads, "1,4", '-', "threads");
+  opts.GetOption(reps, "5", '-', "reps");
+  opts.GetOption(help, "false", 'h', "help");
+  vector<string> files;
+  opts.GetLeftoverArguments(files);
+  if (help || threads.empty() || reps < 1) {
+    usage();
+  }
+  if (files.empty()) {
+    for (size_t i = 0; i < sizeof(defaultDats) / sizeof(defaultDats[0]); i++)
+      files.push_back(defaultDats[i]);
+  }
+
+  int failed = 0;
+  for (size_t f = 0; f < files.size(); f++) {
+    struct stat st;
+    if (stat(files[f].c_str(), &st) != 0) {
+      cout << files[f] << ": not found, skipped" << endl;
+      continue;
+    }
+    double fileMb = st.st_size / (1024.0 * 1024.0);
+    short *reference = NULL;
+    size_t referenceLen = 0;
+
+    for (size_t t = 0; t < threads.size(); t++) {
+      SetDeInterlaceThreads(threads[t]);
+      short *out = NULL;
+      int *timestamps = NULL;
+      int rows = 0, cols = 0, frames = 0, uncompFrames = 0, imageState = 0;
+      double best = 0;
+      for (int r = 0; r < reps; r++) {
+        free(out);
+        free(timestamps);
+        out = NULL;
+        timestamps = NULL;
+        Timer timer;
+        int ok = deInterlace_c((char *)files[f].c_str(), &out, &timestamps, &rows, &cols, &frames, &uncompFrames,
+                               0, 0, 0, 0, 0, 0, 0, &imageState);
+        double sec = timer.elapsed();
+        ION_ASSERT(ok, "Couldn't load file: " + files[f]);
+        if (r == 0 || sec < best)
+          best = sec;
+      }
+      size_t len = (size_t)rows * cols * frames;
+      double outMb = len * sizeof(short) / (1024.0 * 1024.0);
+      printf("%s: %dx%dx%d threads %d: %.1f ms, %.1f MB/s file, %.1f MB/s decoded",
+             files[f].c_str(), cols, rows, frames, threads[t], best * 1000.0, fileMb / best, outMb / best);
+      if (reference == NULL) {
+        reference = out;
+        referenceLen = len;
+        out = NULL;
+        printf("\n");
+      }
+      else {
+        bool same = (len == referenceLen) && memcmp(reference, out, len * sizeof(short)) == 0;
+        printf(" %s\n", same ? "(matches)" : "(MISMATCH)");
+        if (!same)
+          failed = 1;
+      }
+      free(out);
+      free(timestamps);
+    }
+    free(reference);
+  }
+  return failed;
+}
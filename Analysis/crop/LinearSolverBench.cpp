@@ -0,0 +1,134 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <armadillo>
+
+#include "BkgFitLdlt.h"
+#include "OptArgs.h"
+#include "Utils.h"
+
+using namespace std;
+using namespace arma;
+
+// Solves per second of the lev-mar normal equations, BkgFitMatrixPacker::GetOutput style:
+// the old armadillo expression + solve against the heap-free LDL^T solver, one system at a time.
+// Systems are J'J of a random jacobian over 3n points with the lower triangle stored like
+// BuildMatrix does, so both paths form jtj_lambda from the same input.
+
+void usage() {
+  cout << "LinearSolverBench - Compare the lev-mar linear solve against armadillo" << endl;
+  cout << "" << endl;
+  cout << "usage: LinearSolverBench [--sizes 15,16,20,21,22,23,41] [--systems 20000] [--reps 3]" << endl;
+  cout << "  --sizes   fitted parameter counts to try" << endl;
+  cout << "  --systems systems solved per timing" << endl;
+  cout << "  --reps    timings per solver, the best is reported" << endl;
+  exit(1);
+}
+
+static double Uniform() {
+  return rand() / (double)RAND_MAX - 0.5;
+}
+
+int main(int argc, const char *argv[]) {
+  OptArgs opts;
+  opts.ParseCmdLine(argc, argv);
+  bool help;
+  vector<int> sizes;
+  int systems, reps;
+  opts.GetOption(sizes, "15,16,20,21,22,23,41", '-', "sizes");
+  opts.GetOption(systems, "20000", '-', "systems");
+  opts.GetOption(reps, "3", '-', "reps");
+  opts.GetOption(help, "false", 'h', "help");
+  if (help || sizes.empty() || systems < 1 || reps < 1)
+    usage();
+
+  srand(42);
+  const double lambda = 1.0e-3;
+  const double regularizer = 0.0;
+  int failed = 0;
+  for (size_t s = 0; s < sizes.size(); s++) {
+    int n = sizes[s];
+    if (n < 1) continue;
+    // lower-triangle jtj (column-major like Mat<double>) and rhs per system
+    vector<Mat<double> > jtj(systems);
+    vector<Col<double> > rhs(systems);
+    int m = 3 * n;
+    vector<double> jac(m * n);
+    for (int i = 0; i < systems; i++) {
+      for (size_t k = 0; k < jac.size(); k++)
+        jac[k] = Uniform();
+      jtj[i].zeros(n, n);
+      rhs[i].set_size(n);
+      for (int c = 0; c < n; c++) {
+        for (int r = c; r < n; r++) {
+          double sum = 0.0;
+          for (int k = 0; k < m; k++)
+            sum += jac[k * n + r] * jac[k * n + c];
+          jtj[i].at(r, c) = sum;
+        }
+        rhs[i].at(c) = Uniform();
+      }
+    }
+
+    // armadillo path
+    vector<Col<double> > delta(systems);
+    double arma_best = 0;
+    for (int r = 0; r < reps; r++) {
+      Timer timer;
+      for (int i = 0; i < systems; i++) {
+        Mat<double> jtj_lambda = trans(jtj[i]) + jtj[i] + (lambda - 1.0) * diagmat(jtj[i]) + regularizer * eye(n, n);
+        solve(delta[i], jtj_lambda, rhs[i]);
+      }
+      double sec = timer.elapsed();
+      if (r == 0 || sec < arma_best)
+        arma_best = sec;
+    }
+
+    // LDL^T path, forming jtj_lambda is part of the timing as it is in GetOutput
+    vector<double> a(n * n), b((size_t)systems * n), x((size_t)systems * n);
+    bool *ok = new bool[systems];
+    for (int i = 0; i < systems; i++)
+      for (int c = 0; c < n; c++)
+        b[(size_t)i * n + c] = rhs[i].at(c);
+    double ldlt_best = 0;
+    int solved = 0;
+    for (int r = 0; r < reps; r++) {
+      Timer timer;
+      solved = 0;
+      for (int i = 0; i < systems; i++) {
+        const double *src = jtj[i].memptr();
+        double *dst = &a[0];
+        for (int c = 0; c < n; c++) {
+          double d = src[c * n + c];
+          dst[c * n + c] = ((d + d) + (lambda - 1.0) * d) + regularizer;
+          for (int rr = c + 1; rr < n; rr++)
+            dst[rr * n + c] = src[rr * n + c] + src[c * n + rr];
+        }
+        ok[i] = BkgFitLdltSolve(n, dst, &b[(size_t)i * n], &x[(size_t)i * n]);
+        solved += ok[i];
+      }
+      double sec = timer.elapsed();
+      if (r == 0 || sec < ldlt_best)
+        ldlt_best = sec;
+    }
+
+    double worst = 0.0;
+    for (int i = 0; i < systems; i++) {
+      if (!ok[i]) continue;
+      for (int c = 0; c < n; c++) {
+        double ref = delta[i].at(c);
+        double rel = fabs(x[(size_t)i * n + c] - ref) / max(fabs(ref), 1e-12);
+        worst = max(worst, rel);
+      }
+    }
+    printf("n=%d: armadillo %.0f solves/s, ldlt %.0f solves/s, %.2fx, %d/%d positive definite, max rel diff %g\n",
+           n, systems / arma_best, systems / ldlt_best, arma_best / ldlt_best, solved, systems, worst);
+    if (worst > 1e-6)
+      failed = 1;
+    delete [] ok;
+  }
+  return failed;
+}
@@ -0,0 +1,183 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <vector>
+
+#include "hdf5.h"
+#include "SynchDatSerialize.h"
+#include "FlowChunk.h"
+#include "OptArgs.h"
+#include "IonErr.h"
+#include "Utils.h"
+
+using namespace std;
+
+// Compress and decompress a flow's worth of sdat chunks with each codec, GrindSynchDat style but
+// without the hdf5 part, so it is the codecs and the chunk threading that get timed.
+// Every round trip is checked against the input, lossless codecs have to match exactly.
+
+struct Codec {
+  const char *name;
+  TraceCompressor::CodeType type;
+  bool lossless;
+};
+
+static const Codec codecs[] = {
+  { "none", TraceCompressor::None, true },
+  { "venco", TraceCompressor::LosslessVenco, true },
+  { "svd", TraceCompressor::LossySvdDat, false },
+  { "delta", TraceCompressor::DeltaComp, true },
+  { "deltafst", TraceCompressor::DeltaCompFst, true },
+  { "deltafstsmx", TraceCompressor::DeltaCompFstSmX, true }
+};
+
+void usage() {
+  cout << "SdatCodecBench - Time sdat chunk compression and decompression for each codec" << endl;
+  cout << "" << endl;
+  cout << "usage: SdatCodecBench [--codecs none,venco,...] [--threads 1,4] [--reps 3] [file.sdat]" << endl;
+  cout << "  --codecs  codecs to try: none,venco,svd,delta,deltafst,deltafstsmx" << endl;
+  cout << "  --threads chunk threads to try" << endl;
+  cout << "  --reps    timings per codec and thread count, the best is reported" << endl;
+  cout << "  --rows, --cols, --frames, --chunk-rows, --chunk-cols" << endl;
+  cout << "            size of the synthetic flow used when no sdat file is given [800,800,40,100,100]" << endl;
+  exit(1);
+}
+
+// slow nuc step on a noisy per-well baseline, roughly what a time compressed flow looks like
+static void FillSynthetic(GridMesh<TraceChunk> &mesh, int rows, int cols, int frames, int chunkRows, int chunkCols) {
+  mesh.Init(rows, cols, chunkRows, chunkCols);
+  for (size_t bIx = 0; bIx < mesh.GetNumBin(); bIx++) {
+    int rowStart, rowEnd, colStart, colEnd;
+    mesh.GetBinCoords(bIx, rowStart, rowEnd, colStart, colEnd);
+    TraceChunk &chunk = mesh.GetItem(bIx);
+    chunk.SetChipInfo(rows, cols, frames);
+    chunk.SetDimensions(rowStart, rowEnd - rowStart, colStart, colEnd - colStart, 0, frames);
+    chunk.SetTimeData(frames, 15.0f, -5, 16, 5);
+    chunk.mBaseFrameRate = 66;
+    chunk.mTimePoints.resize(frames);
+    for (int f = 0; f < frames; f++)
+      chunk.mTimePoints[f] = f * 0.066f;
+    for (int r = rowStart; r < rowEnd; r++) {
+      for (int c = colStart; c < colEnd; c++) {
+        int baseline = 8000 + rand() % 400;
+        float ampl = (rand() % 100) / 2.0f;
+        for (int f = 0; f < frames; f++) {
+          float signal = f < 15 ? 0.0f : ampl * (1.0f - expf(-(f - 15) / 6.0f));
+          chunk.At(r, c, f) = (int16_t)(baseline + signal + rand() % 7 - 3);
+        }
+      }
+    }
+  }
+}
+
+static void FreeFlowChunks(vector<FlowChunk> &chunks) {
+  for (size_t i = 0; i < chunks.size(); i++) {
+    free(chunks[i].Data.p);
+    free(chunks[i].DeltaFrame.p);
+    chunks[i].Data.p = chunks[i].DeltaFrame.p = NULL;
+  }
+}
+
+int main(int argc, const char *argv[]) {
+  OptArgs opts;
+  opts.ParseCmdLine(argc, argv);
+  bool help;
+  vector<string> codecNames;
+  vector<int> threads;
+  int reps, rows, cols, frames, chunkRows, chunkCols;
+  opts.GetOption(codecNames, "none,venco,svd,delta,deltafst,deltafstsmx", '-', "codecs");
+  opts.GetOption(threads, "1,4", '-', "threads");
+  opts.GetOption(reps, "3", '-', "reps");
+  opts.GetOption(rows, "800", '-', "rows");
+  opts.GetOption(cols, "800", '-', "cols");
+  opts.GetOption(frames, "40", '-', "frames");
+  opts.GetOption(chunkRows, "100", '-', "chunk-rows");
+  opts.GetOption(chunkCols, "100", '-', "chunk-cols");
+  opts.GetOption(help, "false", 'h', "help");
+  vector<string> files;
+  opts.GetLeftoverArguments(files);
+  if (help || codecNames.empty() || threads.empty() || reps < 1 || rows < 1 || cols < 1 || frames < 1 || chunkRows < 1 || chunkCols < 1)
+    usage();
+
+  srand(42);
+  SynchDat sdat;
+  if (!files.empty()) {
+    TraceChunkSerializer reader;
+    reader.SetRecklessAbandon(true);
+    ION_ASSERT(reader.Read(files[0].c_str(), sdat), "Couldn't load file: " + files[0]);
+  }
+  else {
+    FillSynthetic(sdat.GetMesh(), rows, cols, frames, chunkRows, chunkCols);
+  }
+  GridMesh<TraceChunk> &mesh = sdat.GetMesh();
+  size_t numChunks = mesh.GetNumBin();
+  size_t values = 0;
+  for (size_t bIx = 0; bIx < numChunks; bIx++)
+    values += mesh.GetItem(bIx).mData.size();
+  double mb = values * sizeof(int16_t) / (1024.0 * 1024.0);
+  printf("%d x %d wells, %d max frames, %d chunks, %.1f MB\n", (int)sdat.NumRow(), (int)sdat.NumCol(),
+         sdat.GetMaxFrames(), (int)numChunks, mb);
+
+  int failed = 0;
+  for (size_t n = 0; n < codecNames.size(); n++) {
+    const Codec *codec = NULL;
+    for (size_t i = 0; i < sizeof(codecs) / sizeof(codecs[0]); i++)
+      if (codecNames[n] == codecs[i].name)
+        codec = &codecs[i];
+    if (codec == NULL) {
+      cout << codecNames[n] << ": unknown codec, skipped" << endl;
+      continue;
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+      TraceChunkSerializer serializer;
+      serializer.SetNumThreads(threads[t]);
+      serializer.SetCompressor(CompressorFactory::MakeCompressor(codec->type));
+      vector<FlowChunk> chunks(numChunks);
+      double compressBest = 0, decompressBest = 0;
+      size_t bytes = 0;
+      GridMesh<TraceChunk> decoded;
+      for (int r = 0; r < reps; r++) {
+        FreeFlowChunks(chunks);
+        Timer timer;
+        serializer.ArrangeDataForWriting(mesh, &chunks[0]);
+        double sec = timer.elapsed();
+        if (r == 0 || sec < compressBest)
+          compressBest = sec;
+      }
+      for (size_t bIx = 0; bIx < numChunks; bIx++)
+        bytes += chunks[bIx].Data.len;
+      for (int r = 0; r < reps; r++) {
+        decoded.Init(mesh.GetRow(), mesh.GetCol(), mesh.GetRowStep(), mesh.GetColStep());
+        Timer timer;
+        serializer.DecompressFromReading(&chunks[0], decoded);
+        double sec = timer.elapsed();
+        if (r == 0 || sec < decompressBest)
+          decompressBest = sec;
+      }
+      int maxDiff = 0;
+      for (size_t bIx = 0; bIx < numChunks; bIx++) {
+        const vector<int16_t> &in = mesh.GetItem(bIx).mData;
+        const vector<int16_t> &out = decoded.GetItem(bIx).mData;
+        if (in.size() != out.size()) {
+          maxDiff = INT_MAX;
+          break;
+        }
+        for (size_t i = 0; i < in.size(); i++)
+          maxDiff = max(maxDiff, abs(in[i] - out[i]));
+      }
+      bool ok = !codec->lossless || maxDiff == 0;
+      printf("%-12s threads %d: ratio %.2f, compress %.1f ms %.1f MB/s, decompress %.1f ms %.1f MB/s, max diff %d %s\n",
+             codec->name, threads[t], values * sizeof(int16_t) / (double)max(bytes, (size_t)1),
+             compressBest * 1000.0, mb / compressBest, decompressBest * 1000.0, mb / decompressBest, maxDiff,
+             ok ? "" : "(MISMATCH)");
+      if (!ok)
+        failed = 1;
+      FreeFlowChunks(chunks);
+    }
+  }
+  return failed;
+}
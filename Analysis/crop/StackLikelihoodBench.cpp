@@ -0,0 +1,193 @@
+/* Copyright (C) 2013 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+#include <vector>
+
+#include "StackEngine.h"
+#include "json/json.h"
+#include "OptArgs.h"
+
+using namespace std;
+
+// EM iterations per second of the ensemble evaluator on one stack of reads, the
+// ExecuteOneRestart loop without the bam and splicing parts: reset the derived qualities,
+// reset the latent variables and run FastExecuteInference.  Stacks come from a rich tvc
+// diagnostic json (CrossHypotheses/Cross with predictions, normalized and testflows) or are
+// made up.  After the timing the per read log-likelihoods are checked against a plain sum of
+// logs of TDistOddN over the test flows.
+
+void usage() {
+  cout << "StackLikelihoodBench - Time the ensemble evaluator EM loop on a stack of reads" << endl;
+  cout << "" << endl;
+  cout << "usage: StackLikelihoodBench [--reads 400] [--alts 1] [--flows 300] [--reps 3] [--iterations 20] [variant.diagnostic.json]" << endl;
+  cout << "  --reads, --alts, --flows" << endl;
+  cout << "               size of the synthetic stack used when no diagnostic json is given" << endl;
+  cout << "  --iterations inference runs per timing" << endl;
+  cout << "  --reps       timings, the best is reported" << endl;
+  exit(1);
+}
+
+// Utils.h has a split() that collides with vcflib's, so no Timer here
+static double Seconds() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static float Uniform() {
+  return rand() / (float)RAND_MAX;
+}
+
+// null (as called), ref and alts: the alts move a few flows next to the splice window,
+// the read is drawn from ref or one of the alts with some noise
+static void FillSynthetic(vector<CrossHypotheses> &stack, int num_reads, int num_alt, int num_flows) {
+  int num_hyp = num_alt + 2;
+  stack.resize(num_reads);
+  for (int i_read = 0; i_read < num_reads; i_read++) {
+    CrossHypotheses &my_cross = stack[i_read];
+    my_cross.CleanAllocate(num_hyp, num_flows);
+    my_cross.strand_key = i_read % 2;
+    my_cross.splice_start_flow = num_flows / 3;
+    my_cross.splice_end_flow = num_flows / 3 + 4;
+    my_cross.max_last_flow = num_flows;
+    for (int j_flow = 0; j_flow < num_flows; j_flow++)
+      my_cross.predictions[1][j_flow] = (float)(rand() % 4);
+    for (int i_hyp = 2; i_hyp < num_hyp; i_hyp++) {
+      my_cross.predictions[i_hyp] = my_cross.predictions[1];
+      int j_flow = my_cross.splice_start_flow + 1 + (i_hyp - 2) % 3;
+      my_cross.predictions[i_hyp][j_flow] += 1.0f;
+      my_cross.predictions[i_hyp][j_flow + 4] = max(0.0f, my_cross.predictions[i_hyp][j_flow + 4] - 1.0f);
+    }
+    int truth = 1 + rand() % (num_hyp - 1);
+    my_cross.predictions[0] = my_cross.predictions[truth];
+    vector<float> measured(num_flows);
+    for (int j_flow = 0; j_flow < num_flows; j_flow++)
+      measured[j_flow] = my_cross.predictions[truth][j_flow] + 0.15f * (Uniform() + Uniform() + Uniform() - 1.5f);
+    for (int i_hyp = 0; i_hyp < num_hyp; i_hyp++)
+      my_cross.normalized[i_hyp] = measured;
+    my_cross.InitializeTestFlows();
+  }
+}
+
+static bool LoadDiagnostic(const string &file_name, vector<CrossHypotheses> &stack) {
+  ifstream in(file_name.c_str());
+  Json::Value json;
+  Json::Reader reader;
+  if (!in.good() || !reader.parse(in, json)) {
+    cerr << "Couldn't parse " << file_name << " " << reader.getFormattedErrorMessages() << endl;
+    return false;
+  }
+  const Json::Value &cross = json["CrossHypotheses"]["Cross"];
+  if (cross.size() == 0 || !cross[0].isMember("predictions")) {
+    cerr << file_name << ": no per read predictions, needs a rich diagnostic json" << endl;
+    return false;
+  }
+  stack.resize(cross.size());
+  for (unsigned int i_read = 0; i_read < cross.size(); i_read++) {
+    const Json::Value &my_json = cross[i_read];
+    CrossHypotheses &my_cross = stack[i_read];
+    int num_hyp = my_json["predictions"].size();
+    int num_flows = my_json["predictions"][0].size();
+    my_cross.CleanAllocate(num_hyp, num_flows);
+    for (int i_hyp = 0; i_hyp < num_hyp; i_hyp++) {
+      for (int j_flow = 0; j_flow < num_flows; j_flow++) {
+        my_cross.predictions[i_hyp][j_flow] = my_json["predictions"][i_hyp][j_flow].asFloat();
+        my_cross.normalized[i_hyp][j_flow] = my_json["normalized"][i_hyp][j_flow].asFloat();
+      }
+    }
+    my_cross.test_flow.clear();
+    for (unsigned int i_test = 0; i_test < my_json["testflows"].size(); i_test++)
+      my_cross.test_flow.push_back(my_json["testflows"][i_test].asInt());
+    my_cross.strand_key = my_json["strand"].asInt();
+    my_cross.success = my_json["success"].asInt() != 0;
+    my_cross.use_correlated_likelihood = my_json["usecorr"].asInt() != 0;
+    my_cross.max_last_flow = my_json["lastrelevantflow"].asInt();
+    // the recorded test flows stand in for ComputeAllComparisonsTestFlow
+    my_cross.delta_state.ComputeDelta(my_cross.predictions);
+    my_cross.delta_state.ComputeCross(my_cross.test_flow);
+    my_cross.delta_state.ComputeDeltaCorrelation(my_cross.predictions, my_cross.test_flow);
+  }
+  return true;
+}
+
+int main(int argc, const char *argv[]) {
+  OptArgs opts;
+  opts.ParseCmdLine(argc, argv);
+  bool help;
+  int num_reads, num_alt, num_flows, reps, iterations;
+  opts.GetOption(num_reads, "400", '-', "reads");
+  opts.GetOption(num_alt, "1", '-', "alts");
+  opts.GetOption(num_flows, "300", '-', "flows");
+  opts.GetOption(reps, "3", '-', "reps");
+  opts.GetOption(iterations, "20", '-', "iterations");
+  opts.GetOption(help, "false", 'h', "help");
+  vector<string> files;
+  opts.GetLeftoverArguments(files);
+  if (help || num_reads < 1 || num_alt < 1 || num_flows < 20 || reps < 1 || iterations < 1)
+    usage();
+
+  srand(42);
+  HypothesisStack hypothesis_stack;
+  if (!files.empty()) {
+    if (!LoadDiagnostic(files[0], hypothesis_stack.total_theory.my_hypotheses))
+      return 1;
+  }
+  else {
+    FillSynthetic(hypothesis_stack.total_theory.my_hypotheses, num_reads, num_alt, num_flows);
+  }
+  ShortStack &total_theory = hypothesis_stack.total_theory;
+  int num_hyp_no_null = total_theory.my_hypotheses[0].predictions.size() - 1;
+  hypothesis_stack.PropagateTuningParameters(num_hyp_no_null);
+  total_theory.FindValidIndexes();
+  hypothesis_stack.AllocateFrequencyStarts(num_hyp_no_null);
+  size_t test_values = 0;
+  for (unsigned int i_read = 0; i_read < total_theory.my_hypotheses.size(); i_read++)
+    test_values += total_theory.my_hypotheses[i_read].test_flow.size() * (num_hyp_no_null + 1);
+  printf("%d reads, %d valid, %d hypotheses, %.1f test flows per read\n", (int)total_theory.my_hypotheses.size(),
+         (int)total_theory.valid_indexes.size(), num_hyp_no_null + 1,
+         test_values / (double)(num_hyp_no_null + 1) / total_theory.my_hypotheses.size());
+
+  double best = 0;
+  int em_steps = 0;
+  for (int r = 0; r < reps; r++) {
+    em_steps = 0;
+    double start = Seconds();
+    for (int i_iter = 0; i_iter < iterations; i_iter++) {
+      LatentSlate my_state = hypothesis_stack.cur_state;
+      my_state.detailed_integral = false;
+      total_theory.ResetQualities();
+      my_state.ResetToOrigin();
+      my_state.FastExecuteInference(total_theory, true, true, hypothesis_stack.try_hyp_freq[0]);
+      em_steps += my_state.iter_done;
+    }
+    double sec = Seconds() - start;
+    if (r == 0 || sec < best)
+      best = sec;
+  }
+
+  // log-likelihoods of the last run against the per flow sum of logs
+  double worst = 0.0;
+  for (unsigned int i_read = 0; i_read < total_theory.my_hypotheses.size(); i_read++) {
+    CrossHypotheses &my_cross = total_theory.my_hypotheses[i_read];
+    if (my_cross.use_correlated_likelihood)
+      continue;
+    for (unsigned int i_hyp = 0; i_hyp < my_cross.log_likelihood.size(); i_hyp++) {
+      double ref = 0.0;
+      for (unsigned int t_flow = 0; t_flow < my_cross.test_flow.size(); t_flow++) {
+        int j_flow = my_cross.test_flow[t_flow];
+        ref += log(my_cross.my_t.TDistOddN(my_cross.residuals[i_hyp][j_flow], my_cross.sigma_estimate[i_hyp][j_flow],
+                                           my_cross.skew_estimate));
+      }
+      worst = max(worst, fabs(my_cross.log_likelihood[i_hyp] - ref) / max(1.0, fabs(ref)));
+    }
+  }
+  bool ok = worst < 1e-3;
+  printf("%.1f inferences/s, %.1f EM steps/s, %.0f read steps/s, max rel log-likelihood diff %g %s\n",
+         iterations / best, em_steps / best, em_steps * (double)total_theory.my_hypotheses.size() / best,
+         worst, ok ? "" : "(MISMATCH)");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+/* Copyright (C) 2010 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include "DiffEqModelVec.h"
+#include "MathUtil.h"
+#include "OptArgs.h"
+#include "Utils.h"
+
+using namespace std;
+
+// Times the fused multi-flow total trace kernel against the three passes it replaces in
+// MultiFlowComputeTraceGivenIncorporationAndBackground: PurpleSolveTotalTrace_Vec, the gain and
+// the per flow dark matter. Every kernel width has to reproduce the three-pass trace exactly;
+// the tolerance is zero because both paths do the same operations in the same order.
+
+void usage() {
+  cout << "TraceModelBench - Time the fused total trace kernel against the separate passes" << endl;
+  cout << "" << endl;
+  cout << "usage: TraceModelBench [--flows 20] [--frames 60] [--beads 20000] [--reps 5] [--kernels sse,avx2,avx512]" << endl;
+  cout << "  --flows   flow block size" << endl;
+  cout << "  --frames  compressed frames per flow" << endl;
+  cout << "  --beads   beads evaluated per timing, each with its own tauB/etbR/gain" << endl;
+  cout << "  --reps    timings per kernel, the best is reported" << endl;
+  cout << "  --kernels fused kernel widths to try, ones this cpu can't run are skipped" << endl;
+  exit(1);
+}
+
+struct BenchBlock {
+  int flows, npts;
+  vector<float> deltaFrame;
+  vector<float> red, blue, dark;
+  vector<float> tauB, etbR;
+  float gain, darkness;
+};
+
+static float Uniform(float lo, float hi) {
+  return lo + (hi - lo) * (rand() / (float)RAND_MAX);
+}
+
+// smooth traces shaped roughly like the incorporation and empty-well signals
+static void FillBlock(BenchBlock &b, int flows, int npts) {
+  b.flows = flows;
+  b.npts = npts;
+  b.deltaFrame.resize(npts);
+  for (int i = 0; i < npts; i++)
+    b.deltaFrame[i] = i < npts / 2 ? 1.0f : 4.0f;
+  b.red.resize(flows * npts);
+  b.blue.resize(flows * npts);
+  b.dark.resize(flows * npts);
+  b.tauB.resize(flows);
+  b.etbR.resize(flows);
+  for (int f = 0; f < flows; f++) {
+    float ampl = Uniform(0.0f, 3.0f);
+    for (int i = 0; i < npts; i++) {
+      float t = (float)i / npts;
+      b.red[f * npts + i] = ampl * 50.0f * (1.0f - expf(-6.0f * t));
+      b.blue[f * npts + i] = 20.0f * t * expf(-3.0f * t) + Uniform(-0.5f, 0.5f);
+      b.dark[f * npts + i] = Uniform(-1.0f, 1.0f);
+    }
+    b.tauB[f] = Uniform(4.0f, 20.0f);
+    b.etbR[f] = Uniform(0.4f, 1.2f);
+  }
+  b.gain = Uniform(0.8f, 1.2f);
+  b.darkness = Uniform(0.0f, 1.0f);
+}
+
+static void Pointers(BenchBlock &b, float *out, vector<float *> &out_ptr,
+                     vector<float *> &red_ptr, vector<float *> &blue_ptr, vector<const float *> &dark_ptr) {
+  out_ptr.resize(b.flows);
+  red_ptr.resize(b.flows);
+  blue_ptr.resize(b.flows);
+  dark_ptr.resize(b.flows);
+  for (int f = 0; f < b.flows; f++) {
+    out_ptr[f] = out + f * b.npts;
+    red_ptr[f] = &b.red[f * b.npts];
+    blue_ptr[f] = &b.blue[f * b.npts];
+    dark_ptr[f] = &b.dark[f * b.npts];
+  }
+}
+
+static void ThreePass(BenchBlock &b, float *out) {
+  vector<float *> out_ptr, red_ptr, blue_ptr;
+  vector<const float *> dark_ptr;
+  Pointers(b, out, out_ptr, red_ptr, blue_ptr, dark_ptr);
+  MathModel::PurpleSolveTotalTrace_Vec(&out_ptr[0], &blue_ptr[0], &red_ptr[0], b.npts, &b.deltaFrame[0],
+                                       &b.tauB[0], &b.etbR[0], b.gain, b.flows);
+  MultiplyVectorByScalar(out, b.gain, b.flows * b.npts);
+  for (int f = 0; f < b.flows; f++)
+    AddScaledVector(out + f * b.npts, dark_ptr[f], b.darkness, b.npts);
+}
+
+static void Fused(BenchBlock &b, float *out) {
+  vector<float *> out_ptr, red_ptr, blue_ptr;
+  vector<const float *> dark_ptr;
+  Pointers(b, out, out_ptr, red_ptr, blue_ptr, dark_ptr);
+  MathModel::FusedSolveTotalTrace_Vec(&out_ptr[0], &blue_ptr[0], &red_ptr[0], b.npts, &b.deltaFrame[0],
+                                      &b.tauB[0], &b.etbR[0], b.gain, &dark_ptr[0], b.darkness, b.flows);
+}
+
+static double Time(void (*model)(BenchBlock &, float *), vector<BenchBlock> &blocks, vector<float> &out, int reps) {
+  int block_t = blocks[0].flows * blocks[0].npts;
+  double best = 0;
+  for (int r = 0; r < reps; r++) {
+    Timer timer;
+    for (size_t b = 0; b < blocks.size(); b++)
+      model(blocks[b], &out[b * block_t]);
+    double sec = timer.elapsed();
+    if (r == 0 || sec < best)
+      best = sec;
+  }
+  return best;
+}
+
+int main(int argc, const char *argv[]) {
+  OptArgs opts;
+  opts.ParseCmdLine(argc, argv);
+  bool help;
+  int flows, frames, beads, reps;
+  vector<string> kernels;
+  opts.GetOption(flows, "20", '-', "flows");
+  opts.GetOption(frames, "60", '-', "frames");
+  opts.GetOption(beads, "20000", '-', "beads");
+  opts.GetOption(reps, "5", '-', "reps");
+  opts.GetOption(kernels, "sse,avx2,avx512", '-', "kernels");
+  opts.GetOption(help, "false", 'h', "help");
+  // PurpleSolveTotalTrace_Vec loads its flow parameters 4 at a time
+  if (help || flows < 1 || flows % 4 != 0 || frames < 1 || beads < 1 || reps < 1)
+    usage();
+
+  srand(42);
+  vector<BenchBlock> blocks(beads);
+  for (int b = 0; b < beads; b++)
+    FillBlock(blocks[b], flows, frames);
+  size_t total = (size_t)beads * flows * frames;
+  vector<float> reference(total), out(total);
+
+  double base = Time(ThreePass, blocks, reference, reps);
+  printf("%d beads x %d flows x %d frames\n", beads, flows, frames);
+  printf("three-pass:    %.1f ms, %.1f ns/bead\n", base * 1000.0, base * 1e9 / beads);
+
+  int failed = 0;
+  for (size_t k = 0; k < kernels.size(); k++) {
+    if (!MathModel::SelectFusedSolveTotalTraceKernel(kernels[k].c_str())) {
+      printf("fused %-7s skipped, not supported here\n", kernels[k].c_str());
+      continue;
+    }
+    memset(&out[0], 0, total * sizeof(float));
+    double sec = Time(Fused, blocks, out, reps);
+    size_t mismatches = 0;
+    float max_diff = 0.0f;
+    for (size_t i = 0; i < total; i++) {
+      if (memcmp(&out[i], &reference[i], sizeof(float)) != 0)
+        mismatches++;
+      max_diff = max(max_diff, fabsf(out[i] - reference[i]));
+    }
+    printf("fused %-7s %.1f ms, %.1f ns/bead, %.2fx, max diff %g %s\n",
+           MathModel::FusedSolveTotalTraceKernelName(), sec * 1000.0, sec * 1e9 / beads, base / sec,
+           max_diff, mismatches == 0 ? "(matches)" : "(MISMATCH)");
+    if (mismatches)
+      failed = 1;
+  }
+  return failed;
+}
@@ -185,6 +185,7 @@ void IonstatsAlignmentOptions::WriteHelp(void)
   cerr << "  --max-subregion-hp           INT       max HP length for regional summary [" << DEFAULT_SUBREGION_MAX_HP << "]" << endl;
   cerr << "  --n-threads                  INT       number of threads for analysis, set to 0 to use numCores() [" << DEFAULT_N_THREADS << "]" << endl;
   cerr << "  --threads-share-memory       BOOL      controls whether threads write results to private or common mem [" << DEFAULT_THREADS_SHARE_MEMORY << "]" << endl;
+  cerr << "  --read-batch-size            INT       reads a thread takes from the input BAM at a time [" << DEFAULT_READ_BATCH_SIZE << "]" << endl;
   cerr << endl;
   cerr << "Options for spatial stratification of results.  All 3 options must be used together." << endl;
   cerr << "  Each option specifies two comma-separated values in the form x,y" << endl;
@@ -250,8 +251,15 @@ void IonstatsAlignmentOptions::InitializeFromOptArgs(OptArgs &opts, const string
   debug_positive_ref_flow_     = opts.GetFirstInt    ('-', "debug-positive-ref-flow",    DEFAULT_DEBUG_POSITIVE_REF_FLOW);
   n_threads_                   = opts.GetFirstInt    ('-', "n-threads",                  DEFAULT_N_THREADS);
   threads_share_memory_        = opts.GetFirstBoolean('-', "threads-share-memory",       DEFAULT_THREADS_SHARE_MEMORY);
+  int read_batch_size          = opts.GetFirstInt    ('-', "read-batch-size",            DEFAULT_READ_BATCH_SIZE);
 
 
+  if(read_batch_size < 1) {
+    cerr << "ERROR: " << program_ << ": read-batch-size must be at least 1" << endl;
+    exit(EXIT_FAILURE);
+  }
+  read_batch_size_ = read_batch_size;
+
   if(evaluate_per_read_per_flow_) {
     evaluate_flow_ = true;
     evaluate_hp_ = true;
@@ -402,8 +410,16 @@ int IonstatsAlignmentBamReader::Initialize(const vector<string> &input_bam_filen
 }
 
 bool IonstatsAlignmentBamReader::GetNextAlignment(BamAlignment &alignment, string &program) {
+  if(!GetNextAlignmentCore(alignment, program))
+    return(false);
+  alignment.BuildCharData();
+  return(true);
+}
+
+// Like GetNextAlignment but only decodes the core alignment data, the caller runs BuildCharData()
+bool IonstatsAlignmentBamReader::GetNextAlignmentCore(BamAlignment &alignment, string &program) {
   
-  if (input_bam_.GetNextAlignment(alignment)) {
+  if (input_bam_.GetNextAlignmentCore(alignment)) {
     // We got another read from the currently open BAM
     return(true);
   } else if(input_bam_filename_it_ == input_bam_filename_.end()) {
@@ -420,7 +436,7 @@ bool IonstatsAlignmentBamReader::GetNextAlignment(BamAlignment &alignment, strin
         cerr << program << ": ERROR: cannot open " << *input_bam_filename_it_ << " for read" << endl;
         exit(EXIT_FAILURE);
       }
-      if (input_bam_.GetNextAlignment(alignment)) {
+      if (input_bam_.GetNextAlignmentCore(alignment)) {
         return_status=true;
         break;
       }
@@ -1750,27 +1766,26 @@ void writeIonstatsH5(string h5_filename, bool append_h5_file, const vector<strin
   map< string, ErrorData > error_data;
   // Per-base data
   error_data["per_base"] = alignment_summary.BasePosition();
-  const map< string, ErrorData > & read_group_base_position = alignment_summary.ReadGroupBasePosition();
-  for(map < string, ErrorData >::const_iterator it=read_group_base_position.begin(); it != read_group_base_position.end(); ++it)
-    error_data["per_read_group/" + it->first + "/per_base"] = it->second;
+  for(unsigned int rg_idx=0; rg_idx < alignment_summary.NumReadGroups(); ++rg_idx)
+    error_data["per_read_group/" + alignment_summary.ReadGroupName(rg_idx) + "/per_base"] = alignment_summary.ReadGroupBasePosition(rg_idx);
   // Per-flow data
   ErrorData flow_position = alignment_summary.FlowPosition();
   if(flow_position.HasData())
     error_data["per_flow"] = flow_position;
-  map< string, ErrorData > & read_group_flow_position = alignment_summary.ReadGroupFlowPosition();
-  for(map < string, ErrorData >::iterator it=read_group_flow_position.begin(); it != read_group_flow_position.end(); ++it)
-    if(it->second.HasData())
-      error_data["per_read_group/" + it->first + "/per_flow"] = it->second;
+  if(alignment_summary.HaveReadGroupFlowPosition())
+    for(unsigned int rg_idx=0; rg_idx < alignment_summary.NumReadGroups(); ++rg_idx)
+      if(alignment_summary.ReadGroupFlowPosition(rg_idx).HasData())
+        error_data["per_read_group/" + alignment_summary.ReadGroupName(rg_idx) + "/per_flow"] = alignment_summary.ReadGroupFlowPosition(rg_idx);
   
   // Pack all the HpData objects into a map
   map< string, HpData > hp_data;
   HpData per_hp = alignment_summary.PerHp();
   if(per_hp.HasData())
     hp_data["per_hp"] = per_hp;
-  map< string, HpData > & read_group_per_hp = alignment_summary.ReadGroupPerHp();
-  for(map < string, HpData >::iterator it=read_group_per_hp.begin(); it != read_group_per_hp.end(); ++it)
-    if(it->second.HasData())
-      hp_data["per_read_group/" + it->first + "/per_hp"] = it->second;
+  if(alignment_summary.HaveReadGroupPerHp())
+    for(unsigned int rg_idx=0; rg_idx < alignment_summary.NumReadGroups(); ++rg_idx)
+      if(alignment_summary.ReadGroupPerHp(rg_idx).HasData())
+        hp_data["per_read_group/" + alignment_summary.ReadGroupName(rg_idx) + "/per_hp"] = alignment_summary.ReadGroupPerHp(rg_idx);
 
   // Pack RegionalSummary objects into a map
   map< string, RegionalSummary > regional_data;
@@ -2360,7 +2375,6 @@ void * processAlignments(void *in) {
   initialize_reverse_complement_map(reverse_complement_map);
 
   // Get flow orders and keys for each read group
-  map< string, int > read_groups      = pac->input_bam->ReadGroups();
   map< string, string > flow_orders   = pac->input_bam->FlowOrders();
   map< string, string > key_bases     = pac->input_bam->KeyBases();
   map< string, int > key_len          = pac->input_bam->KeyLen();
@@ -2400,17 +2414,34 @@ void * processAlignments(void *in) {
   vector<int> aq_length;
   aq_length.reserve(pac->opt->NErrorRates());
 
+  // Read groups are looked up once per read, the flow order of each is kept by read group index
+  vector<string> rg_flow_order(pac->alignment_summary->NumReadGroups());
+  for(unsigned int rg_idx=0; rg_idx < rg_flow_order.size(); ++rg_idx)
+    rg_flow_order[rg_idx] = flow_orders[pac->alignment_summary->ReadGroupName(rg_idx)];
+  string no_flow_order = "";
+
   // Loop over mapped reads in the input BAM
-  BamAlignment alignment;
+  vector<BamAlignment> input_batch(pac->opt->ReadBatchSize());
+  unsigned int batch_size=0;
+  unsigned int batch_idx=0;
   bool done=false;
   while(!done) {
-    // Lock the read_mutex while we get the next alignment
-    pthread_mutex_lock(pac->read_mutex);
-    if(!pac->input_bam->GetNextAlignment(alignment,pac->opt->Program()))
-      done=true;
-    pthread_mutex_unlock(pac->read_mutex);
-    if(done)
-      continue;
+    if(batch_idx == batch_size) {
+      // Lock the read_mutex only to inflate and decode the core data of a batch of alignments,
+      // the character data is built by each thread for its own batch
+      batch_idx = 0;
+      batch_size = 0;
+      pthread_mutex_lock(pac->read_mutex);
+      while(batch_size < input_batch.size() && pac->input_bam->GetNextAlignmentCore(input_batch[batch_size],pac->opt->Program()))
+        ++batch_size;
+      pthread_mutex_unlock(pac->read_mutex);
+      if(batch_size == 0) {
+        done=true;
+        continue;
+      }
+    }
+    BamAlignment &alignment = input_batch[batch_idx++];
+    alignment.BuildCharData();
 
     // Optionally replicate input to output
     if(pac->opt->OutputBamFilename() != "") {
@@ -2485,6 +2516,9 @@ void * processAlignments(void *in) {
       }
     }
 
+    int rg_idx = pac->alignment_summary->ReadGroupIndex(read_group);
+    string &read_flow_order = (rg_idx < 0) ? no_flow_order : rg_flow_order[rg_idx];
+
     //
     // Accumulate statistics that are independent of alignment
     //
@@ -2518,9 +2552,9 @@ void * processAlignments(void *in) {
     pac->alignment_summary->AddQ20Length(Q20_length);
     // Record data for system snr
     if(alignment.GetTag("ZM", flow_signal_zm))
-      pac->alignment_summary->AddSystemSNR(flow_signal_zm, pac->opt->SeqKey(), flow_orders[read_group]);
+      pac->alignment_summary->AddSystemSNR(flow_signal_zm, pac->opt->SeqKey(), read_flow_order);
     else if(alignment.GetTag("FZ", flow_signal_fz))
-      pac->alignment_summary->AddSystemSNR(flow_signal_fz, pac->opt->SeqKey(), flow_orders[read_group]);
+      pac->alignment_summary->AddSystemSNR(flow_signal_fz, pac->opt->SeqKey(), read_flow_order);
     // Record qv histogram
     pac->alignment_summary->AddQVHistogram(alignment.Qualities);
     // read length including barcode
@@ -2618,24 +2652,24 @@ void * processAlignments(void *in) {
       pac->alignment_summary->AddFlowPosition(flow_space_errors);
     if(pac->opt->EvaluateHp() && !invalid_ref_bases) {
       if(pac->opt->EvaluateFlow())
-        pac->alignment_summary->AddPerHp(ref_hp_nuc, ref_hp_len, ref_hp_err, ref_hp_flow, zeromer_insertion_flow, zeromer_insertion_len, flow_orders[read_group], pac->opt->IgnoreTerminalHp());
+        pac->alignment_summary->AddPerHp(ref_hp_nuc, ref_hp_len, ref_hp_err, ref_hp_flow, zeromer_insertion_flow, zeromer_insertion_len, read_flow_order, pac->opt->IgnoreTerminalHp());
       else
         pac->alignment_summary->AddPerHp(ref_hp_nuc, ref_hp_len, ref_hp_err, pac->opt->IgnoreTerminalHp());
     }
     // Accumulate per-read-group performance stratified by base, flow or hp
     if(read_group == "") {
       pac->alignment_summary->IncrementNoReadGroupCount();
-    } else if(read_groups.find(read_group) == read_groups.end()) {
+    } else if(rg_idx < 0) {
       pac->alignment_summary->IncrementUnmatchedReadGroupCount();
     } else {
-      pac->alignment_summary->AddReadGroupBasePosition(read_group, base_space_errors);
+      pac->alignment_summary->AddReadGroupBasePosition(rg_idx, base_space_errors);
       if(pac->opt->EvaluateFlow() && flow_space_errors.have_data())
-        pac->alignment_summary->AddReadGroupFlowPosition(read_group, flow_space_errors);
+        pac->alignment_summary->AddReadGroupFlowPosition(rg_idx, flow_space_errors);
       if(pac->opt->EvaluateHp() && !invalid_ref_bases) {
         if(pac->opt->EvaluateFlow())
-          pac->alignment_summary->AddReadGroupPerHp(read_group, ref_hp_nuc, ref_hp_len, ref_hp_err, ref_hp_flow, zeromer_insertion_flow, zeromer_insertion_len, flow_orders[read_group], pac->opt->IgnoreTerminalHp());
+          pac->alignment_summary->AddReadGroupPerHp(rg_idx, ref_hp_nuc, ref_hp_len, ref_hp_err, ref_hp_flow, zeromer_insertion_flow, zeromer_insertion_len, read_flow_order, pac->opt->IgnoreTerminalHp());
         else
-          pac->alignment_summary->AddReadGroupPerHp(read_group, ref_hp_nuc, ref_hp_len, ref_hp_err, pac->opt->IgnoreTerminalHp());
+          pac->alignment_summary->AddReadGroupPerHp(rg_idx, ref_hp_nuc, ref_hp_len, ref_hp_err, pac->opt->IgnoreTerminalHp());
       }
     }
     // Accumulate regional performance
@@ -41,6 +41,7 @@
 #define DEFAULT_DEBUG_POSITIVE_REF_FLOW    -1
 #define DEFAULT_N_THREADS                  5
 #define DEFAULT_THREADS_SHARE_MEMORY       "false"
+#define DEFAULT_READ_BATCH_SIZE            256
 
 using namespace std;
 using namespace BamTools;
@@ -81,7 +82,8 @@ public:
   n_error_rates_(0),
   max_flow_order_len_(0),
   n_threads_(0),
-  threads_share_memory_(false)
+  threads_share_memory_(false),
+  read_batch_size_(0)
   {}
   ~IonstatsAlignmentOptions () {}
 
@@ -134,6 +136,7 @@ public:
   double                 QvToErrorRate(int i)                 { return(qv_to_error_rate_[i]); };
   unsigned int           NThreads(void)                       { return(n_threads_); };
   bool                   ThreadsShareMemory(void)             { return(threads_share_memory_); };
+  unsigned int           ReadBatchSize(void)                  { return(read_batch_size_); };
 
 private:
 
@@ -180,6 +183,7 @@ private:
   unsigned int max_flow_order_len_;
   unsigned int n_threads_;
   bool threads_share_memory_;
+  unsigned int read_batch_size_;
 };
 
 class IonstatsAlignmentBamReader {
@@ -200,6 +204,7 @@ public:
     RefVector &reference_data
   );
   bool GetNextAlignment(BamAlignment &alignment, string &program);
+  bool GetNextAlignmentCore(BamAlignment &alignment, string &program);
 
   map< string, int > &    ReadGroups(void)      { return(read_groups_); };
   map< string, string > & FlowOrders(void)      { return(flow_orders_); };
@@ -41,21 +41,20 @@ void AlignmentSummary::Initialize(map< string, int > & read_groups, IonstatsAlig
   // Initialize per-read-group structures for any new read groups
   for(map< string, int >::iterator it = read_groups.begin(); it != read_groups.end(); ++it) {
     // Check if the read group has already been seen
-    map< string, ErrorData >::iterator rg_it = read_group_base_position_.find(it->first);
-    if(rg_it != read_group_base_position_.end())
+    if(read_group_idx_.find(it->first) != read_group_idx_.end())
       continue;
     // It is a new read group, need to initialize
-    ErrorData temp_error_data;
-    read_group_base_position_[it->first] = temp_error_data;
-    read_group_base_position_[it->first].Initialize(opt.HistogramLength());
+    read_group_idx_[it->first] = read_group_name_.size();
+    read_group_name_.push_back(it->first);
+    read_group_base_position_.push_back(ErrorData());
+    read_group_base_position_.back().Initialize(opt.HistogramLength());
     if(opt.EvaluateFlow()) {
-      read_group_flow_position_[it->first] = temp_error_data;
-      read_group_flow_position_[it->first].Initialize(opt.NFlow());
+      read_group_flow_position_.push_back(ErrorData());
+      read_group_flow_position_.back().Initialize(opt.NFlow());
     }
     if(opt.EvaluateHp()) {
-      HpData temp_hp_data;
-      read_group_per_hp_[it->first] = temp_hp_data;
-      read_group_per_hp_[it->first].Initialize(opt.MaxHp());
+      read_group_per_hp_.push_back(HpData());
+      read_group_per_hp_.back().Initialize(opt.MaxHp());
     }
   }
 }
@@ -134,7 +133,7 @@ void AlignmentSummary::MergeFrom(AlignmentSummary &other) {
     exit(EXIT_FAILURE);
   } else {
     for(unsigned int i=0; i<aq_histogram_bc_.size(); ++i)
-      aq_histogram_bc_[i] = other.AqHistogramBc()[i];
+      aq_histogram_bc_[i].MergeFrom(other.AqHistogramBc()[i]);
   }
   // Per-base and per-flow error data
   base_position_error_count_.MergeFrom(other.BasePositionErrorCount());
@@ -142,33 +141,17 @@ void AlignmentSummary::MergeFrom(AlignmentSummary &other) {
   flow_position_.MergeFrom(other.FlowPosition());
   per_hp_.MergeFrom(other.PerHp());
   // Read Group per-base and per-flow error data
-  for(map< string, ErrorData >::iterator other_it=other.ReadGroupBasePosition().begin(); other_it != other.ReadGroupBasePosition().end(); ++other_it) {
-    map< string, ErrorData >::iterator it = read_group_base_position_.find(other_it->first);
-    if(it == read_group_base_position_.end()) {
-      cerr << "ERROR: unable to merge base position data for read group " << other_it->first << endl;
-      exit(EXIT_FAILURE);
-    } else {
-      read_group_base_position_[it->first].MergeFrom(other_it->second);
-    }
-  }
-  for(map< string, ErrorData >::iterator other_it=other.ReadGroupFlowPosition().begin(); other_it != other.ReadGroupFlowPosition().end(); ++other_it) {
-    map< string, ErrorData >::iterator it = read_group_flow_position_.find(other_it->first);
-    if(it == read_group_flow_position_.end()) {
-      cerr << "ERROR: unable to merge flow position data for read group " << other_it->first << endl;
-      exit(EXIT_FAILURE);
-    } else {
-      read_group_flow_position_[it->first].MergeFrom(other_it->second);
-    }
-  }
-  for(map< string, HpData >::iterator other_it=other.ReadGroupPerHp().begin(); other_it != other.ReadGroupPerHp().end(); ++other_it) {
-    map< string, HpData >::iterator it = read_group_per_hp_.find(other_it->first);
-    if(it == read_group_per_hp_.end()) {
-      cerr << "ERROR: unable to merge per hp data for read group " << other_it->first << endl;
-      exit(EXIT_FAILURE);
-    } else {
-      read_group_per_hp_[it->first].MergeFrom(other_it->second);
-    }
+  // Both summaries were initialized from the same read groups, so the slots line up
+  if(read_group_name_ != other.read_group_name_) {
+    cerr << "ERROR: unable to merge read group data, different read groups" << endl;
+    exit(EXIT_FAILURE);
   }
+  for(unsigned int i=0; i<read_group_base_position_.size(); ++i)
+    read_group_base_position_[i].MergeFrom(other.ReadGroupBasePosition(i));
+  for(unsigned int i=0; i<read_group_flow_position_.size(); ++i)
+    read_group_flow_position_[i].MergeFrom(other.ReadGroupFlowPosition(i));
+  for(unsigned int i=0; i<read_group_per_hp_.size(); ++i)
+    read_group_per_hp_[i].MergeFrom(other.ReadGroupPerHp(i));
   // Regional summary data
   if(regional_summary_.size() != other.GetRegionalSummary().size()) {
     cerr << "ERROR: unable to merge regional summary data, different numbers of regions" << endl;
@@ -80,9 +80,18 @@ public:
   vector< ReadLengthHistogram > & AqHistogramBc(void) { return(aq_histogram_bc_); };
   SimpleHistogram &               BasePositionErrorCount(void) { return(base_position_error_count_); };
   PerReadFlowMatrix &             PerReadFlow(void) { return(per_read_flow_); };
-  map< string, ErrorData > &      ReadGroupBasePosition(void) { return(read_group_base_position_); };
-  map< string, ErrorData > &      ReadGroupFlowPosition(void) { return(read_group_flow_position_); };
-  map< string, HpData > &         ReadGroupPerHp(void) { return(read_group_per_hp_); };
+  // Read group data is stored densely, ReadGroupIndex() maps a read group name to its slot
+  unsigned int                    NumReadGroups(void) { return(read_group_name_.size()); };
+  const string &                  ReadGroupName(unsigned int rg_idx) { return(read_group_name_[rg_idx]); };
+  int                             ReadGroupIndex(const string &read_group) const {
+    map< string, unsigned int >::const_iterator it = read_group_idx_.find(read_group);
+    return((it == read_group_idx_.end()) ? -1 : (int)it->second);
+  };
+  ErrorData &                     ReadGroupBasePosition(unsigned int rg_idx) { return(read_group_base_position_[rg_idx]); };
+  ErrorData &                     ReadGroupFlowPosition(unsigned int rg_idx) { return(read_group_flow_position_[rg_idx]); };
+  HpData &                        ReadGroupPerHp(unsigned int rg_idx) { return(read_group_per_hp_[rg_idx]); };
+  bool                            HaveReadGroupFlowPosition(void) { return(!read_group_flow_position_.empty()); };
+  bool                            HaveReadGroupPerHp(void) { return(!read_group_per_hp_.empty()); };
   vector< RegionalSummary > &     GetRegionalSummary(void) { return(regional_summary_); };
 
   // Accessors returning copies of objects
@@ -121,13 +130,13 @@ public:
   void PerReadFlowBufferFlush(void) { per_read_flow_.FlushToH5Buffered(); };
   void PerReadFlowForcedFlush(void) { per_read_flow_.FlushToH5Forced(); };
   void PerReadFlowCloseH5(void) { per_read_flow_.CloseH5(); };
-  void AddReadGroupBasePosition(string &read_group, ReadAlignmentErrors &e) { read_group_base_position_[read_group].Add(e); };
-  void AddReadGroupFlowPosition(string &read_group, ReadAlignmentErrors &e) { read_group_flow_position_[read_group].Add(e); };
-  void AddReadGroupPerHp(string &read_group, vector<char> &ref_hp_nuc, vector<uint16_t> &ref_hp_len, vector<int16_t> &ref_hp_err, vector<uint16_t> & ref_hp_flow, vector<uint16_t> & zeromer_insertion_flow, vector<uint16_t> & zeromer_insertion_len, string &flow_order, bool ignore_terminal_hp=true) {
-    read_group_per_hp_[read_group].Add(ref_hp_nuc, ref_hp_len, ref_hp_err, ref_hp_flow, zeromer_insertion_flow, zeromer_insertion_len, flow_order, ignore_terminal_hp);
+  void AddReadGroupBasePosition(unsigned int rg_idx, ReadAlignmentErrors &e) { read_group_base_position_[rg_idx].Add(e); };
+  void AddReadGroupFlowPosition(unsigned int rg_idx, ReadAlignmentErrors &e) { read_group_flow_position_[rg_idx].Add(e); };
+  void AddReadGroupPerHp(unsigned int rg_idx, vector<char> &ref_hp_nuc, vector<uint16_t> &ref_hp_len, vector<int16_t> &ref_hp_err, vector<uint16_t> & ref_hp_flow, vector<uint16_t> & zeromer_insertion_flow, vector<uint16_t> & zeromer_insertion_len, string &flow_order, bool ignore_terminal_hp=true) {
+    read_group_per_hp_[rg_idx].Add(ref_hp_nuc, ref_hp_len, ref_hp_err, ref_hp_flow, zeromer_insertion_flow, zeromer_insertion_len, flow_order, ignore_terminal_hp);
   };
-  void AddReadGroupPerHp(string &read_group, vector<char> &ref_hp_nuc, vector<uint16_t> &ref_hp_len, vector<int16_t> &ref_hp_err, bool ignore_terminal_hp) {
-    read_group_per_hp_[read_group].Add(ref_hp_nuc, ref_hp_len, ref_hp_err, ignore_terminal_hp);
+  void AddReadGroupPerHp(unsigned int rg_idx, vector<char> &ref_hp_nuc, vector<uint16_t> &ref_hp_len, vector<int16_t> &ref_hp_err, bool ignore_terminal_hp) {
+    read_group_per_hp_[rg_idx].Add(ref_hp_nuc, ref_hp_len, ref_hp_err, ignore_terminal_hp);
   };
   void AddRegionalSummaryBasePosition(unsigned int region_idx, ReadAlignmentErrors &e) { regional_summary_[region_idx].Add(e); };
   void AddRegionalSummaryPerHp(unsigned int region_idx, vector<uint16_t> &ref_hp_len, vector<int16_t> &ref_hp_err, vector<uint16_t> &ref_hp_flow, bool ignore_terminal_hp=true) {
@@ -160,8 +169,8 @@ public:
 
   void FillBasePositionDepths(void) {
     base_position_.ComputeDepth();
-    for(map< string, ErrorData >::iterator it = read_group_base_position_.begin(); it != read_group_base_position_.end(); ++it)
-      it->second.ComputeDepth();
+    for(vector< ErrorData >::iterator it = read_group_base_position_.begin(); it != read_group_base_position_.end(); ++it)
+      it->ComputeDepth();
   }
 
   void MergeFrom(AlignmentSummary &other);
@@ -203,10 +212,12 @@ private:
   ErrorData flow_position_;
   HpData per_hp_;
   PerReadFlowMatrix per_read_flow_;
-  // Read Group per-base and per-flow error data
-  map< string, ErrorData > read_group_base_position_;
-  map< string, ErrorData > read_group_flow_position_;
-  map< string, HpData > read_group_per_hp_;
+  // Read Group per-base and per-flow error data, indexed by read group
+  vector< string > read_group_name_;
+  map< string, unsigned int > read_group_idx_;
+  vector< ErrorData > read_group_base_position_;
+  vector< ErrorData > read_group_flow_position_;
+  vector< HpData > read_group_per_hp_;
   // Regional summary data
   vector< RegionalSummary > regional_summary_;
 
@@ -0,0 +1,76 @@
+/* Copyright (C) 2013 Ion Torrent Systems, Inc. All Rights Reserved */
+#include <gtest/gtest.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include "PosteriorInference.h"
+
+using namespace std;
+
+/* A stack of reads that each clearly support the reference or the alternate allele: the log
+   posterior is a sum of logs of terms linear in the frequency, so it is concave and the
+   adaptive scan has to agree with the full scan within its error bound. */
+class ScanSpaceTest : public ::testing::Test {
+protected :
+
+  void FillStack(int num_reads, int num_alt) {
+    total_theory.my_hypotheses.resize(num_reads);
+    for (int i_read = 0; i_read < num_reads; i_read++) {
+      CrossHypotheses &my_cross = total_theory.my_hypotheses[i_read];
+      bool is_alt = i_read < num_alt;
+      my_cross.scaled_likelihood.resize(3);
+      my_cross.scaled_likelihood[0] = 1.0f;                    // outlier
+      my_cross.scaled_likelihood[1] = is_alt ? 0.05f : 1.0f;   // ref
+      my_cross.scaled_likelihood[2] = is_alt ? 1.0f : 0.05f;   // alt
+      my_cross.tmp_prob_f.resize(3);
+      my_cross.ll_scale = 0.0f;
+      my_cross.success = true;
+      my_cross.strand_key = i_read % 2;
+    }
+    total_theory.FindValidIndexes();
+
+    vector<float> hyp_freq(2);
+    hyp_freq[0] = 1.0f - (float)num_alt / num_reads;
+    hyp_freq[1] = 1.0f - hyp_freq[0];
+    clustering.SetHypFreq(hyp_freq);
+  }
+
+  // ref vs all, the same call as LatentSlate::ScanStrandPosterior
+  void Scan(ScanSpace &scan_space, float max_log_error) {
+    scan_space.max_log_error = max_log_error;
+    scan_space.DoPosteriorFrequencyScan(total_theory, clustering, true, ALL_STRAND_KEY, true);
+  }
+
+  void ExpectWithinBound(const ScanSpace &full, const ScanSpace &adaptive, float max_log_error) {
+    ASSERT_EQ(full.log_posterior_by_frequency.size(), adaptive.log_posterior_by_frequency.size());
+    for (unsigned int i_eval = 0; i_eval < full.log_posterior_by_frequency.size(); i_eval++) {
+      float depth = full.max_ll - full.log_posterior_by_frequency[i_eval];
+      float bound = max_log_error * max(1.0f, depth / 10.0f) + 0.001f;
+      EXPECT_NEAR(full.log_posterior_by_frequency[i_eval], adaptive.log_posterior_by_frequency[i_eval], bound) << "frequency index " << i_eval;
+    }
+    EXPECT_EQ(full.max_index, adaptive.max_index);
+    EXPECT_NEAR(full.max_ll, adaptive.max_ll, 0.001f);
+  }
+
+  ShortStack total_theory;
+  FreqMaster clustering;
+};
+
+TEST_F(ScanSpaceTest, AdaptiveMatchesFullScan) {
+  FillStack(400, 120);
+  ScanSpace full, adaptive;
+  Scan(full, 0.0f);
+  Scan(adaptive, 0.02f);
+  EXPECT_EQ(full.num_evaluated, (int)full.eval_at_frequency.size());
+  EXPECT_LT(adaptive.num_evaluated, full.num_evaluated);
+  ExpectWithinBound(full, adaptive, 0.02f);
+}
+
+TEST_F(ScanSpaceTest, AdaptiveMatchesFullScanWithModeAtEdge) {
+  FillStack(400, 0);
+  ScanSpace full, adaptive;
+  Scan(full, 0.0f);
+  Scan(adaptive, 0.02f);
+  EXPECT_LT(adaptive.num_evaluated, full.num_evaluated);
+  ExpectWithinBound(full, adaptive, 0.02f);
+}